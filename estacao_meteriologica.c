@@ -2,13 +2,34 @@
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "hardware/spi.h"
+#include "hardware/structs/rosc.h"
 #include "aht20.h"
 #include "bmp280.h"
 #include "ssd1306.h"
 #include "ws2812.h"
 #include "buzzer.h"
 #include <math.h>
+#include <string.h>
 #include "lora.h"
+#include "sx1276.h"
+#include "tx_policy.h"
+#include "radio_core.h"
+#include "cpu_load.h"
+#include "scheduler.h"
+#include "sample_clock.h"
+#include "boot_trace.h"
+#include "channel_plan.h"
+#include "link_frame.h"
+#include "airtime.h"
+#include "arq.h"
+#include "frag.h"
+#include "fec.h"
+#include "tdma.h"
+#include "time_sync.h"
+#include "fast_frame.h"
+#include "fsk.h"
+#include "downlink.h"
+#include "downlink_key.h"    // Chave da rede, fora do git (downlink_key.h.example)
 
 #define I2C_PORT i2c0               // i2c0 pinos 0 e 1, i2c1 pinos 2 e 3
 #define I2C_SDA 0                   // 0 ou 2
@@ -20,11 +41,72 @@
 #define I2C_SCL_DISP 15
 #define endereco 0x3C
 
-// LEDs e buzzer
+// LEDs e buzzer (o GPIO 21 é o DIO0 do módulo LoRa, então o buzzer usa o BUZZER_PIN_0)
 #define GREEN_LED 11
 #define BLUE_LED 12
 #define RED_LED 13
-#define BUZZER_PIN 21
+
+// Política de transmissão por exceção
+#define STATION_ID          0x01    // Endereço da estação no cabeçalho de enlace
+#define TX_HEARTBEAT_MS     60000   // Intervalo máximo sem transmitir
+#define TX_HYST_TEMP        0.5f    // Histerese de temperatura (C)
+#define TX_HYST_HUM         2.0f    // Histerese de umidade (%)
+#define TX_DEADBAND_TEMP    0.3f    // Banda morta de temperatura (C)
+#define TX_DEADBAND_HUM     1.5f    // Banda morta de umidade (%)
+#define TX_DEADBAND_PRESS   0.2f    // Banda morta de pressão (kPa)
+
+// Entrega confiável (ARQ de repetição seletiva)
+#define ARQ_WINDOW          4       // Quadros sem confirmação em trânsito
+#define ARQ_RETRIES_ALARM   6       // Quadros de alarme: entrega garantida
+#define ARQ_RETRIES_NORMAL  1       // Demais: uma retransmissão
+
+// 1: a entrada/saída de alarme também sai num quadro fixo do modo rápido
+// (SF6, ~18 ms no ar) antes do relatório; o receptor precisa de RX_FAST_MODE
+#define ALARM_FAST_FRAME    0
+
+// Transferências longas: despejo de diagnóstico fragmentado sobre o ARQ
+#define ARQ_RETRIES_BULK    3
+#define HISTORY_LEN         48      // Leituras guardadas (uma por relatório)
+#define DIAG_PERIOD_REPORTS 30      // Despejo a cada N relatórios
+#define DIAG_MAX_LEN        1024
+#define BULK_FEC            1       // Paridade FEC nos despejos (0: retransmissões do ARQ)
+#define FEC_BLOCK_DATA      8       // Fragmentos por bloco FEC
+#define FEC_MIN_PARITY      1       // Paridade mesmo sem perda observada
+
+// 1: os despejos saem em FSK (fsk.h), fragmentos de até 255 bytes a 250 kbps,
+// para um nó de serviço próximo (rx.c com RX_FSK_MODE); sem ARQ nem FEC
+#define BULK_FSK            0
+
+// Com TDMA_ENABLED (tdma.h) cada quadro precisa caber no slot
+#if TDMA_ENABLED
+#define BULK_MAX_FRAME      TDMA_MAX_PAYLOAD
+#else
+#define BULK_MAX_FRAME      ARQ_MAX_PAYLOAD
+#endif
+#define TDMA_QUEUE_LEAD_US  (RADIO_TX_LEAD_US + 5000)   // Quadro entregue ao core 1 antes do slot
+
+// Períodos e prazos das tarefas (us)
+#define SAMPLE_PERIOD_US    500000  // Amostragem dos sensores (timer)
+#define ACQ_DEADLINE_US     2000    // I2C da aquisição após o sinal do timer
+#define SAMPLES_PERIOD_US   100000  // Processamento das amostras da fila
+#define DISPLAY_PERIOD_US   500000  // Atualização do display
+#define RADIO_PERIOD_US     250000  // Avaliação da política de transmissão
+#define RADIO_DEADLINE_US   20000
+#define ALARM_PERIOD_US     250000  // LEDs de alarme
+#define REPORT_PERIOD_US    10000000 // Relatório de uso e estatísticas
+
+// Faixas aceitas nos comandos de downlink (fora delas o comando inteiro é recusado)
+#define CFG_TEMP_MIN_C      -40     // Faixa de medição do AHT20
+#define CFG_TEMP_MAX_C      85
+#define CFG_HUM_MIN         0
+#define CFG_HUM_MAX         100
+#define CFG_OFFSET_TEMP_C   10      // Offsets em módulo
+#define CFG_OFFSET_HUM      20
+#define CFG_OFFSET_PRESS_KPA 10
+#define CFG_SAMPLE_MIN_MS   200     // Acima da conversão do AHT20 com as consultas
+#define CFG_SAMPLE_MAX_MS   60000
+#define CFG_HEARTBEAT_MIN_S 10
+#define CFG_HEARTBEAT_MAX_S 3600
 
 typedef struct {
     float temperatura;
@@ -56,6 +138,19 @@ ConfigData config_data = {
     .offsetPress = 0
 };
 
+// Parâmetros ajustáveis pelo ar além de ConfigData
+typedef struct {
+    uint32_t sample_period_ms;
+    uint32_t heartbeat_ms;
+    int8_t tx_power_dbm;
+} station_params_t;
+
+static station_params_t station_params = {
+    .sample_period_ms = SAMPLE_PERIOD_US / 1000,
+    .heartbeat_ms = TX_HEARTBEAT_MS,
+    .tx_power_dbm = LORA_TX_POWER_MAX,      // Perfil de TX do driver: 20 dBm
+};
+
 AHT20 aht20_data = {
     .temperatura = 0,
     .umidade = 0,
@@ -66,22 +161,55 @@ BMP280 bmp280_data = {
     .pressao = 0,
 }; // Estrutura para armazenar os dados do BMP280
 
-int payload_leng = 10;  // Tamanho do payload em bytes
-int preamble_len = 8;   // Tamanho do preâmbulo em bytes
-int sf = 7;             // Fator de espalhamento (spreading factor)
-int crc = 0;            // Tamanho do CRC
-int ih = 0;             // Tamanho do cabeçalho implícito
-int bw = 125000;        // Largura de banda (bandwidth) em Hz
-int cr = 1;             // Taxa de codificação (coding rate)
-int de = 0;             // LowDataRateOptimize=1;
+static scheduler_t sched;
+static lora_dev_t radio_dev = LORA_DEV_DEFAULT;  // Acessado só pelo core 1 após o lançamento
+static ssd1306_t ssd;
+static struct bmp280_calib_param params;
+static tx_policy_t policy;
+static arq_tx_t arq;
+static frag_tx_t bulk;              // Mensagem longa em envio (fragmentos ainda não entregues ao ARQ)
+static char diag_buf[DIAG_MAX_LEN]; // Precisa ficar intacto até o último fragmento
+static uint8_t diag_id;
+static fec_tx_t fec;                // Bloco FEC em montagem (paridade dos fragmentos)
+static uint8_t fec_block_id;
+static uint8_t fec_parity;          // K escolhido pela perda observada
+static tdma_node_t tdma;            // Sincronismo pelo beacon e slot desta estação
+static uint32_t slot_busy_until;    // Fim da troca (quadro + ACK) no slot já marcado
+static link_filter_t rx_filter;     // Consultado no core 1 a cada RxDone
+static time_sync_t net_clock;       // Relógio local disciplinado pelo receptor
+static uint32_t last_sample_us;     // Aquisição da última amostra (time_us_32)
+static uint8_t fsk_frame[FSK_MAX_PAYLOAD];  // Quadro FSK montado e ainda não aceito pelo core 1
+static uint8_t fsk_frame_len;
+static uint16_t fsk_seq;
+static downlink_rx_t downlink;      // Chave e contador anti-replay dos comandos do gateway
+static ConfigData staged_config;    // Comando aceito, aplicado no início da próxima tarefa de rádio
+static station_params_t staged_params;
+static bool config_staged;
+static uint32_t cmd_applied, cmd_rejected;
+static bool cmd_nacked;             // O último comando aceito pelo MAC foi recusado (nack no status)
+
+// Histórico compacto das leituras (décimos)
+typedef struct {
+    int16_t temp;
+    uint16_t hum;
+    uint16_t press;
+} history_entry_t;
+
+static history_entry_t history[HISTORY_LEN];
+static uint8_t history_head, history_count;
+static int ch_temp, ch_hum;
+static bool radio_ok;
+static bool first_tx_done;
 
 uint8_t xcenter_pos(char *text);
 
-static void write_register(uint8_t reg, uint8_t data);
-static uint8_t read_register(uint8_t addr);
-static void cs_select();
-static void cs_deselect();
-void imprimir_binario(uint32_t valor);
+static void task_acquire(sched_task_t *t);
+static void task_samples(sched_task_t *t);
+static void task_display(sched_task_t *t);
+static void task_radio(sched_task_t *t);
+static void task_alarm(sched_task_t *t);
+static void task_report(sched_task_t *t);
+static uint32_t boot_nonce(void);
 
 // Função para calcular a altitude a partir da pressão atmosférica
 double calculate_altitude(double pressure)
@@ -98,7 +226,19 @@ void gpio_irq_handler(uint gpio, uint32_t events);
 
 int main()
 {
+    boot_trace_init();
     stdio_init_all();
+    boot_trace_mark("stdio");
+
+    // Em escuta, quadros de outras redes e estações param no cabeçalho
+    link_filter_init(&rx_filter, LINK_NET_ID, NULL);
+    link_filter_add_addr(&rx_filter, STATION_ID);
+    lora_set_rx_filter(&radio_dev, link_filter_accept, LINK_HEADER_LEN, &rx_filter);
+
+    // O rádio é inicializado no core 1 enquanto o core 0 prepara sensores e display.
+    // No TDMA e com o tempo de rede o rádio fica em RX entre as transmissões
+    // para ouvir os beacons e os quadros de tempo.
+    radio_core_launch(&radio_dev, TDMA_ENABLED || TIME_SYNC_ENABLED);
 
     gpio_init(GREEN_LED);
     gpio_set_dir(GREEN_LED, GPIO_OUT);
@@ -108,7 +248,7 @@ int main()
     gpio_set_dir(RED_LED, GPIO_OUT);
 
     // Configura o buzzer com PWM
-    buzzer_setup_pwm(BUZZER_PIN, 4000);
+    buzzer_setup_pwm(BUZZER_PIN_0, 4000);
 
     // Para ser utilizado o modo BOOTSEL com botão B
     gpio_init(BOTAO_B);
@@ -125,6 +265,7 @@ int main()
     gpio_set_dir(JOYSTICK_BUTTON, GPIO_IN);
     gpio_pull_up(JOYSTICK_BUTTON);
     gpio_set_irq_enabled_with_callback(JOYSTICK_BUTTON, GPIO_IRQ_EDGE_FALL, true, &gpio_irq_handler);
+    boot_trace_mark("gpio");
 
     PIO pio = pio0;
     uint sm = 0;
@@ -145,83 +286,555 @@ int main()
     gpio_pull_up(I2C_SDA);
     gpio_pull_up(I2C_SCL);
 
-    ssd1306_t ssd;                                                     // Inicializa a estrutura do display
     ssd1306_init(&ssd, WIDTH, HEIGHT, false, endereco, I2C_PORT_DISP); // Inicializa o display
     ssd1306_config(&ssd);                                              // Configura o display
     ssd1306_fill(&ssd, false);                                   // Limpa o display
     ssd1306_send_data(&ssd);                                           // Envia os dados para o display
+    boot_trace_mark("display");
 
     // Inicializa o BMP280
     bmp280_init(I2C_PORT);
-    struct bmp280_calib_param params;
     bmp280_get_calib_params(I2C_PORT, &params);
+    boot_trace_mark("bmp280");
 
-    // Inicializa o AHT20
+    // Inicializa o AHT20 (aht20_reset já refaz a inicialização)
     aht20_reset(I2C_PORT);
-    aht20_init(I2C_PORT);
+    boot_trace_mark("aht20");
+
+    // Aguarda o rádio LoRa no core 1 (driver, DIO0 e filas de TX/RX)
+    radio_ok = radio_core_wait_ready();
+    boot_trace_mark("radio pronto");
+
+    // Canais da política de transmissão: temperatura, umidade e pressão
+    tx_policy_init(&policy, station_params.heartbeat_ms);
+    ch_temp = tx_policy_add_channel(&policy, config_data.minTemp, config_data.maxTemp, TX_HYST_TEMP, TX_DEADBAND_TEMP);
+    ch_hum = tx_policy_add_channel(&policy, config_data.minHum, config_data.maxHum, TX_HYST_HUM, TX_DEADBAND_HUM);
+    tx_policy_add_channel(&policy, -INFINITY, INFINITY, 0, TX_DEADBAND_PRESS);
+
+    // Timeouts do ARQ a partir do tempo no ar da configuração do rádio
+    lora_modem_cfg_t modem = LORA_MODEM_CFG_DEFAULT(LORA_PREAMBLE_LEN);
+    arq_tx_init(&arq, ARQ_WINDOW, &modem);
+    fec_init();
+    tdma_node_init(&tdma, STATION_ID);
+    time_sync_init(&net_clock);
+    static const uint8_t downlink_key[DOWNLINK_KEY_LEN] = DOWNLINK_KEY;
+    downlink_rx_init(&downlink, downlink_key, boot_nonce());
+
+    // Tarefas cooperativas: cada uma com seu período e prazo
+    sched_init(&sched);
+    // Amostragem dos sensores por timer, independente da carga das tarefas; o
+    // timer só carimba e libera a tarefa esporádica que faz o I2C
+    sched_task_t *acquire = sched_add(&sched, "aquisicao", task_acquire, NULL, 0, ACQ_DEADLINE_US, 0);
+    sample_clock_start(I2C_PORT, station_params.sample_period_ms * 1000, acquire);
+    sched_add(&sched, "amostras", task_samples, NULL, SAMPLES_PERIOD_US, 0, 0);
+    sched_add(&sched, "display", task_display, NULL, DISPLAY_PERIOD_US, 0, 0);
+    sched_add(&sched, "radio", task_radio, NULL, RADIO_PERIOD_US, RADIO_DEADLINE_US, 0);
+    sched_add(&sched, "alarme", task_alarm, NULL, ALARM_PERIOD_US, 0, 0);
+    sched_add(&sched, "relatorio", task_report, NULL, REPORT_PERIOD_US, 0, REPORT_PERIOD_US);
+    boot_trace_mark("escalonador");
+
+    sched_run(&sched);
+}
 
-    // Estrutura para armazenar os dados do sensor
-    AHT20_Data data;
-    int32_t raw_temp_bmp;
-    int32_t raw_pressure;
+// Leituras no barramento pedidas pelo timer de amostragem
+static void task_acquire(sched_task_t *t) {
+    sample_clock_service();
+}
 
-    char str_aht20_temp[5];  // Buffer para armazenar a string
-    char str_aht20_hum[5];  // Buffer para armazenar a string  
-    char str_bmp280_temp[5];  // Buffer para armazenar a string
-    char str_bpm_280_press[5];  // Buffer para armazenar a string      
+// Processa as amostras adquiridas pelo timer: conversão, offsets e log
+static void task_samples(sched_task_t *t) {
+    sample_t sample;
+
+    while (sample_clock_pop(&sample)) {
+        uint64_t net_us;
+        last_sample_us = (uint32_t)sample.time_us;
+        if (time_sync_to_net(&net_clock, last_sample_us, &net_us)) {
+            printf("Amostra #%lu em %llu us (rede %llu us)\n", (unsigned long)sample.seq,
+                   (unsigned long long)sample.time_us, (unsigned long long)net_us);
+        } else {
+            printf("Amostra #%lu em %llu us\n", (unsigned long)sample.seq, (unsigned long long)sample.time_us);
+        }
 
-    bool cor = true;
-    while (true)
-    {
-        // Leitura do BMP280
-        bmp280_read_raw(I2C_PORT, &raw_temp_bmp, &raw_pressure);
-        int32_t temperature = bmp280_convert_temp(raw_temp_bmp, &params);
-        int32_t pressure = bmp280_convert_pressure(raw_pressure, raw_temp_bmp, &params);
-
-        // Cálculo da altitude
-        double altitude = calculate_altitude(pressure);
-
-        printf("Pressao = %.3f kPa\n", pressure / 1000.0);
-        printf("Temperatura BMP: = %.2f C\n", temperature / 100.0);
-        printf("Altitude estimada: %.2f m\n", altitude);
-
-        // Leitura do AHT20
-        if (aht20_read(I2C_PORT, &data))
-        {
-            printf("Temperatura AHT: %.2f C\n", data.temperature);
-            printf("Umidade: %.2f %%\n\n\n", data.humidity);
+        if (sample.bmp_ok) {
+            int32_t temperature = bmp280_convert_temp(sample.bmp_raw_temp, &params);
+            int32_t pressure = bmp280_convert_pressure(sample.bmp_raw_press, sample.bmp_raw_temp, &params);
+
+            // Cálculo da altitude
+            double altitude = calculate_altitude(pressure);
+
+            printf("Pressao = %.3f kPa\n", pressure / 1000.0);
+            printf("Temperatura BMP: = %.2f C\n", temperature / 100.0);
+            printf("Altitude estimada: %.2f m\n", altitude);
+
+            bmp280_data.temperatura = temperature / 100.0 + config_data.offsetTemp; // Aplica o offset de temperatura
+            bmp280_data.pressao = pressure / 1000.0 + config_data.offsetPress; // Aplica o offset de pressão
+        } else {
+            printf("Erro na leitura do BMP280!\n");
         }
-        else
-        {
+
+        if (sample.aht_ok) {
+            printf("Temperatura AHT: %.2f C\n", sample.aht.temperature);
+            printf("Umidade: %.2f %%\n\n\n", sample.aht.humidity);
+            aht20_data.temperatura = sample.aht.temperature + config_data.offsetTemp; // Aplica o offset de temperatura
+            aht20_data.umidade = sample.aht.humidity + config_data.offsetHum;
+        } else {
             printf("Erro na leitura do AHT10!\n\n\n");
         }
+    }
+}
+
+// Atualiza o conteúdo do display
+static void task_display(sched_task_t *t) {
+    char str_aht20_temp[8];     // Buffer para armazenar a string
+    char str_aht20_hum[8];      // Buffer para armazenar a string
+    char str_bmp280_temp[8];    // Buffer para armazenar a string
+    char str_bpm_280_press[12]; // Buffer para armazenar a string
+    bool cor = true;
 
-        aht20_data.temperatura = data.temperature + config_data.offsetTemp; // Aplica o offset de temperatura
-        aht20_data.umidade = data.humidity + config_data.offsetHum;
+    sprintf(str_aht20_temp, "%.1fC", aht20_data.temperatura);  // Temperatura do AHT20
+    sprintf(str_aht20_hum, "%.1f%%", aht20_data.umidade);  // Umidade do AHT20
+    sprintf(str_bmp280_temp, "%.1fC", bmp280_data.temperatura);  // Temperatura do BMP280
+    sprintf(str_bpm_280_press, "%.1fhPa", bmp280_data.pressao);  // Pressão do BMP280
 
-        bmp280_data.temperatura = temperature / 100.0 + config_data.offsetTemp; // Aplica o offset de temperatura
-        bmp280_data.pressao = pressure / 1000.0 + config_data.offsetPress; // Aplica o offset de pressão
+    ssd1306_fill(&ssd, !cor);                           // Limpa o display
+    ssd1306_rect(&ssd, 3, 3, 122, 60, cor, !cor);       // Desenha um retângulo
 
-        sprintf(str_aht20_temp, "%.1fC", aht20_data.temperatura);  // Temperatura do AHT20
-        sprintf(str_aht20_hum, "%.1f%%", aht20_data.umidade);  // Umidade do AHT20
-        sprintf(str_bmp280_temp, "%.1fC", bmp280_data.temperatura);  // Temperatura do BMP280
-        sprintf(str_bpm_280_press, "%.1fhPa", bmp280_data.pressao);  // Pressão do BMP280
+    ssd1306_draw_string(&ssd, "AHT20 & BMP280", xcenter_pos("AHT20 & BMP280"), 10); // Desenha uma string
 
-        //  Atualiza o conteúdo do display com animações
-        ssd1306_fill(&ssd, !cor);                           // Limpa o display
-        ssd1306_rect(&ssd, 3, 3, 122, 60, cor, !cor);       // Desenha um retângulo
+    ssd1306_line(&ssd, 63, 41, 63, 60, cor);            // Desenha uma linha vertical
+    ssd1306_draw_string(&ssd, str_aht20_temp, 14, 41);  // Temperatura AHT20
+    ssd1306_draw_string(&ssd, str_aht20_hum, 14, 52);   // Umidade AHT20
+    ssd1306_draw_string(&ssd, str_bmp280_temp, 73, 41); // Temperatura BMP280
+    ssd1306_draw_string(&ssd, str_bpm_280_press, 73, 52); // Pressão BMP280
 
-        ssd1306_draw_string(&ssd, "AHT20 & BMP280", xcenter_pos("AHT20 & BMP280"), 10); // Desenha uma string
+    ssd1306_send_data(&ssd);                            // Atualiza o display
+}
+
+// Próximo quadro da mensagem longa: fragmento puro ou, com FEC, os N
+// fragmentos de cada bloco seguidos das K paridades. Retorna 0 ao terminar.
+static size_t bulk_next_frame(uint8_t *out) {
+    if (!BULK_FEC) {
+        return frag_tx_next(&bulk, out);
+    }
+    if (fec_tx_data_done(&fec)) {
+        if (!fec_tx_done(&fec)) {
+            return fec_tx_next_parity(&fec, out);
+        }
+        if (frag_tx_done(&bulk)) {
+            return 0;
+        }
+        uint8_t left = bulk.count - bulk.next;
+        fec_tx_begin(&fec, fec_block_id++, left < FEC_BLOCK_DATA ? left : FEC_BLOCK_DATA, fec_parity);
+    }
+    uint8_t frag[FEC_MAX_DATA_LEN];
+    size_t frag_len = frag_tx_next(&bulk, frag);
+    return fec_tx_add(&fec, frag, frag_len, out);
+}
 
-        ssd1306_line(&ssd, 63, 41, 63, 60, cor);            // Desenha uma linha vertical
-        ssd1306_draw_string(&ssd, str_aht20_temp, 14, 41);  // Temperatura AHT20
-        ssd1306_draw_string(&ssd, str_aht20_hum, 14, 52);   // Umidade AHT20
-        ssd1306_draw_string(&ssd, str_bmp280_temp, 73, 41); // Temperatura BMP280
-        ssd1306_draw_string(&ssd, str_bpm_280_press, 73, 52); // Pressão BMP280
-        
-        ssd1306_send_data(&ssd);                            // Atualiza o display
+static bool bulk_done(void) {
+    if (BULK_FSK) {
+        return frag_tx_done(&bulk) && fsk_frame_len == 0;
+    }
+    return frag_tx_done(&bulk) && (!BULK_FEC || fec_tx_done(&fec));
+}
 
-        sleep_ms(500);
+// Nonce de boot do downlink: bits do oscilador em anel, nunca 0 (o gateway
+// usa 0 para "ainda não anunciado")
+static uint32_t boot_nonce(void) {
+    uint32_t nonce = 0;
+    while (nonce == 0) {
+        for (int i = 0; i < 32; i++) {
+            nonce = (nonce << 1) | (rosc_hw->randombit & 1);
+        }
+    }
+    return nonce;
+}
+
+// Faixa de cada TLV nas unidades do comando (centésimos, ms, s, dBm),
+// conferida antes da conversão
+static const struct {
+    int32_t min, max;
+} cmd_range[DOWNLINK_NUM_TLVS] = {
+    [DOWNLINK_MIN_TEMP]      = { CFG_TEMP_MIN_C * 100, CFG_TEMP_MAX_C * 100 },
+    [DOWNLINK_MAX_TEMP]      = { CFG_TEMP_MIN_C * 100, CFG_TEMP_MAX_C * 100 },
+    [DOWNLINK_MIN_HUM]       = { CFG_HUM_MIN * 100, CFG_HUM_MAX * 100 },
+    [DOWNLINK_MAX_HUM]       = { CFG_HUM_MIN * 100, CFG_HUM_MAX * 100 },
+    [DOWNLINK_OFFSET_TEMP]   = { -CFG_OFFSET_TEMP_C * 100, CFG_OFFSET_TEMP_C * 100 },
+    [DOWNLINK_OFFSET_HUM]    = { -CFG_OFFSET_HUM * 100, CFG_OFFSET_HUM * 100 },
+    [DOWNLINK_OFFSET_PRESS]  = { -CFG_OFFSET_PRESS_KPA * 100, CFG_OFFSET_PRESS_KPA * 100 },
+    [DOWNLINK_SAMPLE_PERIOD] = { CFG_SAMPLE_MIN_MS, CFG_SAMPLE_MAX_MS },
+    [DOWNLINK_HEARTBEAT]     = { CFG_HEARTBEAT_MIN_S, CFG_HEARTBEAT_MAX_S },
+    [DOWNLINK_TX_POWER]      = { LORA_TX_POWER_MIN, LORA_TX_POWER_MAX },
+};
+
+// Comando autenticado do gateway: cada campo conferido na sua faixa e
+// aplicado sobre a configuração vigente (ou a já pendente); só fica pendente
+// se tudo for válido. Recusado, o status do uplink leva o nack para o gateway.
+static void stage_command(const downlink_cmd_t *cmd) {
+    ConfigData c = config_staged ? staged_config : config_data;
+    station_params_t p = config_staged ? staged_params : station_params;
+    float *limits[] = { &c.minTemp, &c.maxTemp, &c.minHum, &c.maxHum, &c.offsetTemp, &c.offsetHum, &c.offsetPress };
+
+    for (int i = 0; i < DOWNLINK_NUM_TLVS; i++) {
+        if ((cmd->present & (1u << i)) &&
+            (cmd->value[i] < cmd_range[i].min || cmd->value[i] > cmd_range[i].max)) {
+            cmd_rejected++;
+            cmd_nacked = true;
+            printf("Comando %lu recusado: campo %d = %ld fora de %ld..%ld\n", (unsigned long)cmd->counter, i,
+                   (long)cmd->value[i], (long)cmd_range[i].min, (long)cmd_range[i].max);
+            return;
+        }
+    }
+
+    for (int i = DOWNLINK_MIN_TEMP; i <= DOWNLINK_OFFSET_PRESS; i++) {
+        if (cmd->present & (1u << i)) {
+            *limits[i - DOWNLINK_MIN_TEMP] = cmd->value[i] / 100.0f;
+        }
+    }
+    if (cmd->present & (1u << DOWNLINK_SAMPLE_PERIOD)) {
+        p.sample_period_ms = (uint32_t)cmd->value[DOWNLINK_SAMPLE_PERIOD];
+    }
+    if (cmd->present & (1u << DOWNLINK_HEARTBEAT)) {
+        p.heartbeat_ms = (uint32_t)cmd->value[DOWNLINK_HEARTBEAT] * 1000;
+    }
+    if (cmd->present & (1u << DOWNLINK_TX_POWER)) {
+        p.tx_power_dbm = (int8_t)cmd->value[DOWNLINK_TX_POWER];
+    }
+
+    // Campos válidos um a um ainda podem deixar limites invertidos
+    if (c.minTemp >= c.maxTemp || c.minHum >= c.maxHum) {
+        cmd_rejected++;
+        cmd_nacked = true;
+        printf("Comando %lu recusado: limite minimo acima do maximo\n", (unsigned long)cmd->counter);
+        return;
+    }
+    staged_config = c;
+    staged_params = p;
+    config_staged = true;
+    cmd_nacked = false;
+}
+
+// Entre execuções das tarefas: nenhuma vê a configuração pela metade
+static void apply_staged_config(void) {
+    if (!config_staged) {
+        return;
+    }
+    config_staged = false;
+    config_data = staged_config;
+    if (staged_params.sample_period_ms != station_params.sample_period_ms) {
+        sample_clock_set_period(staged_params.sample_period_ms * 1000);
+    }
+    if (staged_params.heartbeat_ms != station_params.heartbeat_ms) {
+        tx_policy_set_heartbeat(&policy, staged_params.heartbeat_ms);
+    }
+    if (staged_params.tx_power_dbm != station_params.tx_power_dbm) {
+        radio_core_set_tx_power(staged_params.tx_power_dbm);
+    }
+    station_params = staged_params;
+    cmd_applied++;
+    printf("Configuracao %lu aplicada: T %.2f..%.2f, U %.2f..%.2f, offsets %.2f/%.2f/%.2f, "
+           "amostragem %lu ms, heartbeat %lu s, potencia %d dBm\n",
+           (unsigned long)downlink.last_counter, config_data.minTemp, config_data.maxTemp,
+           config_data.minHum, config_data.maxHum, config_data.offsetTemp, config_data.offsetHum,
+           config_data.offsetPress, (unsigned long)station_params.sample_period_ms,
+           (unsigned long)(station_params.heartbeat_ms / 1000), station_params.tx_power_dbm);
+}
+
+static void on_downlink(const uint8_t *data, size_t len) {
+    downlink_cmd_t cmd;
+    downlink_result_t r = downlink_rx_on_frame(&downlink, LINK_NET_ID, STATION_ID, data, len, &cmd);
+    if (r == DOWNLINK_OK) {
+        stage_command(&cmd);
+    } else if (r != DOWNLINK_DUPLICATE) {
+        // Repetição do mesmo comando é normal até o gateway ver o status no uplink
+        printf("Comando de downlink descartado (%s)\n",
+               r == DOWNLINK_REPLAY ? "contador antigo" : r == DOWNLINK_BAD_MAC ? "MAC invalido" : "malformado");
+    }
+}
+
+// Transmite somente quando a política indicar (alarme, banda morta ou heartbeat)
+static void task_radio(sched_task_t *t) {
+    char message[TDMA_MAX_PAYLOAD];     // Texto, '\0' e status do downlink
+    const size_t text_max = sizeof(message) - DOWNLINK_STATUS_LEN;
+    uint8_t frame[LINK_HEADER_LEN + ARQ_MAX_PAYLOAD];
+    radio_msg_t radio_evt;
+
+    apply_staged_config();
+    tx_policy_set_limits(&policy, ch_temp, config_data.minTemp, config_data.maxTemp);
+    tx_policy_set_limits(&policy, ch_hum, config_data.minHum, config_data.maxHum);
+
+    float values[] = { aht20_data.temperatura, aht20_data.umidade, bmp280_data.pressao };
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    uint8_t reasons = tx_policy_evaluate(&policy, values, now_ms);
+
+    if (reasons && radio_ok) {
+        int n = snprintf(message, text_max, "T=%.1f;U=%.1f;P=%.1f;R=%02X",
+                         values[0], values[1], values[2], reasons);
+        // Instante da amostra no tempo de rede: alinha as estações e dá ao
+        // receptor a latência da amostra até a entrega
+        uint64_t net_us;
+        if (time_sync_to_net(&net_clock, last_sample_us, &net_us)) {
+            snprintf(message + n, text_max - n, ";N=%lu", (unsigned long)(uint32_t)net_us);
+        }
+        // Depois do texto e do '\0', o status assinado do downlink: nonce de
+        // boot e último comando aceito (ou recusado pelas faixas CFG_*). O
+        // gateway assina os comandos com o nonce e vê a entrega pelo contador.
+        size_t len = strlen(message) + 1;
+        downlink_status_t status = { .nonce = downlink.nonce, .counter = downlink.last_counter,
+                                     .nacked = cmd_nacked };
+        len += downlink_status_build(downlink.key, LINK_NET_ID, STATION_ID, &status, (uint8_t*)message + len);
+        uint8_t retries = (reasons & TX_REASON_ALARM) ? ARQ_RETRIES_ALARM : ARQ_RETRIES_NORMAL;
+        if (arq_tx_submit(&arq, (uint8_t*)message, len, retries, LINK_FRAME_DATA)) {
+            tx_policy_mark_sent(&policy, values, reasons, now_ms);
+            printf("Pacote enfileirado (motivo 0x%02X): '%s'\n", reasons, message);
+
+            if (ALARM_FAST_FRAME && (reasons & TX_REASON_ALARM)) {
+                // Enfileirado agora, sai antes do quadro do ARQ (que só vai
+                // ao core 1 no arq_tx_poll abaixo)
+                static uint8_t fast_seq;
+                fast_frame_t alarm;
+                uint8_t fast[FAST_FRAME_LEN];
+                fast_frame_alarm(&alarm, LINK_NET_ID, STATION_ID, fast_seq++, reasons, values[0], values[1]);
+                fast_frame_encode(&alarm, fast);
+                radio_core_send(fast, FAST_FRAME_LEN, RADIO_TX_FAST);
+            }
+        }
+    }
+
+    // Fragmentos da mensagem longa ocupam a janela do ARQ, mas sempre deixam
+    // uma posição livre para as medições
+    uint8_t bulk_frame[ARQ_MAX_PAYLOAD];
+    while (!BULK_FSK && radio_ok && arq_tx_pending(&arq) < ARQ_WINDOW - 1) {
+        size_t bulk_len = bulk_next_frame(bulk_frame);
+        if (bulk_len == 0) {
+            break;
+        }
+        // Com FEC a paridade cobre as perdas: sem retransmissões
+        if (BULK_FEC) {
+            arq_tx_submit(&arq, bulk_frame, (uint8_t)bulk_len, 0, LINK_FRAME_FEC);
+        } else {
+            arq_tx_submit(&arq, bulk_frame, (uint8_t)bulk_len, ARQ_RETRIES_BULK, LINK_FRAME_FRAG);
+        }
+    }
+
+    // Em FSK os fragmentos vão direto para a fila do core 1, que os transmite
+    // em sequência sem voltar ao LoRa; com a fila cheia o quadro espera aqui
+    while (BULK_FSK && radio_ok) {
+        if (fsk_frame_len == 0) {
+            uint8_t frag[FSK_MAX_PAYLOAD - LINK_HEADER_LEN];
+            size_t frag_len = frag_tx_next(&bulk, frag);
+            if (frag_len == 0) {
+                break;
+            }
+            link_header_t hdr = {
+                .net_id = LINK_NET_ID, .src = STATION_ID, .dst = LINK_ADDR_GATEWAY,
+                .seq = fsk_seq++, .type = LINK_FRAME_FRAG, .flags = 0
+            };
+            fsk_frame_len = (uint8_t)link_frame_encode(&hdr, frag, frag_len, fsk_frame, sizeof(fsk_frame));
+        }
+        if (!radio_core_send(fsk_frame, fsk_frame_len, RADIO_TX_FSK)) {
+            break;
+        }
+        fsk_frame_len = 0;
+    }
+
+    // Eventos vindos do core 1 antes do próximo quadro: o ACK que já chegou
+    // evita uma retransmissão desnecessária
+    while (radio_core_poll(&radio_evt)) {
+        if (radio_evt.type == RADIO_MSG_TX_DONE) {
+            boot_trace_mark_once("primeiro quadro TX", &first_tx_done);
+            printf("Pacote transmitido!\n");
+        } else if (radio_evt.type == RADIO_MSG_ERROR) {
+            printf("Falha na troca de modem do radio\n");
+        } else if (radio_evt.type == RADIO_MSG_RX) {
+            link_header_t hdr;
+            const uint8_t *payload;
+            int payload_len = link_frame_decode(radio_evt.data, radio_evt.len, &hdr, &payload);
+            if (payload_len >= 0 && hdr.type == LINK_FRAME_ACK && hdr.dst == STATION_ID) {
+                arq_tx_on_ack(&arq, payload, (size_t)payload_len);
+            } else if (DOWNLINK_ENABLED && payload_len >= ARQ_ACK_LEN && hdr.type == LINK_FRAME_CMD &&
+                       hdr.dst == STATION_ID && hdr.src == LINK_ADDR_GATEWAY) {
+                // Comando na janela do ACK: os bytes do ACK vêm primeiro
+                arq_tx_on_ack(&arq, payload, ARQ_ACK_LEN);
+                on_downlink(payload + ARQ_ACK_LEN, (size_t)payload_len - ARQ_ACK_LEN);
+            } else if (payload_len >= 0 && hdr.type == LINK_FRAME_BEACON && hdr.src == LINK_ADDR_GATEWAY) {
+                // Início do beacon: RxDone carimbado no ISR menos o tempo no ar
+                uint32_t start_us = radio_evt.time_us - lora_airtime_us(&arq.modem, radio_evt.len);
+                tdma_node_on_beacon(&tdma, payload, (size_t)payload_len, start_us);
+            } else if (payload_len >= 0 && hdr.type == LINK_FRAME_TIME && hdr.src == LINK_ADDR_GATEWAY) {
+                // O carimbo do RxDone é do ISR do core 1; o receptor marcou o início do TX
+                uint32_t start_us = radio_evt.time_us - lora_airtime_us(&arq.modem, radio_evt.len);
+                time_sync_on_frame(&net_clock, payload, (size_t)payload_len, start_us);
+            }
+        }
+    }
+
+    // Um quadro por execução: retransmissão vencida ou o próximo da janela.
+    // A sequência do ARQ vai no cabeçalho de enlace e o rádio escuta o ACK
+    // logo após o TX. No TDMA, um quadro por ciclo, no slot da estação.
+    uint32_t now_us = time_us_32();
+    uint32_t slot_us = 0;
+    bool may_send = radio_ok;
+    if (TDMA_ENABLED) {
+        may_send = may_send && (int32_t)(now_us - slot_busy_until) >= 0 &&
+                   tdma_node_next_slot(&tdma, now_us, TDMA_QUEUE_LEAD_US, &slot_us);
+    }
+    uint16_t seq;
+    bool retry;
+    const uint8_t *data;
+    uint8_t type;
+    int len = may_send ? arq_tx_poll(&arq, now_us, &seq, &retry, &data, &type) : -1;
+    if (len >= 0) {
+        link_header_t hdr = {
+            .net_id = LINK_NET_ID, .src = STATION_ID, .dst = LINK_ADDR_GATEWAY, .seq = seq,
+            .type = type,
+            .flags = LINK_FLAG_ACK_REQ | (retry ? LINK_FLAG_RETRY : 0) | (arq_tx_syn(&arq) ? LINK_FLAG_SYN : 0)
+        };
+        size_t frame_len = link_frame_encode(&hdr, data, (size_t)len, frame, sizeof(frame));
+        if (TDMA_ENABLED) {
+            radio_core_send_at(frame, (uint8_t)frame_len, RADIO_TX_ACK_SLOT, slot_us);
+            slot_busy_until = slot_us + tdma.map.slot_us;
+        } else {
+            radio_core_send(frame, (uint8_t)frame_len, RADIO_TX_ACK_SLOT);
+        }
+    }
+}
+
+// LED RGB: verde com valores normais, vermelho fora dos limites
+static void task_alarm(sched_task_t *t) {
+    bool alarm = tx_policy_in_alarm(&policy);
+    gpio_put(GREEN_LED, !alarm);
+    gpio_put(RED_LED, alarm);
+}
+
+static void history_add(void) {
+    history_entry_t *e = &history[history_head];
+    e->temp = (int16_t)lroundf(aht20_data.temperatura * 10);
+    e->hum = (uint16_t)lroundf(aht20_data.umidade * 10);
+    e->press = (uint16_t)lroundf(bmp280_data.pressao * 10);
+    history_head = (history_head + 1) % HISTORY_LEN;
+    if (history_count < HISTORY_LEN) {
+        history_count++;
+    }
+}
+
+// Despejo de diagnóstico (contadores + histórico, do mais antigo ao mais
+// recente) enviado em fragmentos pelo ARQ
+static void diag_dump_start(void) {
+    radio_core_stats_t radio;
+    radio_core_get_stats(&radio);
+    int n = snprintf(diag_buf, sizeof(diag_buf),
+                     "DIAG up=%lus tx=%lu arq=%lu/%lu retx=%lu cad=%lu\nHIST %us T;U;P\n",
+                     (unsigned long)(to_ms_since_boot(get_absolute_time()) / 1000),
+                     (unsigned long)radio.tx_done, (unsigned long)arq.stats.delivered,
+                     (unsigned long)arq.stats.submitted, (unsigned long)arq.stats.retransmissions,
+                     (unsigned long)radio.cad_busy, (unsigned)(REPORT_PERIOD_US / 1000000));
+    for (uint8_t i = 0; i < history_count && n < (int)sizeof(diag_buf); i++) {
+        const history_entry_t *e = &history[(history_head + HISTORY_LEN - history_count + i) % HISTORY_LEN];
+        n += snprintf(diag_buf + n, sizeof(diag_buf) - n, "%.1f;%.1f;%.1f\n",
+                      e->temp / 10.0, e->hum / 10.0, e->press / 10.0);
+    }
+    if (n >= (int)sizeof(diag_buf)) {
+        n = sizeof(diag_buf) - 1;
+    }
+    size_t max_frag_len = BULK_FEC ? BULK_MAX_FRAME - (ARQ_MAX_PAYLOAD - FEC_MAX_DATA_LEN) : BULK_MAX_FRAME;
+    if (BULK_FSK) {
+        max_frag_len = FSK_MAX_PAYLOAD - LINK_HEADER_LEN;
+    }
+    int count = frag_tx_begin(&bulk, diag_id++, (const uint8_t *)diag_buf, (size_t)n, max_frag_len);
+
+    // Paridade pela perda vista pelo ARQ desde o último despejo (quadros sem
+    // ACK, então inclui ACKs perdidos: estimativa conservadora)
+    static uint32_t last_tx, last_delivered;
+    uint32_t tx = arq.stats.transmissions - last_tx;
+    uint32_t ok = arq.stats.delivered - last_delivered;
+    last_tx = arq.stats.transmissions;
+    last_delivered = arq.stats.delivered;
+    uint8_t loss = (tx == 0 || ok >= tx) ? 0 : (uint8_t)(100 - ok * 100 / tx);
+    fec_parity = fec_parity_for_loss(FEC_BLOCK_DATA, loss, FEC_MAX_PARITY);
+    if (fec_parity < FEC_MIN_PARITY) {
+        fec_parity = FEC_MIN_PARITY;
+    }
+    printf("Despejo de diagnostico: %d bytes em %d fragmentos (perda %u%%, paridade %u por bloco)\n",
+           n, count, loss, (BULK_FEC && !BULK_FSK) ? fec_parity : 0);
+}
+
+// Relatório periódico de uso dos núcleos e estatísticas das tarefas
+static void task_report(sched_task_t *t) {
+    static bool boot_printed = false;
+    static uint32_t reports = 0;
+    if (!boot_printed) {
+        boot_printed = true;
+        boot_trace_print();
+    }
+
+    history_add();
+    if (radio_ok && ++reports % DIAG_PERIOD_REPORTS == 0 && bulk_done()) {
+        diag_dump_start();
+    }
+
+    cpu_load_t load0, load1;
+    cpu_load_sample(0, &load0);
+    cpu_load_sample(1, &load1);
+    printf("Uso dos nucleos: core0 %u%%, core1 %u%%\n", load0.busy_percent, load1.busy_percent);
+    sched_print_stats(&sched);
+    sample_clock_print_stats();
+
+    lora_spi_stats_t spi;
+    lora_get_spi_stats(&radio_dev, &spi);
+    printf("SPI radio: %lu escritas (%lu omitidas), %lu rajadas, %lu leituras (%lu da copia sombra), %lu bytes da FIFO\n",
+           (unsigned long)spi.writes, (unsigned long)spi.skipped_writes, (unsigned long)spi.bursts,
+           (unsigned long)spi.reads, (unsigned long)spi.cached_reads, (unsigned long)spi.fifo_read_bytes);
+    printf("Filtro de RX: %lu aceitos, %lu de outra rede, %lu para outro destino\n",
+           (unsigned long)rx_filter.accepted, (unsigned long)rx_filter.foreign_net,
+           (unsigned long)rx_filter.other_dst);
+
+    radio_core_stats_t radio;
+    radio_core_get_stats(&radio);
+    printf("Radio: %lu enviados (%lu no modo rapido, %lu em FSK em %lu trocas), %lu descartados, "
+           "canal ocupado %lu vezes (%lu forcados), %lu recebidos (%lu sobrescritos na FIFO)\n",
+           (unsigned long)radio.tx_done, (unsigned long)radio.fast_tx, (unsigned long)radio.fsk_tx,
+           (unsigned long)radio.fsk_switches, (unsigned long)radio.tx_dropped,
+           (unsigned long)radio.cad_busy, (unsigned long)radio.lbt_forced,
+           (unsigned long)radio.rx_frames, (unsigned long)radio.rx_overruns);
+    printf("ARQ: %lu confirmados, %lu expirados, %lu retransmissoes, %lu ACKs em %lu janelas; goodput %lu de %lu bytes\n",
+           (unsigned long)arq.stats.delivered, (unsigned long)arq.stats.expired,
+           (unsigned long)arq.stats.retransmissions, (unsigned long)radio.ack_slot_rx,
+           (unsigned long)radio.ack_slots, (unsigned long)arq.stats.payload_bytes,
+           (unsigned long)arq.stats.air_bytes);
+
+    if (DOWNLINK_ENABLED) {
+        uint32_t window_limit_us = arq_ack_slot_us(&arq.modem) + downlink_window_extra_us(&arq.modem);
+        printf("Downlink: %lu comandos aceitos (%lu aplicados, %lu recusados), %lu repetidos, %lu contadores antigos, "
+               "%lu MAC invalido, %lu malformados; RX apos o uplink %lu ms no total, max %lu us (limite %lu us)\n",
+               (unsigned long)downlink.accepted, (unsigned long)cmd_applied, (unsigned long)cmd_rejected,
+               (unsigned long)downlink.duplicates, (unsigned long)downlink.replays,
+               (unsigned long)downlink.bad_mac, (unsigned long)downlink.malformed,
+               (unsigned long)(radio.ack_slot_total_us / 1000), (unsigned long)radio.ack_slot_max_us,
+               (unsigned long)window_limit_us);
+    }
+
+    if (TIME_SYNC_ENABLED) {
+        printf("Tempo de rede: %s, %lu quadros, erro %ld us (max %lu us), deriva %.2f ppm, "
+               "%lu descartados, %lu reinicios\n",
+               net_clock.synced ? "sincronizado" : "sem referencia", (unsigned long)net_clock.samples,
+               (long)net_clock.last_error_us, (unsigned long)net_clock.max_error_us, net_clock.drift_ppb / 1000.0,
+               (unsigned long)net_clock.outliers, (unsigned long)net_clock.resets);
+    }
+
+    if (TDMA_ENABLED) {
+        printf("TDMA: %s, slot %u de %u, %lu beacons, %lu perdas de sincronismo, %lu quadros no slot "
+               "(%lu fora do prazo, atraso max %lu us)\n",
+               tdma.synced ? "sincronizada" : "sem beacon", tdma.own_slot, tdma.map.num_slots,
+               (unsigned long)tdma.beacons, (unsigned long)tdma.lost_sync, (unsigned long)radio.slot_tx,
+               (unsigned long)radio.slot_missed, (unsigned long)radio.slot_late_max_us);
+    }
+
+    if (fhss_enabled(&radio_dev)) {
+        fhss_stats_t hop;
+        fhss_get_stats(&radio_dev, &hop);
+        printf("FHSS: %lu saltos, canal atual %u (%lu Hz)\n", (unsigned long)hop.hops,
+               hop.current, (unsigned long)channel_plan_freq_hz(hop.current));
     }
 }
 
@@ -263,74 +876,3 @@ void gpio_irq_handler(uint gpio, uint32_t events) {
     // }
     
 }
-
-
-// Definir frequência de operação
-void set_frequency(double frequency) {
-    unsigned long frequency_value;
-
-    printf("Frequência escolhida %.3f Mhz\n", frequency);
-
-    frequency = frequency * 7110656 / 434;
-
-    frequency_value = (unsigned long)frequency;
-    printf("Frequência calculada para ajuste dos registradores: %lu\n", frequency_value);
-
-    write_register(REG_FRF_MSB, (frequency_value >> 16) & 0xFF); // Configura o registrador MSB
-    write_register(REG_FRF_MID, (frequency_value >> 8) & 0xFF);  // Configura o registrador MID
-    write_register(REG_FRF_LSB, frequency_value & 0xFF);       // Configura o registrador LSB
-
-    printf("Impressão de valor binário da frequência:\n");
-    imprimir_binario(frequency_value); // Imprimir o valor binário de 32 bits
-    printf("\n");
-
-    printf("Frequ. Regs. config:\n");
-    read_register(REG_FRF_MSB);
-    read_register(REG_FRF_MID);
-    read_register(REG_FRF_LSB);
-}
-
-#define SPI_PORT spi0 // Definindo o SPI a ser utilizado
-
-static void write_register(uint8_t reg, uint8_t data) {
-    uint8_t buffer[2];
-    buffer[0] = reg | 0x80; // Set the write bit
-    buffer[1] = data;
-
-    cs_select(); // Iniciar comunicação SPI
-    spi_write_blocking(SPI_PORT, buffer, 2); // Envia o registr
-    cs_deselect(); // Finalizar comunicação SPI
-
-    sleep_ms(1); // Atraso para garantir que o registrador foi escrito corretamente
-}
-
-static uint8_t read_register(uint8_t addr) {
-    uint8_t buf[1];
-
-    addr &= 0x7F;
-
-    cs_select(); // Iniciar comunicação SPI
-    spi_write_blocking(SPI_PORT, &addr, 1); // Envia o endereço do registrador
-    sleep_ms(1); // Atraso para garantir que o registrador foi lido corretamente
-    spi_read_blocking(SPI_PORT, 0, buf, 1);
-    cs_deselect(); // Finalizar comunicação SPI
-
-    sleep_ms(1); // Atraso para garantir que o registrador foi lido corretamente
-
-    printf("READ %02X: ", buf[0]);
-    return buf[0];
-}
-
-static void cs_select() {
-    gpio_put(PICO_DEFAULT_SPI_CSN_PIN, 0); // Ativa o chip select
-}
-
-static void cs_deselect() {
-    gpio_put(PICO_DEFAULT_SPI_CSN_PIN, 1); // Desativa o chip select
-}
-
-void imprimir_binario(uint32_t valor) {
-    for (int i = 31; i >= 0; i--) {
-        printf("%d", (valor >> i) & 1);
-    }
-}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "channel_plan.h"
+#include "afc.h"
+
+#define AFC_FILTER_WEIGHT   0.125f  // Peso da média móvel do desvio
+#define AFC_FORGET          0.97f   // Esquecimento do modelo de temperatura por amostra
+
+static lora_dev_t *radio;       // Rádio cujo FRF é corrigido
+static afc_peer_t peers[AFC_MAX_PEERS];
+static uint32_t last_retune_ms;
+static uint32_t retunes;
+
+void afc_init(lora_dev_t *dev) {
+    radio = dev;
+    for (int i = 0; i < AFC_MAX_PEERS; i++) {
+        peers[i].used = false;
+    }
+    last_retune_ms = 0;
+    retunes = 0;
+}
+
+static afc_peer_t *find_peer(uint16_t sender) {
+    for (int i = 0; i < AFC_MAX_PEERS; i++) {
+        if (peers[i].used && peers[i].id == sender) {
+            return &peers[i];
+        }
+    }
+    return NULL;
+}
+
+static afc_peer_t *alloc_peer(uint16_t sender, uint32_t now_ms) {
+    afc_peer_t *victim = &peers[0];
+    for (int i = 0; i < AFC_MAX_PEERS; i++) {
+        if (!peers[i].used) {
+            victim = &peers[i];
+            break;
+        }
+        if (now_ms - peers[i].last_ms > now_ms - victim->last_ms) {
+            victim = &peers[i];
+        }
+    }
+    *victim = (afc_peer_t){ .id = sender, .used = true, .temp_c = NAN };
+    return victim;
+}
+
+void afc_update(uint16_t sender, int32_t freq_error_hz, float temp_c, uint32_t now_ms) {
+    afc_peer_t *p = find_peer(sender);
+    if (!p) {
+        p = alloc_peer(sender, now_ms);
+    }
+
+    // O erro medido é relativo ao FRF atual do receptor (positivo: remetente
+    // acima). Somando a correção local o desvio fica absoluto e não muda
+    // quando o receptor reajusta
+    float offset = (float)(freq_error_hz + channel_plan_get_correction(radio));
+
+    if (p->samples == 0) {
+        p->offset_hz = offset;
+    } else {
+        p->offset_hz += AFC_FILTER_WEIGHT * (offset - p->offset_hz);
+    }
+    if (p->samples < UINT16_MAX) {
+        p->samples++;
+    }
+    p->last_ms = now_ms;
+
+    if (!isnan(temp_c)) {
+        p->temp_c = temp_c;
+        p->sw  = p->sw  * AFC_FORGET + 1.0f;
+        p->st  = p->st  * AFC_FORGET + temp_c;
+        p->so  = p->so  * AFC_FORGET + offset;
+        p->stt = p->stt * AFC_FORGET + temp_c * temp_c;
+        p->sto = p->sto * AFC_FORGET + temp_c * offset;
+    }
+}
+
+// Variância ponderada da temperatura e inclinação do modelo linear
+static bool peer_slope(const afc_peer_t *p, float *slope) {
+    if (p->sw < AFC_MIN_SAMPLES) {
+        return false;
+    }
+    float mean_t = p->st / p->sw;
+    float var_t = p->stt / p->sw - mean_t * mean_t;
+    // Faixa mínima de temperatura para a inclinação não ser só ruído
+    if (var_t < (AFC_MIN_TEMP_SPREAD * AFC_MIN_TEMP_SPREAD) / 4.0f) {
+        return false;
+    }
+    *slope = (p->sto / p->sw - mean_t * (p->so / p->sw)) / var_t;
+    return true;
+}
+
+bool afc_sender_slope(uint16_t sender, float *hz_per_c) {
+    const afc_peer_t *p = find_peer(sender);
+    return p && peer_slope(p, hz_per_c);
+}
+
+bool afc_sender_correction(uint16_t sender, float temp_c, int32_t *hz) {
+    const afc_peer_t *p = find_peer(sender);
+    if (!p || p->samples < AFC_MIN_SAMPLES) {
+        return false;
+    }
+
+    float predicted = p->offset_hz;
+    float slope;
+    if (!isnan(temp_c) && !isnan(p->temp_c) && peer_slope(p, &slope)) {
+        // Extrapola a partir do desvio atual pela diferença de temperatura
+        predicted += slope * (temp_c - p->temp_c);
+    }
+    *hz = (int32_t)lroundf(predicted);
+    return true;
+}
+
+bool afc_retune(uint32_t now_ms) {
+    if (now_ms - last_retune_ms < AFC_RETUNE_PERIOD_MS) {
+        return false;
+    }
+    last_retune_ms = now_ms;
+
+    float sum = 0;
+    int n = 0;
+    for (int i = 0; i < AFC_MAX_PEERS; i++) {
+        const afc_peer_t *p = &peers[i];
+        if (p->used && p->samples >= AFC_MIN_SAMPLES && now_ms - p->last_ms < AFC_STALE_MS) {
+            sum += p->offset_hz;
+            n++;
+        }
+    }
+    if (n == 0) {
+        return false;
+    }
+
+    int32_t current = channel_plan_get_correction(radio);
+    int32_t target = (int32_t)lroundf(sum / n);
+    if (target > AFC_MAX_CORRECTION_HZ) {
+        target = AFC_MAX_CORRECTION_HZ;
+    } else if (target < -AFC_MAX_CORRECTION_HZ) {
+        target = -AFC_MAX_CORRECTION_HZ;
+    }
+    if (abs(target - current) < AFC_RETUNE_MIN_HZ) {
+        return false;
+    }
+
+    // Anda metade do caminho por vez: um quadro com estimativa ruim não
+    // desloca o receptor de uma só vez
+    channel_plan_set_correction(radio, current + (target - current) / 2);
+    retunes++;
+    return true;
+}
+
+void afc_print(void) {
+    printf("AFC: correcao local %ld Hz, %lu ajustes\n",
+           (long)channel_plan_get_correction(radio), (unsigned long)retunes);
+
+    for (int i = 0; i < AFC_MAX_PEERS; i++) {
+        const afc_peer_t *p = &peers[i];
+        if (!p->used) {
+            continue;
+        }
+        float slope;
+        if (peer_slope(p, &slope)) {
+            printf("  %04X: desvio %.0f Hz (%u amostras), %.1f Hz/C a %.1f C\n",
+                   p->id, p->offset_hz, p->samples, slope, p->temp_c);
+        } else {
+            printf("  %04X: desvio %.0f Hz (%u amostras)\n", p->id, p->offset_hz, p->samples);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef AFC_H
+#define AFC_H
+
+#include "pico/stdlib.h"
+#include "sx1276.h"
+
+// Acompanhamento do desvio de frequência entre os nós (AFC). A cada quadro
+// válido o receptor lê o erro de frequência estimado pelo modem e mantém, por
+// remetente, o desvio absoluto filtrado e um modelo linear desvio x temperatura
+// (o cristal de 32 MHz deriva com a temperatura; a estação informa a sua no
+// quadro). Periodicamente o receptor desloca o próprio FRF para o desvio médio
+// dos remetentes ativos; afc_sender_correction() dá a pré-correção que um
+// remetente deveria aplicar no próprio FRF. O AFC acompanha um rádio, o de
+// recepção escolhido em afc_init (os cristais de dois rádios derivam
+// independentes).
+
+#define AFC_MAX_PEERS           8
+#define AFC_MIN_SAMPLES         4           // Amostras antes de usar o desvio de um remetente
+#define AFC_RETUNE_PERIOD_MS    60000       // Intervalo mínimo entre ajustes do FRF local
+#define AFC_RETUNE_MIN_HZ       300         // Desvio residual que justifica reajustar
+#define AFC_MAX_CORRECTION_HZ   20000       // Limite da correção local (BW/4 em 125 kHz é 31 kHz)
+#define AFC_STALE_MS            600000      // Remetente ignorado no ajuste após 10 min sem quadros
+#define AFC_MIN_TEMP_SPREAD     2.0f        // Faixa de temperatura (C) para confiar na inclinação
+
+typedef struct {
+    uint16_t id;
+    bool used;
+    uint16_t samples;
+    uint32_t last_ms;
+    float offset_hz;        // Desvio absoluto filtrado (remetente - referência do receptor)
+    float temp_c;           // Última temperatura informada
+    // Mínimos quadrados com esquecimento exponencial: desvio = a + b * temperatura
+    float sw, st, so, stt, sto;
+} afc_peer_t;
+
+void afc_init(lora_dev_t *dev);
+
+// Registra o erro de frequência de um quadro válido. temp_c pode ser NAN
+// quando o quadro não informa temperatura.
+void afc_update(uint16_t sender, int32_t freq_error_hz, float temp_c, uint32_t now_ms);
+
+// Desloca o FRF local para o desvio médio dos remetentes ativos, no máximo uma
+// vez por AFC_RETUNE_PERIOD_MS. Chamar entre pacotes. Retorna true se reajustou.
+bool afc_retune(uint32_t now_ms);
+
+// Desvio previsto do remetente na temperatura temp_c (ou no último desvio se
+// não houver modelo); é a correção, em Hz, que ele deveria subtrair do seu FRF
+bool afc_sender_correction(uint16_t sender, float temp_c, int32_t *hz);
+
+// Inclinação estimada do remetente em Hz/C (false sem faixa de temperatura suficiente)
+bool afc_sender_slope(uint16_t sender, float *hz_per_c);
+
+void afc_print(void);
+
+#endif // AFC_H
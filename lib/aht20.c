@@ -9,49 +9,41 @@
 #define AHT20_CMD_RESET     0xBA
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
+#define AHT20_READY_TIMEOUT_MS  100   // Limite de espera pelo sensor após init/reset
+#define AHT20_I2C_TIMEOUT_US    2000  // Transferência de medição (7 bytes a 400 kHz levam ~200 us)
 
 bool aht20_init(i2c_inst_t *i2c) {
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
-    sleep_ms(50);  // Aguarda o sensor inicializar
 
-    // Verifica status até que o sensor esteja pronto
+    // Consulta o status até que o sensor esteja calibrado (em vez de esperar 50 ms fixos)
     uint8_t status;
-    for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
-        if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
+    for (int i = 0; i < AHT20_READY_TIMEOUT_MS; i++) {
+        if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false) == 1 &&
+            (status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
-        sleep_ms(10);
+        sleep_ms(1);
     }
 
     return false;  // Falhou na calibração
 }
 
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+bool aht20_trigger(i2c_inst_t *i2c) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
+    return i2c_write_timeout_us(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false, AHT20_I2C_TIMEOUT_US) == 3;
+}
+
+bool aht20_fetch(i2c_inst_t *i2c, AHT20_Data *data) {
     uint8_t buffer[6];
 
-    // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
-    
-    // Aguarda até o sensor estar pronto
-    uint8_t status;
-    for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
-        if (!(status & AHT20_STATUS_BUSY)) {
-            break;
-        }
-        sleep_ms(10);
-    }
-    
-    // Se ainda estiver ocupado, falha na leitura
-    if (status & AHT20_STATUS_BUSY) {
+    // Lê de uma vez os 6 bytes (status + dados)
+    if (i2c_read_timeout_us(i2c, AHT20_I2C_ADDR, buffer, 6, false, AHT20_I2C_TIMEOUT_US) != 6) {
         return false;
     }
 
-    // Lê os 6 bytes de dados
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
+    // Se ainda estiver ocupado, a medição não terminou
+    if (buffer[0] & AHT20_STATUS_BUSY) {
         return false;
     }
 
@@ -69,7 +61,11 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
 void aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
-    sleep_ms(20);
+
+    // Aguarda o sensor voltar a responder no barramento (até 20 ms)
+    for (int i = 0; i < 20 && !aht20_check(i2c); i++) {
+        sleep_ms(1);
+    }
     aht20_init(i2c);
 }
 
@@ -19,8 +19,14 @@ typedef struct {
 // Inicializa o sensor AHT20
 bool aht20_init(i2c_inst_t *i2c);
 
-// Faz a leitura de temperatura e umidade do AHT20
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
+// Leitura em duas etapas, sem espera ativa: dispara a medição e busca o
+// resultado após a conversão (sample_clock agenda a busca por alarme)
+
+// Dispara uma medição sem aguardar o resultado (conversão leva ~80 ms)
+bool aht20_trigger(i2c_inst_t *i2c);
+
+// Lê o resultado de uma medição disparada; retorna false se o sensor ainda estiver ocupado
+bool aht20_fetch(i2c_inst_t *i2c, AHT20_Data *data);
 
 // Reseta o sensor AHT20
 void aht20_reset(i2c_inst_t *i2c);
@@ -0,0 +1,20 @@
+#include "airtime.h"
+
+uint32_t lora_symbol_time_us(const lora_modem_cfg_t *cfg) {
+    return (uint32_t)(((uint64_t)1000000 << cfg->sf) / cfg->bw_hz);
+}
+
+uint32_t lora_payload_symbols(const lora_modem_cfg_t *cfg, uint8_t payload_len) {
+    // ceil((8PL - 4SF + 28 + 16CRC - 20IH) / (4(SF - 2DE))) * (CR + 4), mínimo 0
+    int32_t num = 8 * payload_len - 4 * cfg->sf + 28 + (cfg->crc ? 16 : 0) - (cfg->implicit_header ? 20 : 0);
+    int32_t den = 4 * (cfg->sf - (cfg->low_dr_opt ? 2 : 0));
+    int32_t blocks = num > 0 ? (num + den - 1) / den : 0;
+    return 8 + (uint32_t)blocks * (cfg->cr + 4);
+}
+
+uint32_t lora_airtime_us(const lora_modem_cfg_t *cfg, uint8_t payload_len) {
+    // Preâmbulo: (n + 4,25) símbolos; conta em quartos de símbolo
+    uint64_t quarter_symbols = (uint64_t)(4 * cfg->preamble + 17) +
+                               4 * (uint64_t)lora_payload_symbols(cfg, payload_len);
+    return (uint32_t)((quarter_symbols * ((uint64_t)1000000 << cfg->sf)) / (4 * (uint64_t)cfg->bw_hz));
+}
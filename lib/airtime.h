@@ -0,0 +1,38 @@
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tempo no ar de um quadro LoRa (fórmula da nota de aplicação do SX1276).
+// Sem dependência do SDK: usado também pelos simuladores no host.
+
+typedef struct {
+    uint8_t sf;             // Fator de espalhamento (6..12)
+    uint32_t bw_hz;         // Largura de banda
+    uint8_t cr;             // Taxa de codificação: 1 = 4/5 ... 4 = 4/8
+    uint16_t preamble;      // Símbolos de preâmbulo programados
+    bool implicit_header;
+    bool crc;
+    bool low_dr_opt;        // LowDataRateOptimize (obrigatório com símbolo > 16 ms)
+} lora_modem_cfg_t;
+
+// Configuração usada pelo driver (SF7, 125 kHz, CR 4/5, header explícito, CRC)
+#define LORA_MODEM_CFG_DEFAULT(preamble_len) \
+    { .sf = 7, .bw_hz = 125000, .cr = 1, .preamble = (preamble_len), \
+      .implicit_header = false, .crc = true, .low_dr_opt = false }
+
+// Modo rápido do driver (lora_set_fast_mode): SF6 com header implícito
+#define LORA_MODEM_CFG_FAST(preamble_len) \
+    { .sf = 6, .bw_hz = 125000, .cr = 1, .preamble = (preamble_len), \
+      .implicit_header = true, .crc = true, .low_dr_opt = false }
+
+uint32_t lora_symbol_time_us(const lora_modem_cfg_t *cfg);
+
+// Número de símbolos do payload (inclui os 8 símbolos fixos do cabeçalho)
+uint32_t lora_payload_symbols(const lora_modem_cfg_t *cfg, uint8_t payload_len);
+
+// Tempo total no ar: preâmbulo + payload, em microssegundos
+uint32_t lora_airtime_us(const lora_modem_cfg_t *cfg, uint8_t payload_len);
+
+#endif // AIRTIME_H
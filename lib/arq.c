@@ -0,0 +1,207 @@
+#include <string.h>
+#include "arq.h"
+#include "downlink.h"
+
+uint32_t arq_ack_slot_us(const lora_modem_cfg_t *modem) {
+    // Turnaround do receptor + ACK completo + dois símbolos de folga
+    return ARQ_TURNAROUND_US + lora_airtime_us(modem, ARQ_ACK_FRAME_LEN) + 2 * lora_symbol_time_us(modem);
+}
+
+uint32_t arq_rto_us(const lora_modem_cfg_t *modem, uint8_t len) {
+    // Com a janela cheia, o ACK do quadro seguinte (bitmap) ainda pode
+    // confirmar este antes da retransmissão. A janela de RX da estação inclui
+    // o acréscimo do downlink.
+    return ARQ_RTO_EXCHANGES * (lora_airtime_us(modem, ARQ_HEADER_LEN + len) + arq_ack_slot_us(modem) +
+                                downlink_window_extra_us(modem));
+}
+
+void arq_tx_init(arq_tx_t *t, uint8_t window, const lora_modem_cfg_t *modem) {
+    memset(t, 0, sizeof(*t));
+    t->modem = *modem;
+    t->window = window == 0 ? 1 : (window > ARQ_WINDOW_MAX ? ARQ_WINDOW_MAX : window);
+}
+
+static inline arq_slot_t *slot_of(arq_tx_t *t, uint16_t seq) {
+    return &t->slots[seq % ARQ_WINDOW_MAX];
+}
+
+// Avança a base sobre quadros já confirmados ou descartados
+static void tx_slide(arq_tx_t *t) {
+    while (t->base != t->next_seq && !slot_of(t, t->base)->in_use) {
+        t->base++;
+    }
+}
+
+uint8_t arq_tx_pending(const arq_tx_t *t) {
+    return (uint8_t)(t->next_seq - t->base);
+}
+
+bool arq_tx_syn(const arq_tx_t *t) {
+    return !t->synced;
+}
+
+bool arq_tx_submit(arq_tx_t *t, const uint8_t *data, uint8_t len, uint8_t max_retries, uint8_t tag) {
+    if (arq_tx_pending(t) >= t->window || len > ARQ_MAX_PAYLOAD) {
+        return false;
+    }
+    arq_slot_t *s = slot_of(t, t->next_seq);
+    s->in_use = true;
+    s->len = len;
+    s->tries = 0;
+    s->max_retries = max_retries;
+    s->tag = tag;
+    s->rto_us = arq_rto_us(&t->modem, len);
+    memcpy(s->data, data, len);
+    t->next_seq++;
+    t->stats.submitted++;
+    return true;
+}
+
+static int tx_send(arq_tx_t *t, uint16_t seq, arq_slot_t *s, uint32_t now_us,
+                   uint16_t *seq_out, bool *retry, const uint8_t **data, uint8_t *tag) {
+    *retry = s->tries > 0;
+    if (*retry) {
+        t->stats.retransmissions++;
+    }
+    s->tries++;
+    s->sent_us = now_us;
+    t->stats.transmissions++;
+    t->stats.air_bytes += ARQ_HEADER_LEN + s->len;
+    *seq_out = seq;
+    *data = s->data;
+    if (tag) {
+        *tag = s->tag;
+    }
+    return s->len;
+}
+
+int arq_tx_poll(arq_tx_t *t, uint32_t now_us, uint16_t *seq, bool *retry, const uint8_t **data,
+                uint8_t *tag) {
+    // Retransmissões vencidas têm prioridade (são as mais antigas da janela)
+    for (uint16_t q = t->base; q != t->next_seq; q++) {
+        arq_slot_t *s = slot_of(t, q);
+        if (!s->in_use || s->tries == 0 || now_us - s->sent_us < s->rto_us) {
+            continue;
+        }
+        if (s->tries > s->max_retries) {
+            s->in_use = false;
+            t->stats.expired++;
+            continue;
+        }
+        int len = tx_send(t, q, s, now_us, seq, retry, data, tag);
+        tx_slide(t);
+        return len;
+    }
+    tx_slide(t);
+
+    for (uint16_t q = t->base; q != t->next_seq; q++) {
+        arq_slot_t *s = slot_of(t, q);
+        if (s->in_use && s->tries == 0) {
+            return tx_send(t, q, s, now_us, seq, retry, data, tag);
+        }
+    }
+    return -1;
+}
+
+void arq_tx_on_ack(arq_tx_t *t, const uint8_t *ack, size_t len) {
+    if (len < ARQ_ACK_LEN) {
+        return;
+    }
+    uint16_t ack_base = (uint16_t)(ack[0] | (ack[1] << 8));
+    uint16_t bitmap = (uint16_t)(ack[2] | (ack[3] << 8));
+    t->stats.acks++;
+    t->synced = true;
+
+    for (uint16_t q = t->base; q != t->next_seq; q++) {
+        arq_slot_t *s = slot_of(t, q);
+        if (!s->in_use || s->tries == 0) {
+            continue;
+        }
+        uint16_t d = (uint16_t)(q - ack_base);
+        bool acked = d >= 0x8000 ||                                 // Antes da base cumulativa
+                     (d >= 1 && d <= ARQ_WINDOW_MAX && (bitmap & (1u << (d - 1))));
+        if (acked) {
+            s->in_use = false;
+            t->stats.delivered++;
+            t->stats.payload_bytes += s->len;
+        }
+    }
+    tx_slide(t);
+}
+
+void arq_rx_init(arq_rx_t *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+// expected avança uma posição; retorna true se o novo expected já tinha chegado
+static bool rx_advance(arq_rx_t *r) {
+    bool have = r->bitmap & 1;
+    r->bitmap >>= 1;
+    r->expected++;
+    return have;
+}
+
+bool arq_rx_on_frame(arq_rx_t *r, uint16_t seq, bool syn) {
+    uint16_t d = (uint16_t)(seq - r->expected);
+    if (syn) {
+        // Remetente sem ACK desde o boot: a sequência dele começa em 0. Só
+        // zera no primeiro SYN ou se o quadro cair antes da base (reiniciou
+        // de novo); os demais SYN do mesmo boot seguem o fluxo normal.
+        if (!r->started || !r->syn_phase || d >= 0x8000) {
+            if (r->started) {
+                r->restarts++;
+            }
+            r->started = true;
+            r->syn_phase = true;
+            r->expected = 0;
+            r->bitmap = 0;
+            d = seq;
+        }
+    } else {
+        r->syn_phase = false;
+        if (!r->started) {
+            // Primeiro contato com o remetente já sincronizado (o receptor
+            // reiniciou): a base fica uma janela atrás, onde nada pode estar
+            // em aberto, para não confirmar quadros que não chegaram
+            r->started = true;
+            r->expected = (uint16_t)(seq - ARQ_WINDOW_MAX);
+            d = ARQ_WINDOW_MAX;
+        }
+    }
+
+    if (d >= 0x8000) {
+        r->duplicates++;    // Anterior à base: já entregue
+        return false;
+    }
+
+    // A janela do remetente não passa de ARQ_WINDOW_MAX: um quadro além do
+    // bitmap significa que os mais antigos foram abandonados por ele
+    while (d > ARQ_WINDOW_MAX) {
+        r->skipped++;
+        while (rx_advance(r)) {
+        }
+        d = (uint16_t)(seq - r->expected);
+    }
+
+    if (d == 0) {
+        while (rx_advance(r)) {
+        }
+    } else {
+        uint16_t bit = 1u << (d - 1);
+        if (r->bitmap & bit) {
+            r->duplicates++;
+            return false;
+        }
+        r->bitmap |= bit;
+    }
+    r->frames++;
+    return true;
+}
+
+size_t arq_rx_build_ack(const arq_rx_t *r, uint8_t *out) {
+    out[0] = (uint8_t)r->expected;
+    out[1] = (uint8_t)(r->expected >> 8);
+    out[2] = (uint8_t)r->bitmap;
+    out[3] = (uint8_t)(r->bitmap >> 8);
+    return ARQ_ACK_LEN;
+}
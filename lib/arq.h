@@ -0,0 +1,105 @@
+#ifndef ARQ_H
+#define ARQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "airtime.h"
+
+// ARQ de repetição seletiva. O remetente mantém até `window` quadros em aberto;
+// cada quadro é confirmado individualmente por um ACK com base cumulativa e
+// bitmap, enviado pelo receptor numa janela curta de RX logo após cada TX.
+// O timeout de retransmissão vem do tempo no ar do quadro e do ACK, e cada
+// quadro tem o seu limite de retransmissões. Sem dependência do SDK: o mesmo
+// código roda no RP2040 e no simulador do host (sim/arq_link.c).
+
+#define ARQ_WINDOW_MAX      16      // Também a largura do bitmap do ACK
+#define ARQ_MAX_PAYLOAD     249     // LINK_MAX_PAYLOAD
+#define ARQ_HEADER_LEN      6       // LINK_HEADER_LEN (sequência vai no cabeçalho de enlace)
+#define ARQ_ACK_LEN         4       // Base (2 bytes) + bitmap (2 bytes)
+#define ARQ_ACK_FRAME_LEN   (ARQ_HEADER_LEN + ARQ_ACK_LEN)
+#define ARQ_TURNAROUND_US   5000    // Receptor: RxDone -> início do ACK
+#define ARQ_RTO_EXCHANGES   2       // Timeout = N x (quadro + janela de ACK)
+
+typedef struct {
+    bool in_use;
+    uint8_t len;
+    uint8_t tries;          // Transmissões já feitas
+    uint8_t max_retries;    // Retransmissões permitidas depois da primeira
+    uint8_t tag;            // Livre para o chamador (ex.: tipo do quadro de enlace)
+    uint32_t sent_us;
+    uint32_t rto_us;
+    uint8_t data[ARQ_MAX_PAYLOAD];
+} arq_slot_t;
+
+typedef struct {
+    uint32_t submitted;
+    uint32_t delivered;         // Confirmados
+    uint32_t expired;           // Descartados após esgotar as retransmissões
+    uint32_t transmissions;     // Inclui retransmissões
+    uint32_t retransmissions;
+    uint32_t acks;
+    uint32_t payload_bytes;     // Bytes de payload confirmados (goodput)
+    uint32_t air_bytes;         // Bytes transmitidos com cabeçalho (vazão bruta)
+} arq_stats_t;
+
+typedef struct {
+    lora_modem_cfg_t modem;
+    uint8_t window;
+    uint16_t base;              // Quadro mais antigo em aberto
+    uint16_t next_seq;          // Sequência do próximo quadro aceito
+    bool synced;                // Já recebeu um ACK desde o init (boot)
+    arq_slot_t slots[ARQ_WINDOW_MAX];
+    arq_stats_t stats;
+} arq_tx_t;
+
+typedef struct {
+    bool started;
+    bool syn_phase;             // Remetente ainda sem ACK desde o último restart
+    uint16_t expected;          // Todos os anteriores já recebidos (ou abandonados)
+    uint16_t bitmap;            // bit i: quadro expected + 1 + i recebido
+    uint32_t frames;
+    uint32_t duplicates;
+    uint32_t skipped;           // Quadros dados como abandonados pelo remetente
+    uint32_t restarts;          // Reinícios do remetente detectados (SYN)
+} arq_rx_t;
+
+// Duração da janela de ACK após um TX (o remetente fica em RX por esse tempo)
+uint32_t arq_ack_slot_us(const lora_modem_cfg_t *modem);
+
+// Timeout de retransmissão de um quadro com payload de len bytes
+uint32_t arq_rto_us(const lora_modem_cfg_t *modem, uint8_t len);
+
+void arq_tx_init(arq_tx_t *t, uint8_t window, const lora_modem_cfg_t *modem);
+
+// Aceita um quadro para entrega confiável; false se a janela estiver cheia.
+// tag volta junto com o quadro em arq_tx_poll().
+bool arq_tx_submit(arq_tx_t *t, const uint8_t *data, uint8_t len, uint8_t max_retries, uint8_t tag);
+
+// Próximo quadro a transmitir em now_us: retransmissões vencidas primeiro,
+// depois quadros novos. Retorna o tamanho (-1 se nada a enviar) e preenche
+// seq, retry (retransmissão), data e tag (opcional).
+int arq_tx_poll(arq_tx_t *t, uint32_t now_us, uint16_t *seq, bool *retry, const uint8_t **data,
+                uint8_t *tag);
+
+// Processa o payload de um ACK recebido
+void arq_tx_on_ack(arq_tx_t *t, const uint8_t *ack, size_t len);
+
+// Quadros em aberto (aguardando ACK ou transmissão)
+uint8_t arq_tx_pending(const arq_tx_t *t);
+
+// true até o primeiro ACK: os quadros devem sair com LINK_FLAG_SYN para o
+// receptor saber que a sequência recomeçou em 0
+bool arq_tx_syn(const arq_tx_t *t);
+
+void arq_rx_init(arq_rx_t *r);
+
+// Registra um quadro; true se é novo, false se duplicado. Em ambos os casos o
+// remetente precisa de um ACK. syn é o LINK_FLAG_SYN do cabeçalho: um SYN
+// fora de ordem (remetente reiniciou) zera o estado antes de registrar.
+bool arq_rx_on_frame(arq_rx_t *r, uint16_t seq, bool syn);
+
+// Monta o payload do ACK (ARQ_ACK_LEN bytes)
+size_t arq_rx_build_ack(const arq_rx_t *r, uint8_t *out);
+
+#endif // ARQ_H
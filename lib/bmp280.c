@@ -18,16 +18,18 @@ void bmp280_init(i2c_inst_t *i2c) {
  //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+bool bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
     uint8_t buf[6];
     uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    // Com timeout: um barramento travado não prende a tarefa de amostragem
+    if (i2c_write_timeout_us(i2c, ADDR, &reg, 1, true, BMP280_I2C_TIMEOUT_US) != 1 ||
+        i2c_read_timeout_us(i2c, ADDR, buf, 6, false, BMP280_I2C_TIMEOUT_US) != 6) {
+        return false;
+    }
 
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
-
-
+    return true;
 }
 
 void bmp280_reset(i2c_inst_t *i2c) {
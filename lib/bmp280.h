@@ -45,6 +45,8 @@
 
 #define NUM_CALIB_PARAMS 24
 
+#define BMP280_I2C_TIMEOUT_US 2000
+
 struct bmp280_calib_param {
     uint16_t dig_t1;
     int16_t dig_t2;
@@ -63,7 +65,9 @@ struct bmp280_calib_param {
 
 //void bmp280_init(void);
 void bmp280_init(i2c_inst_t *i2c);
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
+// Leitura crua de temperatura e pressão; false se o barramento não responder
+// em BMP280_I2C_TIMEOUT_US por transferência
+bool bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
 void bmp280_reset(i2c_inst_t *i2c);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params);
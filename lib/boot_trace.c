@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "pico/stdio_usb.h"
+#include "boot_trace.h"
+
+typedef struct {
+    const char *label;
+    uint32_t time_us;
+    uint8_t core;
+} boot_mark_t;
+
+static boot_mark_t marks[BOOT_TRACE_MAX_MARKS];
+static uint8_t num_marks;
+static critical_section_t lock;
+
+void boot_trace_init(void) {
+    critical_section_init(&lock);
+    num_marks = 0;
+}
+
+void boot_trace_mark(const char *label) {
+    uint32_t now = time_us_32();
+
+    critical_section_enter_blocking(&lock);
+    if (num_marks < BOOT_TRACE_MAX_MARKS) {
+        marks[num_marks].label = label;
+        marks[num_marks].time_us = now;
+        marks[num_marks].core = (uint8_t)get_core_num();
+        num_marks++;
+    }
+    critical_section_exit(&lock);
+}
+
+void boot_trace_mark_once(const char *label, bool *done) {
+    if (!*done) {
+        *done = true;
+        boot_trace_mark(label);
+    }
+}
+
+bool boot_wait_usb(uint32_t timeout_ms) {
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    while (!stdio_usb_connected()) {
+        if (time_reached(deadline)) {
+            return false;
+        }
+        sleep_ms(1);
+    }
+    return true;
+}
+
+void boot_trace_print(void) {
+    uint32_t prev = 0;
+
+    printf("Inicializacao (us desde o reset):\n");
+    for (int i = 0; i < num_marks; i++) {
+        printf("  %8lu  +%7lu  core%u  %s\n", (unsigned long)marks[i].time_us,
+               (unsigned long)(marks[i].time_us - prev), marks[i].core, marks[i].label);
+        prev = marks[i].time_us;
+    }
+}
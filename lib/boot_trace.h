@@ -0,0 +1,26 @@
+#ifndef BOOT_TRACE_H
+#define BOOT_TRACE_H
+
+#include "pico/stdlib.h"
+
+// Linha do tempo da inicialização: cada etapa registra o instante (desde o
+// reset) em que terminou. Pode ser chamada dos dois núcleos. O registro fica
+// em RAM e é impresso depois, quando a serial estiver conectada.
+
+#define BOOT_TRACE_MAX_MARKS 16
+
+void boot_trace_init(void);
+
+// Registra uma etapa; label deve apontar para uma string constante
+void boot_trace_mark(const char *label);
+
+// Registra a etapa apenas na primeira chamada (ex.: primeiro quadro transmitido)
+void boot_trace_mark_once(const char *label, bool *done);
+
+// Aguarda a conexão USB da serial por no máximo timeout_ms (retorna ao conectar)
+bool boot_wait_usb(uint32_t timeout_ms);
+
+// Imprime a linha do tempo na serial
+void boot_trace_print(void);
+
+#endif // BOOT_TRACE_H
@@ -0,0 +1,100 @@
+#include "pico/stdlib.h"
+#include "sx1276.h"
+#include "channel_plan.h"
+
+#if CHANNEL_PLAN_NUM_CHANNELS > 16 || CHANNEL_PLAN_DEFAULT >= CHANNEL_PLAN_NUM_CHANNELS
+#error "Plano de canais inválido"
+#endif
+
+// FRF de cada canal já separado nos três bytes de REG_FRF_MSB/MID/LSB
+#define FRF_BYTES(ch) { (uint8_t)(LORA_FRF(CHANNEL_PLAN_HZ(ch)) >> 16), \
+                        (uint8_t)(LORA_FRF(CHANNEL_PLAN_HZ(ch)) >> 8),  \
+                        (uint8_t)(LORA_FRF(CHANNEL_PLAN_HZ(ch))) }
+
+static const uint8_t channel_frf[16][3] = {
+    FRF_BYTES(0),  FRF_BYTES(1),  FRF_BYTES(2),  FRF_BYTES(3),
+    FRF_BYTES(4),  FRF_BYTES(5),  FRF_BYTES(6),  FRF_BYTES(7),
+    FRF_BYTES(8),  FRF_BYTES(9),  FRF_BYTES(10), FRF_BYTES(11),
+    FRF_BYTES(12), FRF_BYTES(13), FRF_BYTES(14), FRF_BYTES(15),
+};
+
+static uint8_t hop_sequence[CHANNEL_PLAN_NUM_CHANNELS];
+
+uint32_t channel_plan_freq_hz(uint8_t ch) {
+    return CHANNEL_PLAN_HZ(ch % CHANNEL_PLAN_NUM_CHANNELS);
+}
+
+void channel_plan_set(lora_dev_t *dev, uint8_t ch) {
+    ch %= CHANNEL_PLAN_NUM_CHANNELS;
+    if (dev->frf_correction == 0) {
+        lora_write_burst(dev, REG_FRF_MSB, channel_frf[ch], 3);
+    } else {
+        uint32_t frf = ((uint32_t)channel_frf[ch][0] << 16) | ((uint32_t)channel_frf[ch][1] << 8) |
+                       channel_frf[ch][2];
+        frf += (uint32_t)dev->frf_correction;
+        uint8_t buf[3] = { (uint8_t)(frf >> 16), (uint8_t)(frf >> 8), (uint8_t)frf };
+        lora_write_burst(dev, REG_FRF_MSB, buf, 3);
+    }
+    dev->channel = ch;
+}
+
+int32_t channel_plan_set_correction(lora_dev_t *dev, int32_t hz) {
+    dev->frf_correction = (int32_t)(((int64_t)hz << 19) / 32000000);
+    channel_plan_set(dev, dev->channel);
+    return channel_plan_get_correction(dev);
+}
+
+int32_t channel_plan_get_correction(const lora_dev_t *dev) {
+    return (int32_t)(((int64_t)dev->frf_correction * 32000000) >> 19);
+}
+
+void fhss_init(lora_dev_t *dev, uint8_t hop_period, uint8_t seed) {
+    // Embaralhamento de Fisher-Yates com um LCG de 8 bits: TX e RX com a
+    // mesma semente chegam à mesma sequência
+    uint8_t rnd = seed;
+    for (uint8_t i = 0; i < CHANNEL_PLAN_NUM_CHANNELS; i++) {
+        hop_sequence[i] = i;
+    }
+    for (uint8_t i = CHANNEL_PLAN_NUM_CHANNELS - 1; i > 0; i--) {
+        rnd = (uint8_t)(rnd * 141 + 29);
+        uint8_t j = rnd % (i + 1);
+        uint8_t tmp = hop_sequence[i];
+        hop_sequence[i] = hop_sequence[j];
+        hop_sequence[j] = tmp;
+    }
+
+    dev->hopping = hop_period != 0;
+    lora_write_reg(dev, REG_HOP_PERIOD, hop_period);
+    lora_set_dio_mapping(dev, DIO1_MASK, dev->hopping ? DIO1_FHSS_CHANGE_CHANNEL : DIO1_RX_TIMEOUT);
+
+    dev->hop_index = 0;
+    channel_plan_set(dev, dev->hopping ? hop_sequence[0] : CHANNEL_PLAN_DEFAULT);
+}
+
+void fhss_on_change_channel(lora_dev_t *dev) {
+    if (!dev->hopping) {
+        return;
+    }
+    // Três bytes de FRF em rajada e a limpeza da flag: o rádio só sintoniza
+    // o novo canal depois de FhssChangeChannel ser limpo
+    dev->hop_index = (uint8_t)((dev->hop_index + 1) % CHANNEL_PLAN_NUM_CHANNELS);
+    channel_plan_set(dev, hop_sequence[dev->hop_index]);
+    lora_write_reg(dev, REG_IRQ_FLAGS, IRQ_FHSS_CHANGE_CHANNEL);
+    dev->hops++;
+}
+
+void fhss_packet_done(lora_dev_t *dev) {
+    if (dev->hopping && dev->hop_index != 0) {
+        dev->hop_index = 0;
+        channel_plan_set(dev, hop_sequence[0]);
+    }
+}
+
+bool fhss_enabled(const lora_dev_t *dev) {
+    return dev->hopping;
+}
+
+void fhss_get_stats(const lora_dev_t *dev, fhss_stats_t *out) {
+    out->hops = dev->hops;
+    out->current = dev->channel;
+}
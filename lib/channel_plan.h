@@ -0,0 +1,59 @@
+#ifndef CHANNEL_PLAN_H
+#define CHANNEL_PLAN_H
+
+#include "pico/stdlib.h"
+#include "sx1276.h"
+
+// Plano de canais do SX1276. Os valores de FRF (3 bytes) são calculados em
+// tempo de compilação, então trocar de canal é uma única escrita em rajada
+// no SPI, sem ponto flutuante. Com FHSS o rádio avisa no DIO1 a cada
+// FHSS_HOP_PERIOD símbolos e a ISR programa o próximo canal da sequência.
+// Canal, correção e salto ficam no lora_dev_t de cada rádio; a sequência de
+// saltos é a mesma para todos (mesma semente na rede).
+
+#define CHANNEL_PLAN_FIRST_HZ       914200000UL // Canal 0
+#define CHANNEL_PLAN_STEP_HZ        200000UL    // Espaçamento entre canais
+#define CHANNEL_PLAN_NUM_CHANNELS   8           // Máximo 16
+#define CHANNEL_PLAN_DEFAULT        4           // 915,0 MHz (mesmo de LORA_FREQUENCY)
+
+// Salto de frequência durante o pacote (deve ser igual no TX e no RX)
+#define FHSS_HOP_PERIOD             0           // Símbolos por salto (0 desabilita)
+#define FHSS_SEED                   0x5A        // Semente da sequência de saltos
+
+// FRF = f * 2^19 / 32 MHz (passo de 61,035 Hz)
+#define LORA_FRF(hz)                ((uint32_t)(((uint64_t)(hz) << 19) / 32000000UL))
+#define CHANNEL_PLAN_HZ(ch)         (CHANNEL_PLAN_FIRST_HZ + (uint32_t)(ch) * CHANNEL_PLAN_STEP_HZ)
+
+typedef struct {
+    uint32_t hops;          // Saltos atendidos pela ISR
+    uint8_t current;        // Canal programado no rádio
+} fhss_stats_t;
+
+// Frequência nominal do canal em Hz
+uint32_t channel_plan_freq_hz(uint8_t ch);
+
+// Programa o canal (uma rajada de 3 bytes em REG_FRF_MSB..LSB)
+void channel_plan_set(lora_dev_t *dev, uint8_t ch);
+
+// Desloca todos os canais de hz (correção de frequência do AFC) e reprograma o
+// canal atual. Chamar entre pacotes. Retorna a correção aplicada, arredondada
+// para o passo de FRF.
+int32_t channel_plan_set_correction(lora_dev_t *dev, int32_t hz);
+int32_t channel_plan_get_correction(const lora_dev_t *dev);
+
+// Gera a sequência de saltos a partir da semente, configura REG_HOP_PERIOD,
+// mapeia DIO1 -> FhssChangeChannel e sintoniza o primeiro canal da sequência.
+// hop_period = 0 desabilita o FHSS e volta para o canal padrão.
+void fhss_init(lora_dev_t *dev, uint8_t hop_period, uint8_t seed);
+
+// Atende a interrupção FhssChangeChannel (chamar da ISR do DIO1)
+void fhss_on_change_channel(lora_dev_t *dev);
+
+// Volta ao primeiro canal da sequência ao fim de cada pacote (TxDone/RxDone)
+void fhss_packet_done(lora_dev_t *dev);
+
+bool fhss_enabled(const lora_dev_t *dev);
+
+void fhss_get_stats(const lora_dev_t *dev, fhss_stats_t *out);
+
+#endif // CHANNEL_PLAN_H
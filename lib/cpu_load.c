@@ -0,0 +1,49 @@
+#include "pico/stdlib.h"
+#include "cpu_load.h"
+
+// Contadores cumulativos de 32 bits: cada um é escrito só pelo próprio núcleo
+// e lido de forma atômica pelo outro. As diferenças são calculadas com
+// aritmética sem sinal, então o estouro a cada ~71 min não afeta a medida.
+static volatile uint32_t idle_acc_us[CPU_LOAD_NUM_CORES];
+static volatile uint32_t idle_start_us[CPU_LOAD_NUM_CORES];
+static volatile bool idle_active[CPU_LOAD_NUM_CORES];
+
+// Estado da última leitura (pertence a quem chama cpu_load_sample)
+static uint32_t last_sample_us[CPU_LOAD_NUM_CORES];
+static uint32_t last_idle_us[CPU_LOAD_NUM_CORES];
+
+void cpu_load_idle_begin(void) {
+    uint core = get_core_num();
+    idle_start_us[core] = time_us_32();
+    idle_active[core] = true;
+}
+
+void cpu_load_idle_end(void) {
+    uint core = get_core_num();
+    if (idle_active[core]) {
+        idle_acc_us[core] += time_us_32() - idle_start_us[core];
+        idle_active[core] = false;
+    }
+}
+
+void cpu_load_sample(uint core, cpu_load_t *out) {
+    uint32_t now = time_us_32();
+    uint32_t idle_total = idle_acc_us[core];
+    if (idle_active[core]) {
+        // Núcleo está ocioso agora: inclui o trecho em andamento
+        idle_total += now - idle_start_us[core];
+    }
+
+    uint32_t window = now - last_sample_us[core];
+    uint32_t idle = idle_total - last_idle_us[core];
+    last_sample_us[core] = now;
+    last_idle_us[core] = idle_total;
+
+    if (idle > window) {
+        idle = window;
+    }
+
+    out->window_us = window;
+    out->idle_us = idle;
+    out->busy_percent = window ? (uint8_t)(100 - ((uint64_t)idle * 100) / window) : 0;
+}
@@ -0,0 +1,24 @@
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include "pico/stdlib.h"
+
+// Contabilidade de tempo ocioso/ocupado por núcleo do RP2040.
+// Cada núcleo marca apenas o próprio tempo ocioso; o restante é ocupado.
+
+#define CPU_LOAD_NUM_CORES 2
+
+typedef struct {
+    uint32_t window_us;     // Duração da janela medida
+    uint32_t idle_us;       // Tempo ocioso dentro da janela
+    uint8_t busy_percent;   // Utilização na janela (0-100)
+} cpu_load_t;
+
+// Marca o início e o fim de um trecho ocioso no núcleo atual
+void cpu_load_idle_begin(void);
+void cpu_load_idle_end(void);
+
+// Lê a utilização do núcleo desde a última leitura e reinicia a janela
+void cpu_load_sample(uint core, cpu_load_t *out);
+
+#endif // CPU_LOAD_H
@@ -0,0 +1,238 @@
+#include <string.h>
+#include "arq.h"
+#include "downlink.h"
+
+// Tamanho de cada TLV e se o valor tem sinal (na ordem de downlink_tlv_t)
+static const struct {
+    uint8_t len;
+    bool is_signed;
+} tlv_format[DOWNLINK_NUM_TLVS] = {
+    { 2, true }, { 2, true }, { 2, true }, { 2, true },     // Limites
+    { 2, true }, { 2, true }, { 2, true },                  // Offsets
+    { 2, false },                                           // Período de amostragem
+    { 2, false },                                           // Heartbeat
+    { 1, true },                                            // Potência
+};
+
+static inline uint64_t rotl(uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+static inline uint64_t load_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+#define SIPROUND(v0, v1, v2, v3) do {                                       \
+    v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);                \
+    v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;                                   \
+    v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;                                   \
+    v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);                \
+} while (0)
+
+uint64_t downlink_siphash(const uint8_t *key, const uint8_t *data, size_t len) {
+    uint64_t k0 = load_le64(key);
+    uint64_t k1 = load_le64(key + 8);
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    size_t full = len & ~(size_t)7;
+    for (size_t i = 0; i < full; i += 8) {
+        uint64_t m = load_le64(data + i);
+        v3 ^= m;
+        SIPROUND(v0, v1, v2, v3);
+        SIPROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    // Último bloco: bytes restantes e o tamanho no byte mais alto
+    uint64_t b = (uint64_t)len << 56;
+    for (size_t i = full; i < len; i++) {
+        b |= (uint64_t)data[i] << (8 * (i - full));
+    }
+    v3 ^= b;
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= b;
+
+    v2 ^= 0xFF;
+    for (int i = 0; i < 4; i++) {
+        SIPROUND(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// MAC sobre rede e destino (o comando não vale para outra estação) e nonce
+// (nem para outro boot dela), seguidos do contador e dos TLVs como estão no
+// quadro
+static uint64_t command_mac(const uint8_t *key, uint8_t net_id, uint8_t dst, uint32_t nonce,
+                            const uint8_t *body, size_t len) {
+    uint8_t buf[6 + DOWNLINK_COUNTER_LEN + DOWNLINK_MAX_TLV_LEN];
+    buf[0] = net_id;
+    buf[1] = dst;
+    for (int i = 0; i < 4; i++) {
+        buf[2 + i] = (uint8_t)(nonce >> (8 * i));
+    }
+    memcpy(buf + 6, body, len);
+    return downlink_siphash(key, buf, 6 + len);
+}
+
+void downlink_cmd_init(downlink_cmd_t *cmd) {
+    memset(cmd, 0, sizeof(*cmd));
+}
+
+void downlink_cmd_set(downlink_cmd_t *cmd, downlink_tlv_t type, int32_t value) {
+    if (type < DOWNLINK_NUM_TLVS) {
+        cmd->present |= 1u << type;
+        cmd->value[type] = value;
+    }
+}
+
+size_t downlink_build(const uint8_t *key, uint8_t net_id, uint8_t dst, uint32_t nonce,
+                      const downlink_cmd_t *cmd, uint8_t *out) {
+    size_t n = 0;
+    for (int i = 0; i < DOWNLINK_COUNTER_LEN; i++) {
+        out[n++] = (uint8_t)(cmd->counter >> (8 * i));
+    }
+    for (int t = 0; t < DOWNLINK_NUM_TLVS; t++) {
+        if (!(cmd->present & (1u << t))) {
+            continue;
+        }
+        if (n - DOWNLINK_COUNTER_LEN + 2 + tlv_format[t].len > DOWNLINK_MAX_TLV_LEN) {
+            return 0;
+        }
+        out[n++] = (uint8_t)t;
+        out[n++] = tlv_format[t].len;
+        for (int i = 0; i < tlv_format[t].len; i++) {
+            out[n++] = (uint8_t)((uint32_t)cmd->value[t] >> (8 * i));
+        }
+    }
+    uint64_t mac = command_mac(key, net_id, dst, nonce, out, n);
+    for (int i = 0; i < DOWNLINK_MAC_LEN; i++) {
+        out[n++] = (uint8_t)(mac >> (8 * i));
+    }
+    return n;
+}
+
+void downlink_rx_init(downlink_rx_t *d, const uint8_t *key, uint32_t nonce) {
+    memset(d, 0, sizeof(*d));
+    memcpy(d->key, key, DOWNLINK_KEY_LEN);
+    d->nonce = nonce;
+}
+
+static bool parse_tlvs(const uint8_t *p, size_t len, downlink_cmd_t *cmd) {
+    size_t i = 0;
+    while (i < len) {
+        if (len - i < 2) {
+            return false;
+        }
+        uint8_t type = p[i];
+        uint8_t tlen = p[i + 1];
+        i += 2;
+        if (type >= DOWNLINK_NUM_TLVS || tlen != tlv_format[type].len || len - i < tlen ||
+            (cmd->present & (1u << type))) {
+            return false;
+        }
+        uint32_t v = 0;
+        for (int b = 0; b < tlen; b++) {
+            v |= (uint32_t)p[i + b] << (8 * b);
+        }
+        // Extensão de sinal a partir do tamanho do campo
+        if (tlv_format[type].is_signed && (v & (1u << (8 * tlen - 1)))) {
+            v |= ~0u << (8 * tlen);
+        }
+        downlink_cmd_set(cmd, (downlink_tlv_t)type, (int32_t)v);
+        i += tlen;
+    }
+    return true;
+}
+
+downlink_result_t downlink_rx_on_frame(downlink_rx_t *d, uint8_t net_id, uint8_t dst,
+                                       const uint8_t *data, size_t len, downlink_cmd_t *cmd) {
+    if (len < DOWNLINK_COUNTER_LEN + DOWNLINK_MAC_LEN || len > DOWNLINK_MAX_LEN) {
+        d->malformed++;
+        return DOWNLINK_MALFORMED;
+    }
+    size_t body_len = len - DOWNLINK_MAC_LEN;
+    uint64_t mac = command_mac(d->key, net_id, dst, d->nonce, data, body_len);
+
+    // Comparação sem saída antecipada: o tempo não revela o byte errado
+    uint8_t diff = 0;
+    for (int i = 0; i < DOWNLINK_MAC_LEN; i++) {
+        diff |= data[body_len + i] ^ (uint8_t)(mac >> (8 * i));
+    }
+    if (diff) {
+        d->bad_mac++;
+        return DOWNLINK_BAD_MAC;
+    }
+
+    uint32_t counter = (uint32_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+    if (counter == d->last_counter && counter != 0) {
+        d->duplicates++;
+        return DOWNLINK_DUPLICATE;
+    }
+    if (counter <= d->last_counter) {
+        d->replays++;
+        return DOWNLINK_REPLAY;
+    }
+
+    downlink_cmd_t parsed;
+    downlink_cmd_init(&parsed);
+    parsed.counter = counter;
+    if (!parse_tlvs(data + DOWNLINK_COUNTER_LEN, body_len - DOWNLINK_COUNTER_LEN, &parsed)) {
+        d->malformed++;
+        return DOWNLINK_MALFORMED;
+    }
+    d->last_counter = counter;
+    d->accepted++;
+    *cmd = parsed;
+    return DOWNLINK_OK;
+}
+
+// Mesmo MAC dos comandos sobre [contador, flags]: a entrada de 11 bytes não
+// confunde com a de um comando (vazio tem 10, com um TLV ao menos 13)
+size_t downlink_status_build(const uint8_t *key, uint8_t net_id, uint8_t src,
+                             const downlink_status_t *st, uint8_t *out) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(st->nonce >> (8 * i));
+        out[4 + i] = (uint8_t)(st->counter >> (8 * i));
+    }
+    out[8] = st->nacked ? DOWNLINK_STATUS_NACK : 0;
+    uint64_t mac = command_mac(key, net_id, src, st->nonce, out + 4, 5);
+    for (int i = 0; i < DOWNLINK_STATUS_MAC_LEN; i++) {
+        out[9 + i] = (uint8_t)(mac >> (8 * i));
+    }
+    return DOWNLINK_STATUS_LEN;
+}
+
+bool downlink_status_parse(const uint8_t *key, uint8_t net_id, uint8_t src,
+                           const uint8_t *data, size_t len, downlink_status_t *st) {
+    if (len != DOWNLINK_STATUS_LEN || (data[8] & ~DOWNLINK_STATUS_NACK)) {
+        return false;
+    }
+    uint32_t nonce = (uint32_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24));
+    uint64_t mac = command_mac(key, net_id, src, nonce, data + 4, 5);
+    uint8_t diff = 0;
+    for (int i = 0; i < DOWNLINK_STATUS_MAC_LEN; i++) {
+        diff |= data[9 + i] ^ (uint8_t)(mac >> (8 * i));
+    }
+    if (diff || nonce == 0) {
+        return false;
+    }
+    st->nonce = nonce;
+    st->counter = (uint32_t)(data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24));
+    st->nacked = data[8] & DOWNLINK_STATUS_NACK;
+    return true;
+}
+
+uint32_t downlink_window_extra_us(const lora_modem_cfg_t *modem) {
+    if (!DOWNLINK_ENABLED) {
+        return 0;
+    }
+    return lora_airtime_us(modem, ARQ_ACK_FRAME_LEN + DOWNLINK_MAX_LEN) - lora_airtime_us(modem, ARQ_ACK_FRAME_LEN);
+}
@@ -0,0 +1,115 @@
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "airtime.h"
+
+// Comandos do gateway para a estação (configuração pelo ar). Como no LoRaWAN
+// classe A, o downlink só chega na janela de RX que a estação abre após cada
+// uplink: o gateway responde com um quadro LINK_FRAME_CMD no lugar do ACK,
+// com os bytes do ACK do ARQ seguidos do comando:
+//   [0..3] contador (LE)  [4..] TLVs (tipo, tamanho, valor LE)  [fim-8..] MAC
+// O MAC é SipHash-2-4 com a chave compartilhada sobre rede, destino, nonce
+// de boot da estação, contador e TLVs. A estação sorteia o nonce a cada boot
+// e o anuncia no status do uplink: comandos gravados antes de um reset não
+// passam no MAC, e dentro do boot só vale contador maior que o último aceito
+// (anti-replay). O comando é aplicado inteiro ou nada. Sem dependência do SDK.
+
+#define DOWNLINK_ENABLED        1
+#define DOWNLINK_KEY_LEN        16
+#define DOWNLINK_COUNTER_LEN    4
+#define DOWNLINK_MAC_LEN        8
+#define DOWNLINK_MAX_TLV_LEN    32
+#define DOWNLINK_MAX_LEN        (DOWNLINK_COUNTER_LEN + DOWNLINK_MAX_TLV_LEN + DOWNLINK_MAC_LEN)
+
+// A chave da rede (DOWNLINK_KEY) fica em downlink_key.h, fora do git: copie
+// downlink_key.h.example e gere uma chave para cada implantação
+
+// Status da estação no uplink, depois do texto e do seu '\0': nonce de boot,
+// último contador aceito e nack (comando recusado pelas faixas), com MAC
+// truncado com a mesma chave. O gateway só assina comandos com um nonce e só
+// dá um comando por entregue com um status autêntico.
+//   [0..3] nonce (LE)  [4..7] contador (LE)  [8] flags  [9..12] MAC
+#define DOWNLINK_STATUS_MAC_LEN 4
+#define DOWNLINK_STATUS_LEN     (9 + DOWNLINK_STATUS_MAC_LEN)
+#define DOWNLINK_STATUS_NACK    0x01
+
+typedef enum {
+    DOWNLINK_MIN_TEMP = 0,      // Limites e offsets: int16, centésimos
+    DOWNLINK_MAX_TEMP,
+    DOWNLINK_MIN_HUM,
+    DOWNLINK_MAX_HUM,
+    DOWNLINK_OFFSET_TEMP,
+    DOWNLINK_OFFSET_HUM,
+    DOWNLINK_OFFSET_PRESS,
+    DOWNLINK_SAMPLE_PERIOD,     // uint16, ms
+    DOWNLINK_HEARTBEAT,         // uint16, s
+    DOWNLINK_TX_POWER,          // int8, dBm
+    DOWNLINK_NUM_TLVS
+} downlink_tlv_t;
+
+typedef struct {
+    uint32_t counter;
+    uint16_t present;                   // bit t: TLV t presente
+    int32_t value[DOWNLINK_NUM_TLVS];   // Valor cru (unidades acima) de cada TLV presente
+} downlink_cmd_t;
+
+typedef struct {
+    uint32_t nonce;
+    uint32_t counter;           // Último comando aceito (0: nenhum desde o boot)
+    bool nacked;                // Esse comando foi recusado
+} downlink_status_t;
+
+typedef enum {
+    DOWNLINK_OK = 0,
+    DOWNLINK_DUPLICATE,         // Mesmo contador do último aceito (retransmissão do gateway)
+    DOWNLINK_REPLAY,            // Contador antigo
+    DOWNLINK_BAD_MAC,
+    DOWNLINK_MALFORMED          // Tamanho, tipo ou TLV inválido
+} downlink_result_t;
+
+typedef struct {
+    uint8_t key[DOWNLINK_KEY_LEN];
+    uint32_t nonce;             // Sorteado no boot, anunciado no status do uplink
+    uint32_t last_counter;      // Último comando aceito (0: nenhum desde o boot)
+    uint32_t accepted;
+    uint32_t duplicates;
+    uint32_t replays;
+    uint32_t bad_mac;
+    uint32_t malformed;
+} downlink_rx_t;
+
+// SipHash-2-4 de data com a chave de 16 bytes
+uint64_t downlink_siphash(const uint8_t *key, const uint8_t *data, size_t len);
+
+void downlink_cmd_init(downlink_cmd_t *cmd);
+void downlink_cmd_set(downlink_cmd_t *cmd, downlink_tlv_t type, int32_t value);
+
+// Gateway: monta contador, TLVs e MAC para o destino dst no boot nonce da
+// estação. Retorna o tamanho ou 0 se os TLVs passarem de DOWNLINK_MAX_TLV_LEN.
+size_t downlink_build(const uint8_t *key, uint8_t net_id, uint8_t dst, uint32_t nonce,
+                      const downlink_cmd_t *cmd, uint8_t *out);
+
+// nonce: valor aleatório diferente de 0, novo a cada boot
+void downlink_rx_init(downlink_rx_t *d, const uint8_t *key, uint32_t nonce);
+
+// Estação: confere o MAC (antes de olhar os TLVs), o contador e os TLVs do
+// comando endereçado a dst; cmd só é preenchido com DOWNLINK_OK
+downlink_result_t downlink_rx_on_frame(downlink_rx_t *d, uint8_t net_id, uint8_t dst,
+                                       const uint8_t *data, size_t len, downlink_cmd_t *cmd);
+
+// Estação: status de src assinado; retorna DOWNLINK_STATUS_LEN
+size_t downlink_status_build(const uint8_t *key, uint8_t net_id, uint8_t src,
+                             const downlink_status_t *st, uint8_t *out);
+
+// Gateway: confere o MAC do status de src; st só é preenchido se for autêntico
+bool downlink_status_parse(const uint8_t *key, uint8_t net_id, uint8_t src,
+                           const uint8_t *data, size_t len, downlink_status_t *st);
+
+// Acréscimo na janela de RX após o uplink para caber o maior comando junto
+// com o ACK (0 com DOWNLINK_ENABLED desligado)
+uint32_t downlink_window_extra_us(const lora_modem_cfg_t *modem);
+
+#endif // DOWNLINK_H
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "cpu_load.h"
+#include "event_loop.h"
+
+static event_t queue[EVENT_QUEUE_LEN];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+static event_loop_stats_t stats;
+
+bool event_post(uint8_t type, uint32_t arg) {
+    uint32_t irq = save_and_disable_interrupts();
+    bool ok = head - tail < EVENT_QUEUE_LEN;
+    if (ok) {
+        event_t *e = &queue[head % EVENT_QUEUE_LEN];
+        e->type = type;
+        e->arg = arg;
+        e->post_us = time_us_32();
+        head++;
+    } else {
+        stats.dropped++;
+    }
+    restore_interrupts(irq);
+    return ok;
+}
+
+// Retira da fila; deve ser chamada com interrupções desabilitadas
+static bool pop_locked(event_t *evt) {
+    if (head == tail) {
+        return false;
+    }
+    *evt = queue[tail % EVENT_QUEUE_LEN];
+    tail++;
+
+    uint32_t latency = time_us_32() - evt->post_us;
+    stats.events++;
+    stats.sum_latency_us += latency;
+    if (latency > stats.max_latency_us) {
+        stats.max_latency_us = latency;
+    }
+    return true;
+}
+
+bool event_poll(event_t *evt) {
+    uint32_t irq = save_and_disable_interrupts();
+    bool ok = pop_locked(evt);
+    restore_interrupts(irq);
+    return ok;
+}
+
+void event_wait(event_t *evt) {
+    while (true) {
+        // A verificação e o WFI acontecem com interrupções mascaradas: uma
+        // interrupção pendente ainda acorda o núcleo, e a ISR roda ao restaurar.
+        uint32_t irq = save_and_disable_interrupts();
+        if (pop_locked(evt)) {
+            restore_interrupts(irq);
+            return;
+        }
+
+        cpu_load_idle_begin();
+        __wfi();
+        cpu_load_idle_end();
+        stats.wakeups++;
+        restore_interrupts(irq);
+    }
+}
+
+void event_loop_get_stats(event_loop_stats_t *out) {
+    uint32_t irq = save_and_disable_interrupts();
+    *out = stats;
+    restore_interrupts(irq);
+}
+
+void event_loop_print_stats(void) {
+    event_loop_stats_t s;
+    cpu_load_t load;
+
+    event_loop_get_stats(&s);
+    cpu_load_sample(get_core_num(), &load);
+
+    printf("Eventos: %lu (descartados %lu), despertares: %lu\n",
+           (unsigned long)s.events, (unsigned long)s.dropped, (unsigned long)s.wakeups);
+    printf("Latencia evento: media %lu us, max %lu us\n",
+           (unsigned long)(s.events ? s.sum_latency_us / s.events : 0),
+           (unsigned long)s.max_latency_us);
+    printf("CPU: ocupada %u%%, ociosa %lu us de %lu us\n",
+           load.busy_percent, (unsigned long)load.idle_us, (unsigned long)load.window_us);
+}
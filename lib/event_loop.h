@@ -0,0 +1,50 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "pico/stdlib.h"
+
+// Laço de eventos com WFI: cada fonte de despertar (DIO0, timers, botões,
+// DMA) publica um evento a partir da sua ISR e o núcleo dorme em WFI enquanto
+// a fila estiver vazia. A fila é de um único núcleo: publique apenas de ISRs
+// ou código do mesmo núcleo que chama event_wait.
+
+#define EVENT_QUEUE_LEN 16
+
+typedef enum {
+    EVT_NONE = 0,
+    EVT_DIO0,       // Borda de subida no DIO0 do rádio (TxDone/RxDone)
+    EVT_TIMER,      // Timer/alarme
+    EVT_BUTTON,     // Botão (arg = GPIO)
+    EVT_DMA,        // Conclusão de DMA (arg = canal)
+    EVT_USER        // Primeiro tipo livre para a aplicação
+} event_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint32_t arg;
+    uint32_t post_us;       // Instante da publicação (time_us_32)
+} event_t;
+
+typedef struct {
+    uint32_t events;        // Eventos entregues
+    uint32_t dropped;       // Eventos descartados por fila cheia
+    uint32_t wakeups;       // Saídas do WFI
+    uint32_t max_latency_us;// Maior atraso entre publicação e entrega
+    uint64_t sum_latency_us;
+} event_loop_stats_t;
+
+// Publica um evento (seguro em ISR); false se a fila estiver cheia
+bool event_post(uint8_t type, uint32_t arg);
+
+// Retira um evento sem bloquear; false se a fila estiver vazia
+bool event_poll(event_t *evt);
+
+// Bloqueia em WFI até haver um evento e o retira da fila
+void event_wait(event_t *evt);
+
+void event_loop_get_stats(event_loop_stats_t *out);
+
+// Imprime contadores, latência e uso da CPU (ocioso x ocupado) na serial
+void event_loop_print_stats(void);
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,47 @@
+#include <string.h>
+#include "fast_frame.h"
+
+void fast_frame_encode(const fast_frame_t *f, uint8_t *out) {
+    out[0] = f->net_id;
+    out[1] = f->src;
+    out[2] = f->seq;
+    out[3] = (uint8_t)((f->type << 4) | (f->flags & 0x0F));
+    memcpy(out + 4, f->data, FAST_FRAME_DATA_LEN);
+}
+
+bool fast_frame_decode(const uint8_t *in, size_t len, uint8_t net_id, fast_frame_t *f) {
+    if (len != FAST_FRAME_LEN || in[0] != net_id) {
+        return false;
+    }
+    f->net_id = in[0];
+    f->src = in[1];
+    f->seq = in[2];
+    f->type = in[3] >> 4;
+    f->flags = in[3] & 0x0F;
+    memcpy(f->data, in + 4, FAST_FRAME_DATA_LEN);
+    return true;
+}
+
+void fast_frame_alarm(fast_frame_t *f, uint8_t net_id, uint8_t src, uint8_t seq,
+                      uint8_t reasons, float temperature, float humidity) {
+    // Fora da faixa do campo satura em vez de dar a volta
+    float t = temperature * 10.0f;
+    int16_t t_x10 = t > 32767.0f ? 32767 : t < -32768.0f ? -32768 : (int16_t)(t < 0 ? t - 0.5f : t + 0.5f);
+    uint8_t hum = humidity <= 0.0f ? 0 : humidity >= 100.0f ? 100 : (uint8_t)(humidity + 0.5f);
+
+    memset(f, 0, sizeof(*f));
+    f->net_id = net_id;
+    f->src = src;
+    f->seq = seq;
+    f->type = FAST_FRAME_ALARM;
+    f->data[0] = reasons;
+    f->data[1] = hum;
+    f->data[2] = (uint8_t)t_x10;
+    f->data[3] = (uint8_t)((uint16_t)t_x10 >> 8);
+}
+
+void fast_frame_alarm_values(const fast_frame_t *f, uint8_t *reasons, float *temperature, float *humidity) {
+    *reasons = f->data[0];
+    *humidity = f->data[1];
+    *temperature = (int16_t)(f->data[2] | (f->data[3] << 8)) / 10.0f;
+}
@@ -0,0 +1,43 @@
+#ifndef FAST_FRAME_H
+#define FAST_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Quadro de tamanho fixo do modo rápido (SF6 com header implícito, ver
+// lora_set_fast_mode). Sem cabeçalho LoRa não há campo de tamanho: todo
+// quadro tem FAST_FRAME_LEN bytes e o receptor lê sempre esse tanto.
+//   [0] rede  [1] origem  [2] sequência  [3] tipo (4 bits) | flags (4 bits)  [4..7] dados
+// Sem dependência do SDK.
+
+#define FAST_FRAME_LEN          8
+#define FAST_FRAME_DATA_LEN     4
+
+typedef enum {
+    FAST_FRAME_ALARM = 0,   // Alarme da estação: [motivos][umidade %][temperatura x10 LE16]
+    FAST_FRAME_PING         // Teste de enlace (dados livres)
+} fast_frame_type_t;
+
+typedef struct {
+    uint8_t net_id;
+    uint8_t src;
+    uint8_t seq;
+    uint8_t type;           // fast_frame_type_t
+    uint8_t flags;
+    uint8_t data[FAST_FRAME_DATA_LEN];
+} fast_frame_t;
+
+void fast_frame_encode(const fast_frame_t *f, uint8_t *out);
+
+// false se o tamanho não for FAST_FRAME_LEN ou a rede for outra
+bool fast_frame_decode(const uint8_t *in, size_t len, uint8_t net_id, fast_frame_t *f);
+
+// Alarme: motivos (TX_REASON_*), umidade em % e temperatura em décimos de °C
+void fast_frame_alarm(fast_frame_t *f, uint8_t net_id, uint8_t src, uint8_t seq,
+                      uint8_t reasons, float temperature, float humidity);
+
+// Campos de um FAST_FRAME_ALARM
+void fast_frame_alarm_values(const fast_frame_t *f, uint8_t *reasons, float *temperature, float *humidity);
+
+#endif // FAST_FRAME_H
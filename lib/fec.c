@@ -0,0 +1,364 @@
+#include <string.h>
+#include <math.h>
+#include "fec.h"
+
+#define GF_POLY 0x11D           // x^8 + x^4 + x^3 + x^2 + 1, gerador 2
+
+// Tabelas em RAM: multiplicar é somar logaritmos (sem laço de bits no M0+).
+// gf_exp tem 510 entradas para dispensar o módulo 255 na soma.
+static uint8_t gf_exp[510];
+static uint8_t gf_log[256];
+
+void fec_init(void) {
+    uint16_t x = 1;
+    for (int i = 0; i < 255; i++) {
+        gf_exp[i] = (uint8_t)x;
+        gf_exp[i + 255] = (uint8_t)x;
+        gf_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100) {
+            x ^= GF_POLY;
+        }
+    }
+}
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static inline uint8_t gf_inv(uint8_t a) {
+    return gf_exp[255 - gf_log[a]];
+}
+
+// dst ^= c * src (byte a byte)
+static void gf_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len) {
+    if (c == 0) {
+        return;
+    }
+    uint8_t lc = gf_log[c];
+    for (size_t i = 0; i < len; i++) {
+        if (src[i]) {
+            dst[i] ^= gf_exp[gf_log[src[i]] + lc];
+        }
+    }
+}
+
+// Coeficiente da paridade j sobre o dado i: 1 / (x_j + y_i), com
+// x_j = FEC_MAX_DATA + j e y_i = i (conjuntos disjuntos). Toda submatriz
+// quadrada de uma matriz de Cauchy é inversível, então quaisquer N quadros
+// bastam.
+static inline uint8_t cauchy(uint8_t j, uint8_t i) {
+    return gf_inv((uint8_t)((FEC_MAX_DATA + j) ^ i));
+}
+
+uint8_t fec_parity_for_loss(uint8_t n, uint8_t loss_percent, uint8_t k_max) {
+    if (loss_percent == 0) {
+        return 0;
+    }
+    if (loss_percent >= 100) {
+        return k_max;
+    }
+    float p = loss_percent / 100.0f;
+    for (uint8_t k = 0; k < k_max; k++) {
+        // P(perdas <= k) entre n + k quadros (binomial)
+        int total = n + k;
+        float term = powf(1.0f - p, (float)total);
+        float ok = term;
+        for (int x = 0; x < k; x++) {
+            term *= (float)(total - x) / (float)(x + 1) * p / (1.0f - p);
+            ok += term;
+        }
+        if (1.0f - ok < FEC_TARGET_LOSS) {
+            return k;
+        }
+    }
+    return k_max;
+}
+
+bool fec_tx_begin(fec_tx_t *t, uint8_t block, uint8_t n, uint8_t k) {
+    if (n == 0 || n > FEC_MAX_DATA || k > FEC_MAX_PARITY) {
+        return false;
+    }
+    t->block = block;
+    t->n = n;
+    t->k = k;
+    t->added = 0;
+    t->next_parity = 0;
+    t->symbol_len = 0;
+    memset(t->parity, 0, (size_t)k * FEC_MAX_SYMBOL);
+    return true;
+}
+
+bool fec_tx_data_done(const fec_tx_t *t) {
+    return t->added >= t->n;
+}
+
+bool fec_tx_done(const fec_tx_t *t) {
+    return fec_tx_data_done(t) && t->next_parity >= t->k;
+}
+
+static void put_header(uint8_t *out, const fec_tx_t *t, uint8_t index) {
+    out[0] = t->block;
+    out[1] = index;
+    out[2] = t->n;
+    out[3] = t->k;
+}
+
+size_t fec_tx_add(fec_tx_t *t, const uint8_t *data, size_t len, uint8_t *out) {
+    if (fec_tx_data_done(t) || len > FEC_MAX_DATA_LEN) {
+        return 0;
+    }
+    uint8_t i = t->added++;
+    // A paridade acumula o símbolo [tamanho][dados]; os zeros de
+    // preenchimento não contribuem
+    for (uint8_t j = 0; j < t->k; j++) {
+        uint8_t c = cauchy(j, i);
+        t->parity[j][0] ^= gf_mul(c, (uint8_t)len);
+        gf_mul_add(&t->parity[j][1], data, c, len);
+    }
+    if (len + 1 > t->symbol_len) {
+        t->symbol_len = (uint8_t)(len + 1);
+    }
+
+    put_header(out, t, i);
+    out[FEC_HEADER_LEN] = (uint8_t)len;
+    memcpy(out + FEC_HEADER_LEN + 1, data, len);
+    return FEC_HEADER_LEN + 1 + len;
+}
+
+size_t fec_tx_next_parity(fec_tx_t *t, uint8_t *out) {
+    if (!fec_tx_data_done(t) || t->next_parity >= t->k) {
+        return 0;
+    }
+    uint8_t j = t->next_parity++;
+    put_header(out, t, (uint8_t)(t->n + j));
+    memcpy(out + FEC_HEADER_LEN, t->parity[j], t->symbol_len);
+    return FEC_HEADER_LEN + t->symbol_len;
+}
+
+void fec_rx_init(fec_rx_t *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+void fec_rx_expire(fec_rx_t *r, uint32_t now_us) {
+    for (int i = 0; i < FEC_RX_SLOTS; i++) {
+        fec_block_t *b = &r->slots[i];
+        // A lembrança de um bloco entregue também expira: o número do bloco
+        // dá a volta e a origem pode reiniciar
+        if ((b->active || b->delivered) && now_us - b->last_us > FEC_TIMEOUT_US) {
+            if (b->active) {
+                r->stats.lost_blocks++;
+            }
+            b->active = false;
+            b->delivered = false;
+        }
+    }
+}
+
+// Inverte a matriz m x m em a (Gauss-Jordan); false se singular
+static bool gf_invert(uint8_t a[FEC_MAX_PARITY][FEC_MAX_PARITY], uint8_t inv[FEC_MAX_PARITY][FEC_MAX_PARITY], uint8_t m) {
+    for (uint8_t r = 0; r < m; r++) {
+        for (uint8_t c = 0; c < m; c++) {
+            inv[r][c] = r == c;
+        }
+    }
+    for (uint8_t col = 0; col < m; col++) {
+        uint8_t piv = col;
+        while (piv < m && a[piv][col] == 0) {
+            piv++;
+        }
+        if (piv == m) {
+            return false;
+        }
+        if (piv != col) {
+            for (uint8_t c = 0; c < m; c++) {
+                uint8_t t = a[col][c]; a[col][c] = a[piv][c]; a[piv][c] = t;
+                t = inv[col][c]; inv[col][c] = inv[piv][c]; inv[piv][c] = t;
+            }
+        }
+        uint8_t s = gf_inv(a[col][col]);
+        for (uint8_t c = 0; c < m; c++) {
+            a[col][c] = gf_mul(a[col][c], s);
+            inv[col][c] = gf_mul(inv[col][c], s);
+        }
+        for (uint8_t r = 0; r < m; r++) {
+            uint8_t f = a[r][col];
+            if (r == col || f == 0) {
+                continue;
+            }
+            for (uint8_t c = 0; c < m; c++) {
+                a[r][c] ^= gf_mul(f, a[col][c]);
+                inv[r][c] ^= gf_mul(f, inv[col][c]);
+            }
+        }
+    }
+    return true;
+}
+
+// Reconstrói os dados que faltam a partir das paridades recebidas. As
+// síndromes são calculadas no lugar das próprias paridades (o bloco termina
+// aqui), sem buffers extras na pilha.
+static bool block_decode(fec_block_t *b, uint8_t *missing, uint8_t m) {
+    uint8_t rows[FEC_MAX_PARITY];
+    uint8_t got = 0;
+    for (uint8_t j = 0; j < b->k && got < m; j++) {
+        if (b->mask & (1u << (b->n + j))) {
+            rows[got++] = j;
+        }
+    }
+    if (got < m) {
+        return false;
+    }
+
+    uint8_t a[FEC_MAX_PARITY][FEC_MAX_PARITY];
+    uint8_t inv[FEC_MAX_PARITY][FEC_MAX_PARITY];
+    for (uint8_t r = 0; r < m; r++) {
+        for (uint8_t c = 0; c < m; c++) {
+            a[r][c] = cauchy(rows[r], missing[c]);
+        }
+    }
+    if (!gf_invert(a, inv, m)) {
+        return false;
+    }
+
+    // Síndrome: paridade menos a contribuição dos dados conhecidos
+    for (uint8_t r = 0; r < m; r++) {
+        uint8_t *s = b->sym[b->n + rows[r]];
+        for (uint8_t i = 0; i < b->n; i++) {
+            if (b->mask & (1u << i)) {
+                gf_mul_add(s, b->sym[i], cauchy(rows[r], i), b->symbol_len);
+            }
+        }
+    }
+    for (uint8_t c = 0; c < m; c++) {
+        uint8_t *d = b->sym[missing[c]];
+        memset(d, 0, FEC_MAX_SYMBOL);
+        for (uint8_t r = 0; r < m; r++) {
+            gf_mul_add(d, b->sym[b->n + rows[r]], inv[c][r], b->symbol_len);
+        }
+    }
+    return true;
+}
+
+static void output_add(fec_output_t *out, fec_block_t *b, uint8_t i) {
+    out->index[out->count] = i;
+    out->data[out->count] = &b->sym[i][1];
+    out->len[out->count] = b->sym[i][0];
+    out->count++;
+}
+
+uint8_t fec_rx_on_frame(fec_rx_t *r, uint8_t src, const uint8_t *frame, size_t len,
+                        uint32_t now_us, fec_output_t *out) {
+    out->count = 0;
+    fec_rx_expire(r, now_us);
+    r->stats.frames++;
+
+    if (len <= FEC_HEADER_LEN || len - FEC_HEADER_LEN > FEC_MAX_SYMBOL) {
+        r->stats.invalid++;
+        return 0;
+    }
+    uint8_t block = frame[0];
+    uint8_t index = frame[1];
+    uint8_t n = frame[2];
+    uint8_t k = frame[3];
+    uint8_t sym_len = (uint8_t)(len - FEC_HEADER_LEN);
+    if (n == 0 || n > FEC_MAX_DATA || k > FEC_MAX_PARITY || index >= n + k ||
+        (index < n && frame[FEC_HEADER_LEN] != sym_len - 1)) {
+        r->stats.invalid++;
+        return 0;
+    }
+
+    fec_block_t *b = NULL;
+    fec_block_t *free_slot = NULL;
+    for (int i = 0; i < FEC_RX_SLOTS; i++) {
+        fec_block_t *c = &r->slots[i];
+        if (c->src == src && c->block == block && (c->active || c->delivered)) {
+            b = c;
+            break;
+        }
+        if (!c->active && (!free_slot || (free_slot->delivered && !c->delivered))) {
+            free_slot = c;
+        }
+    }
+    if (b && !b->active) {
+        r->stats.duplicates++;
+        return 0;
+    }
+    if (b && (b->n != n || b->k != k)) {
+        // Mesmo número de bloco com outro formato: a origem reiniciou
+        b->active = false;
+        free_slot = b;
+        b = NULL;
+    }
+    if (!b) {
+        if (!free_slot) {
+            // Sem slot livre: descarta o bloco parado há mais tempo
+            free_slot = &r->slots[0];
+            for (int i = 1; i < FEC_RX_SLOTS; i++) {
+                if ((int32_t)(r->slots[i].last_us - free_slot->last_us) < 0) {
+                    free_slot = &r->slots[i];
+                }
+            }
+            r->stats.lost_blocks++;
+        }
+        b = free_slot;
+        b->active = true;
+        b->delivered = false;
+        b->src = src;
+        b->block = block;
+        b->n = n;
+        b->k = k;
+        b->received = 0;
+        b->mask = 0;
+        b->symbol_len = 0;
+    }
+
+    b->last_us = now_us;
+    if (b->mask & (1u << index)) {
+        r->stats.duplicates++;
+        return 0;
+    }
+    memcpy(b->sym[index], frame + FEC_HEADER_LEN, sym_len);
+    memset(b->sym[index] + sym_len, 0, FEC_MAX_SYMBOL - sym_len);
+    b->mask |= 1u << index;
+    b->received++;
+    if (sym_len > b->symbol_len) {
+        b->symbol_len = sym_len;
+    }
+    if (index < n) {
+        output_add(out, b, index);
+    }
+
+    uint32_t data_mask = (1u << n) - 1;
+    if ((b->mask & data_mask) != data_mask) {
+        if (b->received < n) {
+            return out->count;
+        }
+        uint8_t missing[FEC_MAX_PARITY];
+        uint8_t m = 0;
+        for (uint8_t i = 0; i < n && m < FEC_MAX_PARITY; i++) {
+            if (!(b->mask & (1u << i))) {
+                missing[m++] = i;
+            }
+        }
+        if (!block_decode(b, missing, m)) {
+            return out->count;
+        }
+        for (uint8_t c = 0; c < m; c++) {
+            if (b->sym[missing[c]][0] < b->symbol_len) {
+                output_add(out, b, missing[c]);
+                r->stats.recovered++;
+            } else {
+                r->stats.invalid++;
+            }
+        }
+    }
+
+    b->active = false;
+    b->delivered = true;
+    r->stats.blocks++;
+    return out->count;
+}
@@ -0,0 +1,105 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Correção de perdas entre quadros (código de apagamento Reed-Solomon sobre
+// GF(256), matriz de Cauchy). Para cada bloco de N quadros de dados o
+// remetente envia K quadros de paridade; quaisquer N dos N+K recuperam os
+// dados. O código é sistemático: os quadros de dados vão como estão e o
+// receptor os entrega na hora, decodificando só os que faltarem.
+//
+// Cabeçalho de cada quadro: [0] bloco  [1] índice (0..N-1 dados, N..N+K-1 paridade)  [2] N  [3] K
+// Cada quadro de dados é codificado como [tamanho][dados] e completado com
+// zeros até o maior do bloco, que é o tamanho dos quadros de paridade.
+// Sem dependência do SDK.
+
+#define FEC_HEADER_LEN      4
+#define FEC_MAX_DATA        16      // N máximo por bloco
+#define FEC_MAX_PARITY      8       // K máximo por bloco
+#define FEC_MAX_SYMBOL      245     // ARQ_MAX_PAYLOAD - FEC_HEADER_LEN
+#define FEC_MAX_DATA_LEN    (FEC_MAX_SYMBOL - 1)    // Maior quadro de dados protegido
+#define FEC_RX_SLOTS        2       // Blocos decodificados ao mesmo tempo
+#define FEC_TIMEOUT_US      30000000
+#define FEC_TARGET_LOSS     0.01f   // Perda de bloco aceita ao escolher K
+
+typedef struct {
+    uint8_t block;
+    uint8_t n;
+    uint8_t k;
+    uint8_t added;          // Quadros de dados já codificados
+    uint8_t next_parity;
+    uint8_t symbol_len;     // Maior símbolo do bloco até agora
+    uint8_t parity[FEC_MAX_PARITY][FEC_MAX_SYMBOL];
+} fec_tx_t;
+
+typedef struct {
+    bool active;
+    bool delivered;         // Livre, mas lembra o último bloco concluído (src, bloco)
+    uint8_t src;
+    uint8_t block;
+    uint8_t n;
+    uint8_t k;
+    uint8_t received;
+    uint8_t symbol_len;
+    uint32_t mask;          // bit i: quadro i do bloco recebido
+    uint32_t last_us;
+    uint8_t sym[FEC_MAX_DATA + FEC_MAX_PARITY][FEC_MAX_SYMBOL];
+} fec_block_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t blocks;        // Blocos com todos os dados entregues
+    uint32_t recovered;     // Quadros de dados reconstruídos pela paridade
+    uint32_t duplicates;
+    uint32_t invalid;
+    uint32_t lost_blocks;   // Blocos expirados sem N quadros
+} fec_rx_stats_t;
+
+typedef struct {
+    fec_block_t slots[FEC_RX_SLOTS];
+    fec_rx_stats_t stats;
+} fec_rx_t;
+
+// Quadros de dados entregues por uma chamada de fec_rx_on_frame(). Os
+// ponteiros valem até a próxima chamada.
+typedef struct {
+    uint8_t count;
+    uint8_t index[FEC_MAX_DATA];
+    const uint8_t *data[FEC_MAX_DATA];
+    uint8_t len[FEC_MAX_DATA];
+} fec_output_t;
+
+// Gera as tabelas de log/antilog de GF(256) (chamar uma vez no início)
+void fec_init(void);
+
+// Menor K (até k_max) que mantém a perda de bloco abaixo de FEC_TARGET_LOSS
+// com perda independente de loss_percent por quadro
+uint8_t fec_parity_for_loss(uint8_t n, uint8_t loss_percent, uint8_t k_max);
+
+// Inicia um bloco de n quadros de dados e k de paridade
+bool fec_tx_begin(fec_tx_t *t, uint8_t block, uint8_t n, uint8_t k);
+
+// Codifica o próximo quadro de dados (até FEC_MAX_DATA_LEN bytes) e monta em
+// out o quadro a transmitir; retorna o tamanho ou 0 se o bloco já tem n dados
+size_t fec_tx_add(fec_tx_t *t, const uint8_t *data, size_t len, uint8_t *out);
+
+// Depois dos n dados: monta o próximo quadro de paridade (0 quando acabarem)
+size_t fec_tx_next_parity(fec_tx_t *t, uint8_t *out);
+
+bool fec_tx_data_done(const fec_tx_t *t);
+bool fec_tx_done(const fec_tx_t *t);
+
+void fec_rx_init(fec_rx_t *r);
+
+// Processa um quadro FEC de src: entrega em out os quadros de dados novos
+// (recebidos ou reconstruídos). Retorna out->count.
+uint8_t fec_rx_on_frame(fec_rx_t *r, uint8_t src, const uint8_t *frame, size_t len,
+                        uint32_t now_us, fec_output_t *out);
+
+// Libera os blocos parados há mais de FEC_TIMEOUT_US
+void fec_rx_expire(fec_rx_t *r, uint32_t now_us);
+
+#endif // FEC_H
@@ -0,0 +1,157 @@
+#include <string.h>
+#include "frag.h"
+
+// Fragmentos de tamanho igual: chunk = ceil(len / count). O receptor refaz a
+// mesma conta a partir do cabeçalho.
+static uint16_t frag_chunk(uint16_t len, uint8_t count) {
+    return (uint16_t)((len + count - 1) / count);
+}
+
+int frag_tx_begin(frag_tx_t *t, uint8_t id, const uint8_t *data, size_t len, size_t max_frag_len) {
+    if (len == 0 || len > FRAG_MAX_MESSAGE || max_frag_len <= FRAG_HEADER_LEN) {
+        return -1;
+    }
+    size_t max_chunk = max_frag_len - FRAG_HEADER_LEN;
+    size_t count = (len + max_chunk - 1) / max_chunk;
+    if (count > FRAG_MAX_FRAGMENTS) {
+        return -1;
+    }
+    t->data = data;
+    t->len = (uint16_t)len;
+    t->id = id;
+    t->count = (uint8_t)count;
+    t->chunk = frag_chunk(t->len, t->count);
+    t->next = 0;
+    return (int)count;
+}
+
+bool frag_tx_done(const frag_tx_t *t) {
+    return t->next >= t->count;
+}
+
+size_t frag_tx_next(frag_tx_t *t, uint8_t *out) {
+    if (frag_tx_done(t)) {
+        return 0;
+    }
+    uint16_t offset = (uint16_t)(t->next * t->chunk);
+    uint16_t n = t->len - offset < t->chunk ? t->len - offset : t->chunk;
+
+    out[0] = t->id;
+    out[1] = t->next;
+    out[2] = t->count;
+    out[3] = (uint8_t)t->len;
+    out[4] = (uint8_t)(t->len >> 8);
+    memcpy(out + FRAG_HEADER_LEN, t->data + offset, n);
+    t->next++;
+    return FRAG_HEADER_LEN + n;
+}
+
+void frag_rx_init(frag_rx_t *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+void frag_rx_expire(frag_rx_t *r, uint32_t now_us) {
+    for (int i = 0; i < FRAG_RX_SLOTS; i++) {
+        frag_slot_t *s = &r->slots[i];
+        // A lembrança de uma mensagem entregue também expira (o id dá a volta)
+        if ((s->active || s->delivered) && now_us - s->last_us > FRAG_TIMEOUT_US) {
+            if (s->active) {
+                r->stats.timeouts++;
+            }
+            s->active = false;
+            s->delivered = false;
+        }
+    }
+}
+
+frag_rx_result_t frag_rx_on_fragment(frag_rx_t *r, uint8_t src, const uint8_t *frag, size_t len,
+                                     uint32_t now_us, frag_message_t *msg) {
+    frag_rx_expire(r, now_us);
+    r->stats.fragments++;
+
+    if (len <= FRAG_HEADER_LEN) {
+        r->stats.invalid++;
+        return FRAG_RX_INVALID;
+    }
+    uint8_t id = frag[0];
+    uint8_t index = frag[1];
+    uint8_t count = frag[2];
+    uint16_t msg_len = (uint16_t)(frag[3] | (frag[4] << 8));
+    if (count == 0 || count > FRAG_MAX_FRAGMENTS || index >= count ||
+        msg_len < count || msg_len > FRAG_MAX_MESSAGE) {
+        r->stats.invalid++;
+        return FRAG_RX_INVALID;
+    }
+    uint16_t chunk = frag_chunk(msg_len, count);
+    uint16_t offset = (uint16_t)(index * chunk);
+    uint16_t expected = msg_len - offset < chunk ? msg_len - offset : chunk;
+    if (offset >= msg_len || len - FRAG_HEADER_LEN != expected) {
+        r->stats.invalid++;
+        return FRAG_RX_INVALID;
+    }
+
+    // Slot da mensagem em andamento, ou um livre (preferindo os que não
+    // guardam a lembrança de uma entrega)
+    frag_slot_t *s = NULL;
+    frag_slot_t *free_slot = NULL;
+    for (int i = 0; i < FRAG_RX_SLOTS; i++) {
+        frag_slot_t *c = &r->slots[i];
+        if (c->src == src && c->id == id && (c->active || c->delivered)) {
+            s = c;
+            break;
+        }
+        if (!c->active && (!free_slot || (free_slot->delivered && !c->delivered))) {
+            free_slot = c;
+        }
+    }
+
+    if (s && !s->active) {
+        // Retransmissão de uma mensagem já entregue
+        r->stats.duplicates++;
+        return FRAG_RX_DUPLICATE;
+    }
+    if (s && (s->count != count || s->len != msg_len)) {
+        // Mesmo id com outro formato: a origem reiniciou, recomeça a remontagem
+        s->active = false;
+        free_slot = s;
+        s = NULL;
+    }
+    if (!s) {
+        if (!free_slot) {
+            r->stats.no_slot++;
+            return FRAG_RX_NO_SLOT;
+        }
+        s = free_slot;
+        s->active = true;
+        s->delivered = false;
+        s->src = src;
+        s->id = id;
+        s->count = count;
+        s->len = msg_len;
+        s->chunk = chunk;
+        s->received = 0;
+        s->bitmap = 0;
+    }
+
+    s->last_us = now_us;
+    if (s->bitmap & (1u << index)) {
+        r->stats.duplicates++;
+        return FRAG_RX_DUPLICATE;
+    }
+    memcpy(s->data + offset, frag + FRAG_HEADER_LEN, expected);
+    s->bitmap |= 1u << index;
+    s->received++;
+    if (s->received < s->count) {
+        return FRAG_RX_PARTIAL;
+    }
+
+    s->active = false;
+    s->delivered = true;
+    r->stats.messages++;
+    r->stats.bytes += s->len;
+    msg->src = s->src;
+    msg->id = s->id;
+    msg->data = s->data;
+    msg->len = s->len;
+    return FRAG_RX_COMPLETE;
+}
@@ -0,0 +1,96 @@
+#ifndef FRAG_H
+#define FRAG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Fragmentação de mensagens maiores que um quadro (histórico, configuração,
+// diagnósticos). Cada fragmento leva um cabeçalho de 5 bytes:
+//   [0] id da mensagem  [1] índice  [2] total de fragmentos  [3..4] tamanho da mensagem (LE)
+// Todos os fragmentos têm o mesmo tamanho (o último pode ser menor), então o
+// receptor calcula a posição de cada um e copia direto para o buffer do slot:
+// a remontagem é feita no lugar, aceita fragmentos fora de ordem e não aloca
+// memória. Sem dependência do SDK.
+
+#define FRAG_HEADER_LEN     5
+#define FRAG_MAX_FRAGMENTS  32      // Largura do bitmap de fragmentos recebidos
+#define FRAG_MAX_MESSAGE    4096    // Maior mensagem remontada (buffer de cada slot)
+#define FRAG_RX_SLOTS       2       // Mensagens remontadas ao mesmo tempo
+#define FRAG_TIMEOUT_US     30000000 // Slot sem fragmento novo por esse tempo é liberado
+
+typedef struct {
+    const uint8_t *data;    // Mensagem do chamador (precisa existir até o último fragmento)
+    uint16_t len;
+    uint16_t chunk;         // Bytes de mensagem por fragmento
+    uint8_t id;
+    uint8_t count;
+    uint8_t next;           // Próximo fragmento a gerar
+} frag_tx_t;
+
+typedef enum {
+    FRAG_RX_PARTIAL = 0,    // Fragmento guardado, mensagem incompleta
+    FRAG_RX_COMPLETE,       // Último fragmento: mensagem pronta em msg
+    FRAG_RX_DUPLICATE,      // Fragmento já recebido (ou de mensagem já entregue)
+    FRAG_RX_INVALID,        // Cabeçalho inconsistente ou mensagem grande demais
+    FRAG_RX_NO_SLOT         // Todos os slots ocupados por outras mensagens
+} frag_rx_result_t;
+
+typedef struct {
+    bool active;
+    bool delivered;         // Livre, mas lembra a última mensagem entregue (src, id)
+    uint8_t src;
+    uint8_t id;
+    uint8_t count;
+    uint8_t received;
+    uint16_t len;
+    uint16_t chunk;
+    uint32_t bitmap;        // bit i: fragmento i recebido
+    uint32_t last_us;
+    uint8_t data[FRAG_MAX_MESSAGE];
+} frag_slot_t;
+
+typedef struct {
+    uint32_t fragments;
+    uint32_t messages;
+    uint32_t bytes;         // Bytes de mensagens completas
+    uint32_t duplicates;
+    uint32_t invalid;
+    uint32_t no_slot;
+    uint32_t timeouts;      // Mensagens abandonadas incompletas
+} frag_rx_stats_t;
+
+typedef struct {
+    frag_slot_t slots[FRAG_RX_SLOTS];
+    frag_rx_stats_t stats;
+} frag_rx_t;
+
+// Mensagem remontada: data aponta para o buffer do slot e vale até a próxima
+// chamada de frag_rx_on_fragment()
+typedef struct {
+    uint8_t src;
+    uint8_t id;
+    const uint8_t *data;
+    uint16_t len;
+} frag_message_t;
+
+// Prepara o envio de data em fragmentos de até max_frag_len bytes (cabeçalho
+// incluso). Retorna o número de fragmentos ou -1 se a mensagem não couber.
+int frag_tx_begin(frag_tx_t *t, uint8_t id, const uint8_t *data, size_t len, size_t max_frag_len);
+
+// Monta o próximo fragmento em out; retorna o tamanho ou 0 se já acabaram
+size_t frag_tx_next(frag_tx_t *t, uint8_t *out);
+
+bool frag_tx_done(const frag_tx_t *t);
+
+void frag_rx_init(frag_rx_t *r);
+
+// Guarda um fragmento recebido de src. Em FRAG_RX_COMPLETE preenche msg e
+// libera o slot.
+frag_rx_result_t frag_rx_on_fragment(frag_rx_t *r, uint8_t src, const uint8_t *frag, size_t len,
+                                     uint32_t now_us, frag_message_t *msg);
+
+// Libera os slots parados há mais de FRAG_TIMEOUT_US
+void frag_rx_expire(frag_rx_t *r, uint32_t now_us);
+
+#endif // FRAG_H
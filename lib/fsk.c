@@ -0,0 +1,229 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "sx1276.h"
+#include "fsk.h"
+
+// Taxa = FXOSC / (BitRate + BitRateFrac / 16); Fdev = FdevReg * FXOSC / 2^19
+#define BITRATE_X16     ((uint32_t)(FSK_FXOSC_HZ * 16LL / FSK_BITRATE_BPS))
+#define BITRATE_REG     (BITRATE_X16 >> 4)
+#define FDEV_REG        ((uint32_t)(FSK_FDEV_HZ * 524288LL / FSK_FXOSC_HZ))
+
+// Endereços crescentes para agrupar em rajadas (DEVE SER IGUAL NO TX E NO RX)
+static const lora_reg_val_t profile_fsk[] = {
+    { REG_BITRATE_MSB,          (uint8_t)(BITRATE_REG >> 8) },
+    { REG_BITRATE_LSB,          (uint8_t)BITRATE_REG },
+    { REG_FDEV_MSB,             (uint8_t)(FDEV_REG >> 8) },
+    { REG_FDEV_LSB,             (uint8_t)FDEV_REG },
+    { REG_PA_RAMP,              0x29 },     // Gaussiano BT = 1,0 (GFSK), rampa de 40 us
+    { REG_RX_CONFIG_FSK,        0x0E },     // AGC automático, disparado pelo preâmbulo
+    { REG_RX_BW_FSK,            FSK_RX_BW },
+    { REG_AFC_BW_FSK,           FSK_RX_BW },
+    { REG_PREAMBLE_DETECT_FSK,  0xAA },     // Detector ligado: 2 bytes, tolerância de 10 chips
+    { REG_PREAMBLE_MSB_FSK,     0 },
+    { REG_PREAMBLE_LSB_FSK,     FSK_PREAMBLE_LEN },
+    { REG_SYNC_CONFIG_FSK,      0x50 | (FSK_SYNC_LEN - 1) },   // RX reinicia sozinho após o pacote
+    { REG_SYNC_VALUE1_FSK,      0x2D },
+    { REG_SYNC_VALUE1_FSK + 1,  0xD4 },
+    { REG_SYNC_VALUE1_FSK + 2,  0x45 },
+    { REG_SYNC_VALUE1_FSK + 3,  0x4D },
+    { REG_PACKET_CONFIG1,       0xD8 },     // Tamanho variável, whitening, CRC (mantido mesmo se errado)
+    { REG_PACKET_CONFIG2,       0x40 },     // Modo pacote
+    { REG_PAYLOAD_LENGTH_FSK,   FSK_MAX_PAYLOAD },
+    { REG_FIFO_THRESH,          0x80 | FSK_FIFO_THRESHOLD },   // TX começa com a FIFO não vazia
+    { REG_DIO_MAPPING_1,        0x00 },     // DIO0 -> PacketSent/PayloadReady, DIO1 -> FifoLevel
+    { REG_BITRATE_FRAC,         (uint8_t)(BITRATE_X16 & 0x0F) },
+};
+
+void fsk_init(fsk_t *f, lora_dev_t *dev) {
+    memset(f, 0, sizeof(*f));
+    f->dev = dev;
+    f->rx_len = -1;
+}
+
+bool fsk_begin(fsk_t *f) {
+    if (!lora_set_long_range(f->dev, false)) {
+        return false;
+    }
+    lora_apply_regs(f->dev, profile_fsk, sizeof(profile_fsk) / sizeof(profile_fsk[0]));
+    return true;
+}
+
+bool fsk_end(fsk_t *f) {
+    f->tx_data = NULL;
+    f->rx_len = -1;
+    return lora_set_long_range(f->dev, true);
+}
+
+uint32_t fsk_airtime_us(uint8_t len) {
+    uint32_t bytes = FSK_PREAMBLE_LEN + FSK_SYNC_LEN + 1 + len + FSK_CRC_LEN;
+    return (uint32_t)((uint64_t)bytes * 8 * 1000000 / FSK_BITRATE_BPS);
+}
+
+// Escrever FifoOverrun limpa a FIFO e as flags
+static void fifo_clear(fsk_t *f) {
+    lora_write_reg(f->dev, REG_IRQ_FLAGS2, IRQ2_FIFO_OVERRUN);
+}
+
+void fsk_start_tx(fsk_t *f, const uint8_t *data, uint8_t len) {
+    uint8_t first[FSK_FIFO_LEN];
+    uint8_t n = len < FSK_FIFO_LEN - 1 ? len : FSK_FIFO_LEN - 1;
+
+    lora_write_reg(f->dev, REG_OPMODE, FSK_MODE_STANDBY);
+    fifo_clear(f);
+
+    // Tamanho e o começo do payload numa única transação
+    first[0] = len;
+    memcpy(first + 1, data, n);
+    f->tx_data = data;
+    f->tx_len = len;
+    f->tx_next = n;
+    lora_write_fifo(f->dev, first, n + 1);
+    lora_write_reg(f->dev, REG_OPMODE, FSK_MODE_TX);
+}
+
+void fsk_tx_refill(fsk_t *f) {
+    // Com o FifoLevel baixo há no máximo FSK_FIFO_THRESHOLD bytes na FIFO.
+    // Se a ISR atrasou, o nível segue baixo e o laço recarrega de novo.
+    while (f->tx_data && f->tx_next < f->tx_len &&
+           !(lora_read_reg(f->dev, REG_IRQ_FLAGS2) & IRQ2_FIFO_LEVEL)) {
+        uint8_t n = f->tx_len - f->tx_next;
+        if (n > FSK_FIFO_LEN - FSK_FIFO_THRESHOLD - 1) {
+            n = FSK_FIFO_LEN - FSK_FIFO_THRESHOLD - 1;
+        }
+        lora_write_fifo(f->dev, f->tx_data + f->tx_next, n);
+        f->tx_next += n;
+        f->stats.tx_refills++;
+    }
+}
+
+void fsk_tx_finish(fsk_t *f) {
+    // No FSK o TX não volta sozinho para Standby
+    lora_write_reg(f->dev, REG_OPMODE, FSK_MODE_STANDBY);
+    f->tx_data = NULL;
+    f->stats.tx_frames++;
+}
+
+void fsk_start_rx(fsk_t *f) {
+    f->rx_len = -1;
+    lora_write_reg(f->dev, REG_OPMODE, FSK_MODE_STANDBY);
+    fifo_clear(f);
+    lora_write_reg(f->dev, REG_OPMODE, FSK_MODE_RX);
+}
+
+static uint8_t *rx_buffer(fsk_t *f) {
+    return f->rx_full ? f->rx_discard : f->rx_slots[f->rx_head % FSK_RX_SLOTS].data;
+}
+
+// Primeiro byte do pacote: o tamanho. O RSSI é lido com o pacote ainda no ar.
+static void rx_begin(fsk_t *f) {
+    uint8_t len;
+    lora_read_fifo(f->dev, &len, 1);
+    f->rx_len = len;
+    f->rx_count = 0;
+    f->rx_rssi = -(int16_t)(lora_read_reg(f->dev, REG_RSSI_VALUE_FSK) / 2);
+    f->rx_full = f->rx_head - f->rx_tail >= FSK_RX_SLOTS;
+}
+
+// FIFO transbordou: o resto do pacote se perdeu. Limpa a FIFO e reinicia o
+// receptor para não tomar o meio do pacote pelo começo do próximo.
+static void rx_overrun(fsk_t *f) {
+    f->stats.rx_overruns++;
+    f->rx_len = -1;
+    fifo_clear(f);
+    lora_write_reg(f->dev, REG_RX_CONFIG_FSK, 0x0E | 0x40);     // RestartRxWithoutPllLock
+}
+
+void fsk_rx_drain(fsk_t *f) {
+    while (true) {
+        uint8_t flags = lora_read_reg(f->dev, REG_IRQ_FLAGS2);
+        if (flags & IRQ2_FIFO_OVERRUN) {
+            rx_overrun(f);
+            return;
+        }
+        if (!(flags & IRQ2_FIFO_LEVEL)) {
+            return;
+        }
+        // Há ao menos FSK_FIFO_THRESHOLD + 1 bytes. O último byte do pacote
+        // fica para o PayloadReady, que é apagado com a FIFO vazia.
+        uint8_t avail = FSK_FIFO_THRESHOLD + 1;
+        if (f->rx_len < 0) {
+            rx_begin(f);
+            avail--;
+        }
+        if (f->rx_count + 1 >= f->rx_len) {
+            return;
+        }
+        uint8_t n = f->rx_len - f->rx_count - 1;
+        if (n > avail) {
+            n = avail;
+        }
+        lora_read_fifo(f->dev, rx_buffer(f) + f->rx_count, n);
+        f->rx_count += n;
+    }
+}
+
+bool fsk_rx_finish(fsk_t *f) {
+    // CrcOk é apagado quando a FIFO esvazia: lido antes do resto do pacote
+    uint8_t flags = lora_read_reg(f->dev, REG_IRQ_FLAGS2);
+    if (flags & IRQ2_FIFO_OVERRUN) {
+        rx_overrun(f);
+        return false;
+    }
+    if (!(flags & IRQ2_PAYLOAD_READY)) {
+        return false;
+    }
+    if (f->rx_len < 0) {
+        rx_begin(f);
+    }
+    if (f->rx_count < f->rx_len) {
+        lora_read_fifo(f->dev, rx_buffer(f) + f->rx_count, f->rx_len - f->rx_count);
+    }
+
+    bool crc_ok = (flags & IRQ2_CRC_OK) != 0;
+    uint8_t len = (uint8_t)f->rx_len;
+    f->rx_len = -1;
+    if (f->rx_full) {
+        f->stats.rx_dropped++;
+        return false;
+    }
+    if (crc_ok) {
+        f->stats.rx_frames++;
+    } else {
+        f->stats.rx_crc_errors++;
+    }
+
+    lora_rx_meta_t *meta = &f->rx_slots[f->rx_head % FSK_RX_SLOTS].meta;
+    memset(meta, 0, sizeof(*meta));
+    meta->time_us = time_us_32();
+    meta->rssi_dbm = f->rx_rssi;
+    meta->crc_ok = crc_ok;
+    meta->len = len;
+    __dmb(); // Conteúdo visível antes de publicar o novo head
+    f->rx_head++;
+    return true;
+}
+
+int fsk_rx_take(fsk_t *f, uint8_t *buffer, int max_len, lora_rx_meta_t *meta) {
+    uint32_t tail = f->rx_tail;
+    if (f->rx_head == tail) {
+        return 0;
+    }
+    __dmb();
+    const fsk_packet_t *p = &f->rx_slots[tail % FSK_RX_SLOTS];
+    int len = p->meta.len < max_len ? p->meta.len : max_len;
+    bool ok = p->meta.crc_ok;
+    if (meta) {
+        *meta = p->meta;
+    }
+    if (ok) {
+        memcpy(buffer, p->data, len);
+    }
+    __dmb(); // Cópia concluída antes de liberar o slot
+    f->rx_tail = tail + 1;
+    return ok ? len : 0;
+}
+
+void fsk_get_stats(const fsk_t *f, fsk_stats_t *out) {
+    *out = f->stats;
+}
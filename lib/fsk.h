@@ -0,0 +1,101 @@
+#ifndef FSK_H
+#define FSK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sx1276.h"
+
+// Modo FSK/GFSK para transferências em massa a curta distância (ex.: despejo
+// de registros da estação para um nó de serviço). O rádio sai do LoRa sem
+// reset (lora_set_long_range) e usa o empacotador do modem FSK: preâmbulo,
+// palavra de sincronismo, tamanho variável, whitening e CRC.
+// A FIFO do FSK tem só 64 bytes: pacotes maiores passam em fluxo. No TX ela é
+// recarregada a cada descida do FifoLevel (DIO1) e no RX esvaziada a cada
+// subida, ambas na ISR; o DIO0 indica PacketSent (TX) e PayloadReady (RX).
+
+#define FSK_FXOSC_HZ        32000000
+#define FSK_BITRATE_BPS     250000  // Até 300 kbps, com FSK_FDEV_HZ <= 100 kHz
+#define FSK_FDEV_HZ         125000  // Desvio + taxa/2 não pode passar de 250 kHz
+#define FSK_RX_BW           0x01    // RxBwMant 16, RxBwExp 1: 250 kHz (o máximo)
+#define FSK_PREAMBLE_LEN    8       // Bytes de preâmbulo
+#define FSK_SYNC_LEN        4       // Bytes da palavra de sincronismo
+#define FSK_CRC_LEN         2
+#define FSK_FIFO_LEN        64
+#define FSK_FIFO_THRESHOLD  32      // FifoLevel: mais bytes que isso na FIFO (~1 ms de folga a 250 kbps)
+#define FSK_MAX_PAYLOAD     255     // O byte de tamanho vai no ar antes do payload
+#define FSK_RX_SLOTS        2       // Pacotes recebidos aguardando fsk_rx_take
+
+typedef struct {
+    uint32_t tx_frames;
+    uint32_t tx_refills;        // Recargas da FIFO durante o TX
+    uint32_t rx_frames;
+    uint32_t rx_crc_errors;
+    uint32_t rx_overruns;       // FIFO transbordou antes de ser esvaziada
+    uint32_t rx_dropped;        // Pacotes perdidos com todos os slots ocupados
+} fsk_stats_t;
+
+typedef struct {
+    uint8_t data[FSK_MAX_PAYLOAD];
+    lora_rx_meta_t meta;
+} fsk_packet_t;
+
+// Estado do FSK de um rádio
+typedef struct {
+    lora_dev_t *dev;
+    fsk_stats_t stats;
+
+    // TX em curso: bytes de tx_data ainda fora da FIFO a partir de tx_next
+    const uint8_t *tx_data;
+    uint8_t tx_len;
+    uint8_t tx_next;
+
+    // Pacotes recebidos: a ISR produz, o laço principal consome
+    fsk_packet_t rx_slots[FSK_RX_SLOTS];
+    uint8_t rx_discard[FSK_MAX_PAYLOAD];    // Destino do pacote sem slot livre
+    volatile uint32_t rx_head;
+    volatile uint32_t rx_tail;
+    int rx_len;                 // Tamanho do pacote em curso (-1: ainda não lido)
+    uint8_t rx_count;           // Bytes do payload já lidos
+    int16_t rx_rssi;
+    bool rx_full;               // Pacote em curso sem slot livre
+} fsk_t;
+
+// Associa o estado ao rádio (que continua no LoRa)
+void fsk_init(fsk_t *f, lora_dev_t *dev);
+
+// LoRa -> FSK com o perfil de fsk.h (Standby); false se o rádio não confirmar
+bool fsk_begin(fsk_t *f);
+
+// FSK -> LoRa (perfil padrão, Standby)
+bool fsk_end(fsk_t *f);
+
+// Tempo no ar de um pacote com len bytes de payload
+uint32_t fsk_airtime_us(uint8_t len);
+
+// Carrega o início do pacote e entra em TX. data precisa ficar intacto até o
+// PacketSent: o restante sai dele nas recargas.
+void fsk_start_tx(fsk_t *f, const uint8_t *data, uint8_t len);
+
+// ISR: descida do DIO1 (FifoLevel) durante o TX
+void fsk_tx_refill(fsk_t *f);
+
+// PacketSent (DIO0): volta para Standby
+void fsk_tx_finish(fsk_t *f);
+
+// Recepção contínua (reinicia sozinha após cada pacote)
+void fsk_start_rx(fsk_t *f);
+
+// ISR: subida do DIO1 (FifoLevel) durante o RX
+void fsk_rx_drain(fsk_t *f);
+
+// ISR: PayloadReady (DIO0). Lê o resto do pacote para um slot; true se um
+// pacote (ou erro de CRC) ficou disponível para fsk_rx_take.
+bool fsk_rx_finish(fsk_t *f);
+
+// Fora da ISR: retira o pacote mais antigo. Retorna 0 se não houver pacote
+// válido; meta (opcional) é preenchido também para quadros com erro de CRC.
+int fsk_rx_take(fsk_t *f, uint8_t *buffer, int max_len, lora_rx_meta_t *meta);
+
+void fsk_get_stats(const fsk_t *f, fsk_stats_t *out);
+
+#endif // FSK_H
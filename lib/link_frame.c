@@ -0,0 +1,158 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "link_frame.h"
+
+size_t link_frame_encode(const link_header_t *hdr, const uint8_t *payload, size_t len,
+                         uint8_t *out, size_t max_len) {
+    if (len > LINK_MAX_PAYLOAD || LINK_HEADER_LEN + len > max_len) {
+        return 0;
+    }
+    out[0] = hdr->net_id;
+    out[1] = hdr->src;
+    out[2] = hdr->dst;
+    out[3] = (uint8_t)hdr->seq;
+    out[4] = (uint8_t)(hdr->seq >> 8);
+    out[5] = (uint8_t)((hdr->type << 4) | (hdr->flags & 0x0F));
+    if (len) {
+        memcpy(out + LINK_HEADER_LEN, payload, len);
+    }
+    return LINK_HEADER_LEN + len;
+}
+
+int link_frame_decode(const uint8_t *frame, size_t len, link_header_t *hdr, const uint8_t **payload) {
+    if (len < LINK_HEADER_LEN || frame[0] != LINK_NET_ID) {
+        return -1;
+    }
+    hdr->net_id = frame[0];
+    hdr->src = frame[1];
+    hdr->dst = frame[2];
+    hdr->seq = (uint16_t)(frame[3] | (frame[4] << 8));
+    hdr->type = frame[5] >> 4;
+    hdr->flags = frame[5] & 0x0F;
+    if (payload) {
+        *payload = frame + LINK_HEADER_LEN;
+    }
+    return (int)(len - LINK_HEADER_LEN);
+}
+
+void link_seq_init(link_seq_tracker_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+static void seq_restart(link_seq_tracker_t *t, uint16_t seq) {
+    t->last_seq = seq;
+    t->window = 1;
+    t->window_fill = 1;
+}
+
+link_seq_result_t link_seq_track(link_seq_tracker_t *t, uint16_t seq, uint16_t payload_len, uint32_t now_us) {
+    uint16_t delta = (uint16_t)(seq - t->last_seq);
+
+    if (!t->started) {
+        t->started = true;
+        t->first_us = now_us;
+        seq_restart(t, seq);
+    } else if (delta == 0) {
+        t->duplicates++;
+        return LINK_SEQ_DUPLICATE;
+    } else if (delta <= LINK_SEQ_RESET_GAP) {
+        // Avança a janela; os intermediários contam como perdidos até chegarem
+        t->lost += delta - 1;
+        t->last_seq = seq;
+        t->window = delta >= 64 ? 1 : (t->window << delta) | 1;
+        t->window_fill = delta >= LINK_SEQ_WINDOW - t->window_fill ? LINK_SEQ_WINDOW
+                                                                   : t->window_fill + delta;
+    } else if (delta > 0x10000 - LINK_SEQ_WINDOW) {
+        // Atrasado, ainda dentro da janela
+        uint16_t age = (uint16_t)(t->last_seq - seq);
+        if (t->window & (1ULL << age)) {
+            t->duplicates++;
+            return LINK_SEQ_DUPLICATE;
+        }
+        t->window |= 1ULL << age;
+        t->reordered++;
+        if (t->lost) {
+            t->lost--;
+        }
+        t->received++;
+        t->payload_bytes += payload_len;
+        t->last_us = now_us;
+        return LINK_SEQ_LATE;
+    } else {
+        // Salto grande ou muito atrasado: a origem reiniciou
+        t->restarts++;
+        seq_restart(t, seq);
+    }
+
+    t->received++;
+    t->payload_bytes += payload_len;
+    t->last_us = now_us;
+    return LINK_SEQ_NEW;
+}
+
+uint8_t link_seq_loss_percent(const link_seq_tracker_t *t) {
+    if (t->window_fill == 0) {
+        return 0;
+    }
+    uint64_t mask = t->window_fill >= 64 ? ~0ULL : (1ULL << t->window_fill) - 1;
+    uint8_t got = (uint8_t)__builtin_popcountll(t->window & mask);
+    return (uint8_t)((t->window_fill - got) * 100 / t->window_fill);
+}
+
+uint32_t link_seq_goodput_bps(const link_seq_tracker_t *t) {
+    uint32_t elapsed = t->last_us - t->first_us;
+    if (elapsed == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)t->payload_bytes * 8 * 1000000 / elapsed);
+}
+
+bool link_seq_seen(const link_seq_tracker_t *t, uint16_t seq) {
+    if (!t->started) {
+        return false;
+    }
+    uint16_t age = (uint16_t)(t->last_seq - seq);
+    return age < LINK_SEQ_WINDOW && (t->window & (1ULL << age));
+}
+
+void link_filter_init(link_filter_t *f, uint8_t net_id, link_seen_fn_t seen) {
+    memset(f, 0, sizeof(*f));
+    f->net_id = net_id;
+    f->seen = seen;
+}
+
+bool link_filter_add_addr(link_filter_t *f, uint8_t addr) {
+    if (f->num_addrs >= LINK_FILTER_MAX_ADDRS) {
+        return false;
+    }
+    f->addrs[f->num_addrs++] = addr;
+    return true;
+}
+
+bool link_filter_accept(const uint8_t *head, uint8_t len, void *ctx) {
+    link_filter_t *f = ctx;
+    if (len < LINK_HEADER_LEN) {
+        return true;    // Curto demais para decidir: link_frame_decode recusa
+    }
+    if (head[0] != f->net_id) {
+        f->foreign_net++;
+        return false;
+    }
+    uint8_t dst = head[2];
+    bool ours = dst == LINK_ADDR_BROADCAST;
+    for (uint8_t i = 0; i < f->num_addrs && !ours; i++) {
+        ours = f->addrs[i] == dst;
+    }
+    if (!ours) {
+        f->other_dst++;
+        return false;
+    }
+    uint16_t seq = (uint16_t)(head[3] | (head[4] << 8));
+    uint8_t flags = head[5] & 0x0F;
+    if (f->seen && !(flags & LINK_FLAG_ACK_REQ) && f->seen(head[1], seq)) {
+        f->duplicates++;
+        return false;
+    }
+    f->accepted++;
+    return true;
+}
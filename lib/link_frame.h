@@ -0,0 +1,115 @@
+#ifndef LINK_FRAME_H
+#define LINK_FRAME_H
+
+#include "pico/stdlib.h"
+
+// Cabeçalho de enlace compacto (6 bytes) na frente de todo quadro de rádio:
+//   [0] rede  [1] origem  [2] destino  [3..4] sequência (LE)  [5] tipo (4 bits) | flags (4 bits)
+// e o rastreador de sequência por origem (janela deslizante de 64 quadros) que
+// conta perdidos, duplicados e fora de ordem em O(1) por quadro.
+
+#define LINK_NET_ID             0x2A    // Quadros de outras redes são descartados
+#define LINK_HEADER_LEN         6
+#define LINK_MAX_PAYLOAD        (255 - LINK_HEADER_LEN)
+
+#define LINK_ADDR_GATEWAY       0x00
+#define LINK_ADDR_BROADCAST     0xFF
+
+#define LINK_SEQ_WINDOW         64      // Quadros lembrados para duplicados/fora de ordem
+#define LINK_SEQ_RESET_GAP      1000    // Salto de sequência tratado como reinício da origem
+
+typedef enum {
+    LINK_FRAME_DATA = 0,    // Medições da estação
+    LINK_FRAME_ACK,         // Confirmação
+    LINK_FRAME_CMD,         // Comando (gateway -> estação)
+    LINK_FRAME_TEST,        // Quadros dos exemplos TX/RX
+    LINK_FRAME_FRAG,        // Fragmento de mensagem longa (frag.h)
+    LINK_FRAME_FEC,         // Fragmento ou paridade de um bloco FEC (fec.h)
+    LINK_FRAME_BEACON,      // Início de ciclo TDMA com o mapa de slots (tdma.h)
+    LINK_FRAME_TIME         // Tempo de rede do receptor (time_sync.h)
+} link_frame_type_t;
+
+#define LINK_FLAG_ACK_REQ       0x01    // Origem espera confirmação
+#define LINK_FLAG_RETRY         0x02    // Retransmissão de um quadro já enviado
+#define LINK_FLAG_SYN           0x04    // ARQ da origem sem ACK desde o boot (seq recomeçou)
+
+typedef struct {
+    uint8_t net_id;
+    uint8_t src;
+    uint8_t dst;
+    uint16_t seq;
+    uint8_t type;           // link_frame_type_t
+    uint8_t flags;          // LINK_FLAG_*
+} link_header_t;
+
+typedef enum {
+    LINK_SEQ_NEW = 0,       // Quadro novo, em ordem (ou após lacuna)
+    LINK_SEQ_LATE,          // Chegou fora de ordem, mas ainda não tinha sido visto
+    LINK_SEQ_DUPLICATE      // Já recebido: descartar
+} link_seq_result_t;
+
+typedef struct {
+    bool started;
+    uint16_t last_seq;
+    uint8_t window_fill;        // Quadros esperados na janela (até LINK_SEQ_WINDOW)
+    uint64_t window;            // bit i: quadro (last_seq - i) recebido
+    uint32_t received;          // Quadros únicos
+    uint32_t lost;              // Lacunas ainda não preenchidas
+    uint32_t duplicates;
+    uint32_t reordered;
+    uint32_t restarts;          // Reinícios da origem detectados
+    uint32_t payload_bytes;     // Bytes úteis de quadros únicos (goodput)
+    uint32_t first_us;
+    uint32_t last_us;
+} link_seq_tracker_t;
+
+// Monta cabeçalho + payload em out; retorna o tamanho total ou 0 se não couber
+size_t link_frame_encode(const link_header_t *hdr, const uint8_t *payload, size_t len,
+                         uint8_t *out, size_t max_len);
+
+// Separa o cabeçalho; retorna o tamanho do payload ou -1 se o quadro for
+// curto demais ou de outra rede
+int link_frame_decode(const uint8_t *frame, size_t len, link_header_t *hdr, const uint8_t **payload);
+
+void link_seq_init(link_seq_tracker_t *t);
+
+// Registra um quadro recebido da origem acompanhada por t
+link_seq_result_t link_seq_track(link_seq_tracker_t *t, uint16_t seq, uint16_t payload_len, uint32_t now_us);
+
+// Perda na janela deslizante, em %
+uint8_t link_seq_loss_percent(const link_seq_tracker_t *t);
+
+// Vazão útil (bytes de payload únicos) desde o primeiro quadro, em bit/s
+uint32_t link_seq_goodput_bps(const link_seq_tracker_t *t);
+
+// true se seq já foi registrado em t (sem alterar o rastreador)
+bool link_seq_seen(const link_seq_tracker_t *t, uint16_t seq);
+
+// Filtro antecipado pelo cabeçalho (lora_set_rx_filter): rede, destino na
+// tabela (o broadcast é sempre aceito) e, opcionalmente, duplicados já vistos.
+// Quadros com LINK_FLAG_ACK_REQ nunca caem como duplicados: o ACK anterior
+// pode ter se perdido e a origem precisa de outro.
+#define LINK_FILTER_MAX_ADDRS   4
+
+typedef bool (*link_seen_fn_t)(uint8_t src, uint16_t seq);
+
+typedef struct {
+    uint8_t net_id;
+    uint8_t num_addrs;
+    uint8_t addrs[LINK_FILTER_MAX_ADDRS];   // Destinos aceitos
+    link_seen_fn_t seen;        // NULL: sem descarte de duplicados
+    uint32_t accepted;
+    uint32_t foreign_net;       // Outra rede no mesmo canal
+    uint32_t other_dst;         // Da nossa rede, para outro destino
+    uint32_t duplicates;
+} link_filter_t;
+
+void link_filter_init(link_filter_t *f, uint8_t net_id, link_seen_fn_t seen);
+
+// Acrescenta um destino aceito; false se a tabela estiver cheia
+bool link_filter_add_addr(link_filter_t *f, uint8_t addr);
+
+// Tem a assinatura de lora_rx_filter_t: ctx é o link_filter_t
+bool link_filter_accept(const uint8_t *head, uint8_t len, void *ctx);
+
+#endif // LINK_FRAME_H
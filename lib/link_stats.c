@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "link_stats.h"
+
+// Faixas dos histogramas: bin 0 abaixo da primeira borda, último acima da última
+static const int16_t rssi_edges[LINK_STATS_BINS - 1] = { -120, -110, -100, -90, -80, -70, -60 };
+static const int16_t snr_edges[LINK_STATS_BINS - 1]  = { -15, -10, -5, 0, 5, 10, 15 };
+
+static link_peer_t peers[LINK_STATS_MAX_PEERS];
+static uint32_t crc_errors;
+static int16_t crc_last_rssi;
+
+void link_stats_init(void) {
+    for (int i = 0; i < LINK_STATS_MAX_PEERS; i++) {
+        peers[i].used = false;
+    }
+    crc_errors = 0;
+}
+
+static link_peer_t *find_peer(uint16_t sender) {
+    for (int i = 0; i < LINK_STATS_MAX_PEERS; i++) {
+        if (peers[i].used && peers[i].id == sender) {
+            return &peers[i];
+        }
+    }
+    return NULL;
+}
+
+// Slot livre ou, se não houver, o remetente ouvido há mais tempo
+static link_peer_t *alloc_peer(uint16_t sender, uint32_t now_us) {
+    link_peer_t *victim = &peers[0];
+    for (int i = 0; i < LINK_STATS_MAX_PEERS; i++) {
+        if (!peers[i].used) {
+            victim = &peers[i];
+            break;
+        }
+        if (now_us - peers[i].last_seen_us > now_us - victim->last_seen_us) {
+            victim = &peers[i];
+        }
+    }
+    *victim = (link_peer_t){ .id = sender, .used = true };
+    link_seq_init(&victim->seq);
+    return victim;
+}
+
+static int bin_of(const int16_t *edges, int16_t value) {
+    int bin = 0;
+    while (bin < LINK_STATS_BINS - 1 && value >= edges[bin]) {
+        bin++;
+    }
+    return bin;
+}
+
+static void hist_add(link_peer_t *p, int16_t rssi, int16_t snr) {
+    // Ao completar uma janela os contadores caem pela metade: o histograma
+    // acompanha o enlace atual sem crescer indefinidamente
+    if (p->hist_count >= LINK_STATS_WINDOW) {
+        p->hist_count = 0;
+        for (int i = 0; i < LINK_STATS_BINS; i++) {
+            p->rssi_hist[i] /= 2;
+            p->snr_hist[i] /= 2;
+            p->hist_count += p->rssi_hist[i];
+        }
+    }
+    p->rssi_hist[bin_of(rssi_edges, rssi)]++;
+    p->snr_hist[bin_of(snr_edges, snr)]++;
+    p->hist_count++;
+}
+
+link_seq_result_t link_stats_record(uint16_t sender, uint16_t seq, uint16_t payload_len,
+                                    const lora_rx_meta_t *meta) {
+    link_peer_t *p = find_peer(sender);
+    if (!p) {
+        p = alloc_peer(sender, meta->time_us);
+    }
+
+    link_seq_result_t res = link_seq_track(&p->seq, seq, payload_len, meta->time_us);
+    p->last_seen_us = meta->time_us;
+    if (res == LINK_SEQ_DUPLICATE) {
+        return res;
+    }
+
+    int16_t snr = meta->snr_q4 / 4;
+    if (p->seq.received == 1) {
+        p->rssi_avg_x16 = meta->rssi_dbm * 16;
+        p->snr_avg_x16 = meta->snr_q4 * 4;
+        p->freq_error_avg_hz = meta->freq_error_hz;
+    } else {
+        // Média móvel exponencial com peso 1/8
+        p->rssi_avg_x16 += (meta->rssi_dbm * 16 - p->rssi_avg_x16) / 8;
+        p->snr_avg_x16 += (meta->snr_q4 * 4 - p->snr_avg_x16) / 8;
+        p->freq_error_avg_hz += (meta->freq_error_hz - p->freq_error_avg_hz) / 8;
+    }
+    hist_add(p, meta->rssi_dbm, snr);
+    return res;
+}
+
+void link_stats_crc_error(const lora_rx_meta_t *meta) {
+    crc_errors++;
+    crc_last_rssi = meta->rssi_dbm;
+}
+
+const link_peer_t *link_stats_peer(uint16_t sender) {
+    return find_peer(sender);
+}
+
+bool link_stats_seen(uint8_t sender, uint16_t seq) {
+    const link_peer_t *p = find_peer(sender);
+    return p && link_seq_seen(&p->seq, seq);
+}
+
+uint8_t link_stats_per_percent(const link_peer_t *peer) {
+    return peer ? link_seq_loss_percent(&peer->seq) : 0;
+}
+
+int16_t link_stats_rssi_bin_floor(int bin) {
+    return bin == 0 ? INT16_MIN : rssi_edges[bin - 1];
+}
+
+int16_t link_stats_snr_bin_floor(int bin) {
+    return bin == 0 ? INT16_MIN : snr_edges[bin - 1];
+}
+
+void link_stats_print(void) {
+    printf("Enlace: %lu quadros com erro de CRC (ultimo RSSI %d dBm)\n",
+           (unsigned long)crc_errors, crc_last_rssi);
+
+    for (int i = 0; i < LINK_STATS_MAX_PEERS; i++) {
+        const link_peer_t *p = &peers[i];
+        if (!p->used) {
+            continue;
+        }
+        printf("  %04X: %lu rx, %lu perdidos, %lu dup, %lu fora de ordem, PER %u%%, goodput %lu bit/s\n",
+               p->id, (unsigned long)p->seq.received, (unsigned long)p->seq.lost,
+               (unsigned long)p->seq.duplicates, (unsigned long)p->seq.reordered,
+               link_stats_per_percent(p), (unsigned long)link_seq_goodput_bps(&p->seq));
+        printf("        RSSI %.1f dBm, SNR %.1f dB, Ferr %ld Hz\n",
+               p->rssi_avg_x16 / 16.0, p->snr_avg_x16 / 16.0, (long)p->freq_error_avg_hz);
+
+        printf("        RSSI [<-120 .. >=-60]:");
+        for (int b = 0; b < LINK_STATS_BINS; b++) {
+            printf(" %u", p->rssi_hist[b]);
+        }
+        printf("  SNR [<-15 .. >=15]:");
+        for (int b = 0; b < LINK_STATS_BINS; b++) {
+            printf(" %u", p->snr_hist[b]);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include "pico/stdlib.h"
+#include "sx1276.h"
+#include "link_frame.h"
+
+// Qualidade de enlace por remetente em memória fixa: PER, duplicados e fora
+// de ordem pelo número de sequência do cabeçalho (link_frame), goodput,
+// médias móveis de RSSI, SNR e erro de frequência e histogramas que decaem
+// pela metade a cada janela.
+
+#define LINK_STATS_MAX_PEERS    8       // Remetentes acompanhados (o mais antigo é substituído)
+#define LINK_STATS_WINDOW       64      // Quadros por janela dos histogramas
+#define LINK_STATS_BINS         8
+
+typedef struct {
+    uint16_t id;
+    bool used;
+    link_seq_tracker_t seq;     // Perdidos, duplicados, fora de ordem e goodput
+    uint32_t last_seen_us;
+    int32_t rssi_avg_x16;       // Médias móveis em 1/16 da unidade
+    int32_t snr_avg_x16;        // (SNR em dB)
+    int32_t freq_error_avg_hz;
+    uint16_t rssi_hist[LINK_STATS_BINS];
+    uint16_t snr_hist[LINK_STATS_BINS];
+    uint16_t hist_count;
+} link_peer_t;
+
+void link_stats_init(void);
+
+// Registra um quadro válido de sender; retorna LINK_SEQ_DUPLICATE se o
+// quadro já tinha sido recebido (e deve ser descartado)
+link_seq_result_t link_stats_record(uint16_t sender, uint16_t seq, uint16_t payload_len,
+                                    const lora_rx_meta_t *meta);
+
+// Registra um quadro com erro de CRC (remetente desconhecido)
+void link_stats_crc_error(const lora_rx_meta_t *meta);
+
+// Estatísticas de um remetente (NULL se não acompanhado)
+const link_peer_t *link_stats_peer(uint16_t sender);
+
+// true se o quadro seq de sender já foi registrado (link_seen_fn_t do filtro)
+bool link_stats_seen(uint8_t sender, uint16_t seq);
+
+// Taxa de perda de pacotes na janela deslizante, em %
+uint8_t link_stats_per_percent(const link_peer_t *peer);
+
+// Limite inferior da faixa dos histogramas (em dBm e dB)
+int16_t link_stats_rssi_bin_floor(int bin);
+int16_t link_stats_snr_bin_floor(int bin);
+
+void link_stats_print(void);
+
+#endif // LINK_STATS_H
@@ -0,0 +1,510 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/structs/rosc.h"
+#include "sx1276.h"
+#include "fsk.h"
+#include "channel_plan.h"
+#include "airtime.h"
+#include "arq.h"
+#include "downlink.h"
+#include "cpu_load.h"
+#include "boot_trace.h"
+#include "radio_core.h"
+
+// Fila circular de um produtor e um consumidor. head só é escrito pelo
+// produtor e tail só pelo consumidor, então não precisa de trava entre núcleos.
+typedef struct {
+    radio_msg_t slots[RADIO_QUEUE_LEN];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+} msg_ring_t;
+
+static msg_ring_t tx_ring;      // core 0 -> core 1
+static msg_ring_t evt_ring;     // core 1 -> core 0
+
+typedef enum {
+    RADIO_IDLE = 0,     // Standby (ou RX contínuo no modo escuta)
+    RADIO_CAD,          // Verificando o canal antes de transmitir
+    RADIO_BACKOFF,      // Canal ocupado: aguardando o recuo aleatório
+    RADIO_TX,           // Transmitindo, aguardando TxDone
+    RADIO_ACK_WAIT,     // Janela curta de RX para o ACK após o TX
+    RADIO_SLOT_WAIT,    // Quadro com instante marcado aguardando o alarme
+    RADIO_FSK_TX        // Quadro FSK saindo, FIFO recarregada na ISR
+} radio_state_t;
+
+static lora_dev_t *radio;           // Rádio deste núcleo (radio_core_launch)
+static fsk_t fsk;
+static volatile bool dio0_flag = false;
+static volatile uint32_t dio0_us;   // Borda do DIO0 carimbada no ISR
+static volatile bool backoff_flag = false;
+static volatile bool slot_flag = false;
+static alarm_pool_t *alarms;        // Pool do core 1: os alarmes do rádio não disputam o do core 0
+static alarm_id_t slot_alarm;
+static uint32_t ack_slot_us;
+static uint32_t ack_slot_open_us;   // Início da janela em curso
+static volatile radio_state_t state = RADIO_IDLE;
+static bool listen_mode = false;
+static bool fsk_on = false;         // Rádio no modem FSK (entre quadros RADIO_TX_FSK)
+static volatile bool tx_power_pending = false;
+static volatile int8_t tx_power_req;    // Escrito pelo core 0 (radio_core_set_tx_power)
+static uint32_t rng_state;
+// Contadores escritos só pelo core 1; tx_queued e tx_dropped, só pelo core 0
+// (queue_tx). A trava protege a cópia de radio_core_get_stats() contra campos
+// de 64 bits pela metade.
+static radio_core_stats_t stats;
+static uint32_t tx_queued, tx_dropped;
+static spin_lock_t *stats_lock;
+
+static bool ring_push(msg_ring_t *r, const radio_msg_t *m) {
+    uint32_t head = r->head;
+    if (head - r->tail >= RADIO_QUEUE_LEN) {
+        return false;
+    }
+    r->slots[head % RADIO_QUEUE_LEN] = *m;
+    __dmb(); // Conteúdo visível antes de publicar o novo head
+    r->head = head + 1;
+    __sev(); // Acorda o outro núcleo se estiver em WFE
+    return true;
+}
+
+static bool ring_pop(msg_ring_t *r, radio_msg_t *m) {
+    uint32_t tail = r->tail;
+    if (r->head == tail) {
+        return false;
+    }
+    __dmb();
+    *m = r->slots[tail % RADIO_QUEUE_LEN];
+    __dmb(); // Cópia concluída antes de liberar o slot
+    r->tail = tail + 1;
+    return true;
+}
+
+static void post_event(uint8_t type, const uint8_t *data, uint8_t len, const lora_rx_meta_t *meta,
+                       uint32_t time_us) {
+    static radio_msg_t evt;
+    evt.type = type;
+    evt.len = len;
+    evt.time_us = time_us;
+    if (meta) {
+        evt.meta = *meta;
+    }
+    if (len) {
+        memcpy(evt.data, data, len);
+    }
+    if (!ring_push(&evt_ring, &evt)) {
+        stats.rx_dropped++;
+    }
+}
+
+// Semente a partir do oscilador em anel: nós com o mesmo firmware não
+// repetem a mesma sequência de recuos
+static void random_seed(void) {
+    for (int i = 0; i < 32; i++) {
+        rng_state = (rng_state << 1) | (rosc_hw->randombit & 1);
+    }
+    if (rng_state == 0) {
+        rng_state = 1;
+    }
+}
+
+static uint32_t random_next(void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int64_t backoff_alarm(alarm_id_t id, void *user_data) {
+    backoff_flag = true;
+    __sev(); // Sai do __wfe() do laço principal
+    return 0;
+}
+
+static int64_t slot_alarm_cb(alarm_id_t id, void *user_data) {
+    slot_flag = true;
+    __sev();
+    return 0;
+}
+
+// --- ISR dos DIOs (registrada no core 1) ---
+static void dio_irq(lora_dev_t *dev, uint8_t dio, uint32_t events) {
+    if (dio == 1 && state == RADIO_FSK_TX) {
+        // FifoLevel baixou: a 250 kbps a FIFO esvazia em ~1 ms, não dá para
+        // esperar o laço. Durante o TX FSK o laço não usa o SPI.
+        if (events & GPIO_IRQ_EDGE_FALL) {
+            fsk_tx_refill(&fsk);
+        }
+        return;
+    }
+    if (!(events & GPIO_IRQ_EDGE_RISE)) {
+        return;
+    }
+    if (dio == 0) {
+        // O carimbo sai daqui: o laço do core 1 pode estar no meio de outra
+        // tarefa (CAD, leitura da FIFO) quando vê a flag
+        dio0_us = time_us_32();
+        dio0_flag = true;
+    } else if (state != RADIO_CAD) {
+        // Durante a CAD o DIO1 indica CadDetected, não salto de canal
+        // O salto tem de terminar dentro do período de salto: é feito aqui
+        // mesmo. Durante o pacote o laço do core 1 não usa o SPI.
+        fhss_on_change_channel(dev);
+    }
+}
+
+static void enter_rx(void) {
+    lora_set_dio_mapping(radio, DIO0_MASK, DIO0_RX_DONE);
+    lora_write_reg(radio, REG_FIFO_ADDR_PTR, 0);
+    lora_write_reg(radio, REG_OPMODE, RF95_MODE_RX_CONTINUOUS);
+}
+
+static void start_tx(const radio_msg_t *m) {
+    lora_set_dio_mapping(radio, DIO0_MASK, DIO0_TX_DONE);
+    lora_start_tx(radio, m->data, m->len);
+    state = RADIO_TX;
+}
+
+// Carrega a FIFO e espera o instante exato do slot com o rádio em Standby
+static void start_tx_at(const radio_msg_t *m) {
+    if (m->flags & RADIO_TX_FAST) {
+        lora_set_fast_mode(radio, true, m->len);
+    }
+    lora_set_dio_mapping(radio, DIO0_MASK, DIO0_TX_DONE);
+    lora_load_tx(radio, m->data, m->len);
+    while ((int32_t)(time_us_32() - m->tx_at_us) < 0) {
+        tight_loop_contents();
+    }
+    lora_write_reg(radio, REG_OPMODE, RF95_MODE_TX);
+    uint32_t late = time_us_32() - m->tx_at_us;
+    if (late > stats.slot_late_max_us) {
+        stats.slot_late_max_us = late;
+    }
+    stats.slot_tx++;
+    state = RADIO_TX;
+}
+
+// O estado passa a RADIO_FSK_TX só depois da carga inicial: a ISR de
+// recarga nunca interrompe o acesso à FIFO do laço
+static void start_fsk_tx(const radio_msg_t *m) {
+    if (!fsk_on) {
+        if (!fsk_begin(&fsk)) {
+            post_event(RADIO_MSG_ERROR, NULL, 0, NULL, time_us_32());
+            return;
+        }
+        fsk_on = true;
+        stats.fsk_switches++;
+        lora_irq_enable(radio, 1, GPIO_IRQ_EDGE_FALL, true);
+    }
+    fsk_start_tx(&fsk, m->data, m->len);
+    state = RADIO_FSK_TX;
+}
+
+static void leave_fsk(void) {
+    lora_irq_enable(radio, 1, GPIO_IRQ_EDGE_FALL, false);
+    fsk_on = false;
+    if (!fsk_end(&fsk)) {
+        post_event(RADIO_MSG_ERROR, NULL, 0, NULL, time_us_32());
+    }
+}
+
+// Próximo quadro da fila também em FSK: cada troca de modem custa um Sleep
+// e a reescrita do perfil
+static bool next_is_fsk(void) {
+    uint32_t tail = tx_ring.tail;
+    if (tx_ring.head == tail) {
+        return false;
+    }
+    __dmb();
+    return (tx_ring.slots[tail % RADIO_QUEUE_LEN].flags & RADIO_TX_FSK) != 0;
+}
+
+static void end_of_exchange(void) {
+    // Tempo de RX após o uplink: janela do ACK e dos comandos de downlink
+    uint32_t open_us = time_us_32() - ack_slot_open_us;
+    uint32_t irq = spin_lock_blocking(stats_lock);
+    stats.ack_slot_total_us += open_us;
+    if (open_us > stats.ack_slot_max_us) {
+        stats.ack_slot_max_us = open_us;
+    }
+    spin_unlock(stats_lock, irq);
+    state = RADIO_IDLE;
+    if (listen_mode) {
+        enter_rx();
+    } else {
+        lora_write_reg(radio, REG_OPMODE, RF95_MODE_STANDBY);
+    }
+}
+
+static void open_ack_slot(void) {
+    // O preâmbulo do ACK precisa começar dentro do timeout de símbolos;
+    // o alarme encerra a janela mesmo se o ACK começar e falhar
+    uint16_t symbols = ARQ_TURNAROUND_US / LORA_SYMBOL_US + LORA_PREAMBLE_LEN + 4;
+    state = RADIO_ACK_WAIT;
+    stats.ack_slots++;
+    slot_flag = false;
+    lora_start_rx_single(radio, symbols);
+    ack_slot_open_us = time_us_32();
+    slot_alarm = alarm_pool_add_alarm_in_us(alarms, ack_slot_us, slot_alarm_cb, NULL, true);
+}
+
+static void start_backoff(uint8_t attempts) {
+    // Janela de 2, 4, 8... slots conforme as tentativas
+    uint32_t slots = random_next() % (2u << attempts) + 1;
+    state = RADIO_BACKOFF;
+    alarm_pool_add_alarm_in_us(alarms, slots * RADIO_LBT_SLOT_US, backoff_alarm, NULL, true);
+    if (listen_mode) {
+        enter_rx(); // O quadro que ocupa o canal pode ser para nós
+    }
+}
+
+static void core1_entry(void) {
+    // Criado aqui para a IRQ do alarme ficar no core 1: recuo, janela de ACK e
+    // slot TDMA não esperam pelo I2C nem pelas ISRs do core 0
+    alarms = alarm_pool_create_with_unused_hardware_alarm(RADIO_ALARM_POOL_LEN);
+    lora_spi_init(radio);
+
+    gpio_init(radio->pin_dio0);
+    gpio_set_dir(radio->pin_dio0, GPIO_IN);
+    gpio_init(radio->pin_dio1);
+    gpio_set_dir(radio->pin_dio1, GPIO_IN);
+
+    bool ok = listen_mode ? lora_init_rx(radio) : lora_init(radio);
+    if (ok) {
+        fhss_init(radio, FHSS_HOP_PERIOD, FHSS_SEED);
+    }
+    fsk_init(&fsk, radio);
+    boot_trace_mark(ok ? "radio configurado" : "radio falhou");
+
+    // A callback de GPIO é por núcleo: os DIOs são atendidos só no core 1
+    lora_irq_attach(radio, dio_irq, NULL);
+    lora_irq_enable(radio, 0, GPIO_IRQ_EDGE_RISE, true);
+    if (fhss_enabled(radio)) {
+        lora_irq_enable(radio, 1, GPIO_IRQ_EDGE_RISE, true);
+    }
+
+    // Informa o resultado da inicialização ao core 0 pela FIFO do SIO
+    multicore_fifo_push_blocking(ok);
+    if (!ok) {
+        while (true) {
+            __wfe();
+        }
+    }
+
+    static radio_msg_t msg;
+    static radio_msg_t tx_msg;
+    uint8_t attempts = 0;
+
+    random_seed();
+
+    lora_modem_cfg_t modem = LORA_MODEM_CFG_DEFAULT(LORA_PREAMBLE_LEN);
+    // A janela também comporta o maior comando de downlink junto com o ACK
+    ack_slot_us = arq_ack_slot_us(&modem) + downlink_window_extra_us(&modem);
+
+    while (true) {
+        bool worked = false;
+
+        if (dio0_flag) {
+            dio0_flag = false;
+            worked = true;
+
+            if (state == RADIO_FSK_TX) {
+                // PacketSent
+                state = RADIO_IDLE;
+                fsk_tx_finish(&fsk);
+                stats.tx_done++;
+                stats.fsk_tx++;
+                post_event(RADIO_MSG_TX_DONE, NULL, 0, NULL, dio0_us);
+                if (!next_is_fsk()) {
+                    leave_fsk();
+                    if (listen_mode) {
+                        enter_rx();
+                    }
+                }
+            } else if (state == RADIO_TX) {
+                // TxDone
+                fhss_packet_done(radio);
+                lora_write_reg(radio, REG_IRQ_FLAGS, 0xFF);
+                stats.tx_done++;
+                if (tx_msg.flags & RADIO_TX_FAST) {
+                    // De volta ao perfil padrão antes de escutar
+                    lora_set_fast_mode(radio, false, 0);
+                    stats.fast_tx++;
+                }
+                post_event(RADIO_MSG_TX_DONE, NULL, 0, NULL, dio0_us);
+                if (tx_msg.flags & RADIO_TX_ACK_SLOT) {
+                    open_ack_slot();
+                } else {
+                    state = RADIO_IDLE;
+                    if (listen_mode) {
+                        enter_rx();
+                    }
+                }
+            } else if (state == RADIO_CAD) {
+                // CadDone
+                if (!lora_cad_finish(radio)) {
+                    start_tx(&tx_msg);
+                } else {
+                    stats.cad_busy++;
+                    if (++attempts >= RADIO_LBT_MAX_ATTEMPTS) {
+                        stats.lbt_forced++;
+                        start_tx(&tx_msg);
+                    } else {
+                        start_backoff(attempts);
+                    }
+                }
+            } else {
+                // RxDone (em escuta, durante o recuo ou na janela de ACK)
+                if (state == RADIO_ACK_WAIT) {
+                    alarm_pool_cancel_alarm(alarms, slot_alarm);
+                    stats.ack_slot_rx++;
+                }
+                fhss_packet_done(radio);
+                msg.meta.crc_ok = true;
+                int len = lora_receive_packet(radio, msg.data, PAYLOAD_LENGTH, &msg.meta);
+                msg.meta.time_us = dio0_us;
+                if (len > 0) {
+                    stats.rx_frames++;
+                    post_event(RADIO_MSG_RX, msg.data, (uint8_t)len, &msg.meta, dio0_us);
+                } else if (!msg.meta.crc_ok) {
+                    stats.rx_crc_errors++;
+                } else if (msg.meta.overrun) {
+                    stats.rx_overruns++;
+                }
+                if (state == RADIO_ACK_WAIT) {
+                    end_of_exchange();
+                }
+            }
+        }
+
+        if (state == RADIO_ACK_WAIT && slot_flag) {
+            // Janela de ACK expirou sem quadro
+            slot_flag = false;
+            worked = true;
+            lora_write_reg(radio, REG_IRQ_FLAGS, 0xFF);
+            end_of_exchange();
+        }
+
+        if (state == RADIO_SLOT_WAIT && slot_flag) {
+            slot_flag = false;
+            worked = true;
+            start_tx_at(&tx_msg);
+        }
+
+        if (state == RADIO_BACKOFF && backoff_flag) {
+            backoff_flag = false;
+            worked = true;
+            state = RADIO_CAD;
+            lora_start_cad(radio);
+        }
+
+        if (state == RADIO_IDLE && tx_power_pending) {
+            // Vale para o próximo quadro (LoRa ou FSK: o registrador é comum)
+            tx_power_pending = false;
+            __dmb();
+            lora_set_tx_power(radio, tx_power_req);
+            worked = true;
+        }
+
+        if (state == RADIO_IDLE && ring_pop(&tx_ring, &tx_msg)) {
+            worked = true;
+            attempts = 0;
+            if (fsk_on && !(tx_msg.flags & RADIO_TX_FSK)) {
+                leave_fsk();
+            }
+            if (tx_msg.flags & RADIO_TX_FSK) {
+                start_fsk_tx(&tx_msg);
+            } else if (tx_msg.flags & RADIO_TX_AT) {
+                // O slot é desta estação: sem CAD, só o alarme antes do instante
+                int32_t wait_us = (int32_t)(tx_msg.tx_at_us - time_us_32()) - RADIO_TX_LEAD_US;
+                if (wait_us < 0) {
+                    stats.slot_missed++;
+                } else {
+                    state = RADIO_SLOT_WAIT;
+                    slot_flag = false;
+                    slot_alarm = alarm_pool_add_alarm_in_us(alarms, (uint32_t)wait_us, slot_alarm_cb, NULL, true);
+                }
+            } else {
+                if (tx_msg.flags & RADIO_TX_FAST) {
+                    // A CAD também precisa do SF6: procura preâmbulos do mesmo modo
+                    lora_set_fast_mode(radio, true, tx_msg.len);
+                }
+                if (RADIO_LBT_ENABLED) {
+                    state = RADIO_CAD;
+                    lora_start_cad(radio);
+                } else {
+                    start_tx(&tx_msg);
+                }
+            }
+        }
+
+        if (!worked) {
+            // Nada a fazer: dorme até a próxima interrupção ou __sev() do core 0
+            cpu_load_idle_begin();
+            __wfe();
+            cpu_load_idle_end();
+        }
+    }
+}
+
+void radio_core_launch(lora_dev_t *dev, bool listen) {
+    radio = dev;
+    listen_mode = listen;
+    stats_lock = spin_lock_init(spin_lock_claim_unused(true));
+    multicore_launch_core1(core1_entry);
+}
+
+bool radio_core_wait_ready(void) {
+    return multicore_fifo_pop_blocking() != 0;
+}
+
+static bool queue_tx(const uint8_t *payload, uint8_t len, uint8_t flags, uint32_t tx_at_us) {
+    static radio_msg_t msg;
+    if (flags & (RADIO_TX_FAST | RADIO_TX_FSK)) {
+        flags &= ~RADIO_TX_ACK_SLOT;    // O ACK do ARQ é um quadro do perfil padrão
+    }
+    msg.type = RADIO_MSG_TX;
+    msg.flags = flags;
+    msg.len = len;
+    msg.time_us = time_us_32();
+    msg.tx_at_us = tx_at_us;
+    memcpy(msg.data, payload, len);
+
+    if (!ring_push(&tx_ring, &msg)) {
+        tx_dropped++;
+        return false;
+    }
+    tx_queued++;
+    return true;
+}
+
+bool radio_core_send(const uint8_t *payload, uint8_t len, uint8_t flags) {
+    return queue_tx(payload, len, flags & ~RADIO_TX_AT, 0);
+}
+
+bool radio_core_send_at(const uint8_t *payload, uint8_t len, uint8_t flags, uint32_t tx_at_us) {
+    return queue_tx(payload, len, flags | RADIO_TX_AT, tx_at_us);
+}
+
+void radio_core_set_tx_power(int8_t dbm) {
+    tx_power_req = dbm;
+    __dmb();
+    tx_power_pending = true;
+    __sev();
+}
+
+bool radio_core_poll(radio_msg_t *msg) {
+    return ring_pop(&evt_ring, msg);
+}
+
+void radio_core_get_stats(radio_core_stats_t *out) {
+    uint32_t irq = spin_lock_blocking(stats_lock);
+    *out = stats;
+    spin_unlock(stats_lock, irq);
+    out->tx_queued = tx_queued;
+    out->tx_dropped = tx_dropped;
+}
@@ -0,0 +1,101 @@
+#ifndef RADIO_CORE_H
+#define RADIO_CORE_H
+
+#include "pico/stdlib.h"
+#include "sx1276.h"
+
+// Pilha de rádio no núcleo 1: o driver SX1276, a interrupção DIO0 e as filas
+// de TX/RX rodam no core 1. O core 0 (sensores, display, alarmes) conversa
+// com ele apenas por filas sem trava (um produtor, um consumidor).
+
+#define RADIO_QUEUE_LEN     4
+#define RADIO_ALARM_POOL_LEN 4      // Alarmes simultâneos no pool do core 1 (recuo, slot/ACK)
+
+// Escuta antes de transmitir (LBT): uma CAD antes de cada quadro; com o canal
+// ocupado, espera um recuo aleatório que dobra a cada tentativa
+#define RADIO_LBT_ENABLED       1
+#define RADIO_LBT_MAX_ATTEMPTS  5       // Depois disso transmite mesmo assim
+#define RADIO_LBT_SLOT_US       5000    // Unidade do recuo aleatório
+
+typedef enum {
+    RADIO_MSG_TX = 0,       // core 0 -> core 1: quadro a transmitir
+    RADIO_MSG_TX_DONE,      // core 1 -> core 0: transmissão concluída
+    RADIO_MSG_RX,           // core 1 -> core 0: quadro recebido
+    RADIO_MSG_ERROR         // core 1 -> core 0: falha no rádio
+} radio_msg_type_t;
+
+#define RADIO_TX_ACK_SLOT   0x01    // Após o TX, abre uma janela de RX para o ACK do ARQ
+#define RADIO_TX_AT         0x02    // Transmite no instante tx_at_us (slot TDMA), sem LBT
+#define RADIO_TX_FAST       0x04    // Quadro fixo no modo rápido (SF6, lora_set_fast_mode), sem ACK
+#define RADIO_TX_FSK        0x08    // Quadro em FSK (fsk.h) para um nó de serviço próximo, sem LBT nem ACK
+
+// Um alarme acorda o core 1 esta antecedência antes do slot para carregar a
+// FIFO; o TX começa com uma única escrita de registrador no instante exato
+#define RADIO_TX_LEAD_US    1500
+
+typedef struct {
+    uint8_t type;                   // radio_msg_type_t
+    uint8_t flags;                  // RADIO_TX_* (RADIO_MSG_TX)
+    uint8_t len;
+    uint32_t time_us;               // Instante do evento; RX e TX_DONE: borda do DIO0 carimbada no ISR
+    uint32_t tx_at_us;              // Início do TX (RADIO_TX_AT)
+    lora_rx_meta_t meta;            // RSSI, SNR e erro de frequência (RADIO_MSG_RX)
+    uint8_t data[PAYLOAD_LENGTH];
+} radio_msg_t;
+
+typedef struct {
+    uint32_t tx_queued;     // Quadros aceitos na fila de TX
+    uint32_t tx_dropped;    // Quadros recusados (fila cheia)
+    uint32_t tx_done;       // Transmissões concluídas
+    uint32_t rx_frames;     // Quadros recebidos
+    uint32_t rx_crc_errors; // Quadros descartados por erro de CRC
+    uint32_t rx_overruns;   // Quadros sobrescritos na FIFO durante a leitura
+    uint32_t rx_dropped;    // Quadros/eventos perdidos por fila cheia no core 0
+    uint32_t cad_busy;      // CADs que encontraram o canal ocupado
+    uint32_t lbt_forced;    // Quadros transmitidos após esgotar as tentativas de LBT
+    uint32_t ack_slots;     // Janelas de ACK abertas
+    uint32_t ack_slot_rx;   // Janelas de ACK em que chegou um quadro
+    uint32_t ack_slot_max_us;   // Janela mais longa (até o RxDone ou o fim do prazo)
+    uint64_t ack_slot_total_us; // Tempo total em RX nas janelas após o uplink
+    uint32_t fast_tx;       // Quadros transmitidos no modo rápido (RADIO_TX_FAST)
+    uint32_t fsk_tx;        // Quadros transmitidos em FSK (RADIO_TX_FSK)
+    uint32_t fsk_switches;  // Entradas no modem FSK (uma por sequência de quadros FSK)
+    uint32_t slot_tx;       // Quadros transmitidos no instante marcado (RADIO_TX_AT)
+    uint32_t slot_missed;   // Quadros descartados por chegarem depois do instante marcado
+    uint32_t slot_late_max_us;  // Maior atraso do início do TX em relação ao instante marcado
+} radio_core_stats_t;
+
+// Lança o core 1, que inicializa o rádio dev em paralelo com o core 0 e
+// passa a ser o único a acessá-lo (inclusive as ISRs dos DIOs).
+// Com listen=true o rádio volta para RX contínuo após cada transmissão.
+void radio_core_launch(lora_dev_t *dev, bool listen);
+
+// Aguarda o resultado da inicialização do rádio no core 1
+bool radio_core_wait_ready(void);
+
+// Enfileira um quadro para transmissão (não bloqueia; false se a fila estiver cheia).
+// Com RADIO_TX_ACK_SLOT o rádio escuta por arq_ack_slot_us() (mais
+// downlink_window_extra_us(), para um comando junto com o ACK) após o TxDone
+// e entrega o que chegar como RADIO_MSG_RX. Com RADIO_TX_FSK o rádio passa ao
+// FSK e só volta ao LoRa quando o próximo quadro da fila não for FSK; se a
+// troca de modem falhar, o quadro é descartado com RADIO_MSG_ERROR.
+bool radio_core_send(const uint8_t *payload, uint8_t len, uint8_t flags);
+
+// Como radio_core_send, mas o TX começa em tx_at_us (time_us_32), sem CAD.
+// O quadro precisa chegar ao core 1 ao menos RADIO_TX_LEAD_US antes; se
+// chegar atrasado é descartado (conta em slot_missed) para não invadir o
+// slot seguinte. Até lá o rádio segue no modo anterior (RX no modo escuta).
+bool radio_core_send_at(const uint8_t *payload, uint8_t len, uint8_t flags, uint32_t tx_at_us);
+
+// Potência de TX (lora_set_tx_power) a partir do próximo quadro; o core 1
+// aplica entre trocas, com o rádio ocioso
+void radio_core_set_tx_power(int8_t dbm);
+
+// Retira um evento do core 1 (TX_DONE, RX ou ERROR); false se não houver
+bool radio_core_poll(radio_msg_t *msg);
+
+// Cópia dos contadores; segura para chamar do core 0 com o core 1 rodando
+// (os de 32 bits são lidos inteiros e os de 64 bits sob trava)
+void radio_core_get_stats(radio_core_stats_t *out);
+
+#endif // RADIO_CORE_H
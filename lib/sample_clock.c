@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/sync.h"
+#include "bmp280.h"
+#include "sample_clock.h"
+
+// Limites superiores (us) de cada faixa do histograma; a última é aberta
+static const uint32_t jitter_bin_limit[SAMPLE_JITTER_BINS - 1] = {
+    10, 50, 100, 250, 500, 1000, 5000
+};
+
+static i2c_inst_t *bus;
+static sched_task_t *service_task;
+static uint32_t period;
+static repeating_timer_t timer;
+static uint64_t next_target_us;
+static uint64_t last_acq_us;
+static uint32_t seq;
+
+// ISR -> tarefa: instante a amostrar e resultado do AHT20 a buscar
+static volatile bool acq_due;
+static volatile uint64_t acq_us;
+static volatile bool fetch_due;
+
+static sample_t pending;        // Amostra aguardando o AHT20
+static bool pending_busy;
+static int aht_polls;
+
+// Fila tarefa -> tarefa de processamento (mesmo núcleo)
+static sample_t ring[SAMPLE_QUEUE_LEN];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+
+static sample_clock_stats_t stats;
+
+static void push_sample(const sample_t *s) {
+    if (ring_head - ring_tail >= SAMPLE_QUEUE_LEN) {
+        stats.dropped++;
+        return;
+    }
+    ring[ring_head % SAMPLE_QUEUE_LEN] = *s;
+    __dmb();
+    ring_head++;
+    stats.samples++;
+}
+
+static void record_jitter(uint32_t jitter) {
+    int bin = 0;
+    while (bin < SAMPLE_JITTER_BINS - 1 && jitter >= jitter_bin_limit[bin]) {
+        bin++;
+    }
+    stats.hist[bin]++;
+    stats.sum_jitter_us += jitter;
+    if (jitter > stats.max_jitter_us) {
+        stats.max_jitter_us = jitter;
+    }
+    if (jitter > SAMPLE_LATE_US) {
+        stats.late++;
+    }
+}
+
+// Fim da conversão do AHT20 (contexto de interrupção): só sinaliza a tarefa
+static int64_t aht_fetch_callback(alarm_id_t id, void *user_data) {
+    fetch_due = true;
+    sched_signal(service_task);
+    return 0;
+}
+
+// Instante de amostragem (contexto de interrupção): carimba e sinaliza
+static bool sample_timer_callback(repeating_timer_t *rt) {
+    uint64_t now = time_us_64();
+
+    record_jitter(now > next_target_us ? (uint32_t)(now - next_target_us) : 0);
+    next_target_us += period;
+
+    if (last_acq_us) {
+        uint64_t delta = now - last_acq_us;
+        uint32_t err = delta > period ? (uint32_t)(delta - period) : (uint32_t)(period - delta);
+        if (err > stats.max_period_err_us) {
+            stats.max_period_err_us = err;
+        }
+    }
+    last_acq_us = now;
+
+    if (acq_due) {
+        stats.missed++;     // A tarefa ainda não leu o disparo anterior
+    }
+    acq_us = now;
+    acq_due = true;
+    sched_signal(service_task);
+    return true;
+}
+
+static void fetch_aht(void) {
+    if (!pending_busy) {
+        return;
+    }
+    if (aht20_fetch(bus, &pending.aht)) {
+        pending.aht_ok = true;
+    } else if (++aht_polls < SAMPLE_AHT20_MAX_POLLS &&
+               add_alarm_in_us(SAMPLE_AHT20_POLL_US, aht_fetch_callback, NULL, true) > 0) {
+        return;     // Ainda convertendo: nova consulta
+    } else {
+        stats.aht_fail++;
+    }
+    push_sample(&pending);
+    pending_busy = false;
+}
+
+static void acquire(uint64_t stamp_us) {
+    // Amostra anterior ainda esperando o AHT20: entrega sem ele
+    if (pending_busy) {
+        stats.aht_fail++;
+        push_sample(&pending);
+        pending_busy = false;
+    }
+
+    uint32_t service = (uint32_t)(time_us_64() - stamp_us);
+    if (service > stats.max_service_us) {
+        stats.max_service_us = service;
+    }
+
+    memset(&pending, 0, sizeof(pending));
+    pending.seq = seq++;
+    pending.time_us = stamp_us;
+    pending.bmp_ok = bmp280_read_raw(bus, &pending.bmp_raw_temp, &pending.bmp_raw_press);
+    if (!pending.bmp_ok) {
+        stats.bmp_fail++;
+    }
+
+    aht_polls = 0;
+    pending_busy = true;
+    if (!aht20_trigger(bus) ||
+        add_alarm_in_us(SAMPLE_AHT20_CONVERSION_US, aht_fetch_callback, NULL, true) <= 0) {
+        stats.aht_fail++;
+        push_sample(&pending);
+        pending_busy = false;
+    }
+}
+
+void sample_clock_service(void) {
+    // Resultado da conversão antes do próximo disparo: a amostra em curso
+    // termina antes de outra começar
+    if (fetch_due) {
+        fetch_due = false;
+        fetch_aht();
+    }
+    if (acq_due) {
+        uint32_t irq = save_and_disable_interrupts();
+        uint64_t stamp = acq_us;
+        acq_due = false;
+        restore_interrupts(irq);
+        acquire(stamp);
+    }
+}
+
+bool sample_clock_start(i2c_inst_t *i2c, uint32_t period_us, sched_task_t *task) {
+    bus = i2c;
+    service_task = task;
+    period = period_us;
+    memset(&stats, 0, sizeof(stats));
+
+    // Atraso negativo: cada disparo é agendado a partir do alvo anterior
+    next_target_us = time_us_64() + period_us;
+    return add_repeating_timer_us(-(int64_t)period_us, sample_timer_callback, NULL, &timer);
+}
+
+bool sample_clock_set_period(uint32_t period_us) {
+    cancel_repeating_timer(&timer);
+    period = period_us;
+    last_acq_us = 0;    // O intervalo da troca não conta como erro de período
+    next_target_us = time_us_64() + period_us;
+    return add_repeating_timer_us(-(int64_t)period_us, sample_timer_callback, NULL, &timer);
+}
+
+bool sample_clock_pop(sample_t *out) {
+    uint32_t tail = ring_tail;
+    if (ring_head == tail) {
+        return false;
+    }
+    __dmb();
+    *out = ring[tail % SAMPLE_QUEUE_LEN];
+    __dmb();
+    ring_tail = tail + 1;
+    return true;
+}
+
+void sample_clock_get_stats(sample_clock_stats_t *out) {
+    uint32_t irq = save_and_disable_interrupts();
+    *out = stats;
+    restore_interrupts(irq);
+}
+
+void sample_clock_print_stats(void) {
+    sample_clock_stats_t s;
+    sample_clock_get_stats(&s);
+
+    uint32_t ticks = 0;
+    for (int i = 0; i < SAMPLE_JITTER_BINS; i++) {
+        ticks += s.hist[i];
+    }
+
+    printf("Amostras: %lu (perdidas %lu, disparos nao atendidos %lu, falhas AHT20 %lu, BMP280 %lu, atrasadas %lu)\n",
+           (unsigned long)s.samples, (unsigned long)s.dropped, (unsigned long)s.missed,
+           (unsigned long)s.aht_fail, (unsigned long)s.bmp_fail, (unsigned long)s.late);
+    printf("Atendimento na tarefa (carimbo -> I2C): max %lu us\n", (unsigned long)s.max_service_us);
+    printf("Atraso: medio %lu us, max %lu us; erro max. de periodo %lu us\n",
+           (unsigned long)(ticks ? s.sum_jitter_us / ticks : 0),
+           (unsigned long)s.max_jitter_us, (unsigned long)s.max_period_err_us);
+    for (int i = 0; i < SAMPLE_JITTER_BINS; i++) {
+        if (i < SAMPLE_JITTER_BINS - 1) {
+            printf("  < %5lu us: %lu\n", (unsigned long)jitter_bin_limit[i], (unsigned long)s.hist[i]);
+        } else {
+            printf("  >=%5lu us: %lu\n", (unsigned long)jitter_bin_limit[i - 1], (unsigned long)s.hist[i]);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef SAMPLE_CLOCK_H
+#define SAMPLE_CLOCK_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "aht20.h"
+#include "scheduler.h"
+
+// Amostragem dos sensores em calendário absoluto.
+//
+// Um repeating_timer com atraso negativo dispara a cada período contado a
+// partir do alvo anterior (não do fim do trabalho), então o período não deriva.
+// As interrupções só carimbam o instante e sinalizam uma tarefa esporádica do
+// escalonador (sched_signal): o I2C, com timeout, roda em sample_clock_service()
+// nessa tarefa. Ela lê o BMP280 e dispara o AHT20; um alarme de um disparo a
+// sinaliza de novo para buscar o resultado do AHT20 após a conversão. Assim um
+// barramento lento não prende o pool de alarmes do core 0. As amostras
+// prontas, com o instante carimbado, vão para uma fila consumida por outra
+// tarefa.
+
+#define SAMPLE_QUEUE_LEN        8
+#define SAMPLE_JITTER_BINS      8
+#define SAMPLE_LATE_US          1000    // Acordar mais que isso após o alvo conta como atraso
+
+// Conversão do AHT20: ~80 ms, depois consulta a cada 10 ms
+#define SAMPLE_AHT20_CONVERSION_US  80000
+#define SAMPLE_AHT20_POLL_US        10000
+#define SAMPLE_AHT20_MAX_POLLS      5
+
+typedef struct {
+    uint32_t seq;
+    uint64_t time_us;           // Instante de amostragem (carimbado na ISR do timer)
+    int32_t bmp_raw_temp;
+    int32_t bmp_raw_press;
+    bool bmp_ok;
+    AHT20_Data aht;
+    bool aht_ok;
+} sample_t;
+
+typedef struct {
+    uint32_t samples;           // Amostras concluídas
+    uint32_t dropped;           // Amostras perdidas por fila cheia
+    uint32_t aht_fail;          // Leituras do AHT20 sem resultado
+    uint32_t bmp_fail;          // Leituras do BMP280 sem resposta no barramento
+    uint32_t missed;            // Disparos perdidos: a tarefa não atendeu o anterior a tempo
+    uint32_t max_service_us;    // Maior atraso entre o carimbo e o início do I2C na tarefa
+    uint32_t late;              // Acordares com atraso > SAMPLE_LATE_US
+    uint32_t max_jitter_us;     // Maior atraso em relação ao alvo
+    uint64_t sum_jitter_us;
+    uint32_t max_period_err_us; // Maior desvio entre aquisições consecutivas e o período
+    uint32_t hist[SAMPLE_JITTER_BINS]; // Histograma do atraso (limites em sample_clock_print_stats)
+} sample_clock_stats_t;
+
+// Inicia a amostragem periódica no barramento i2c (BMP280 + AHT20). task é
+// uma tarefa esporádica (período 0) que chama sample_clock_service().
+bool sample_clock_start(i2c_inst_t *i2c, uint32_t period_us, sched_task_t *task);
+
+// Trabalho no barramento pedido pelas interrupções (contexto de tarefa)
+void sample_clock_service(void);
+
+// Troca o período: o calendário recomeça um período após a chamada (fora de ISR)
+bool sample_clock_set_period(uint32_t period_us);
+
+// Retira a próxima amostra pronta; false se a fila estiver vazia
+bool sample_clock_pop(sample_t *out);
+
+void sample_clock_get_stats(sample_clock_stats_t *out);
+
+// Imprime o histograma de atraso e os contadores na serial
+void sample_clock_print_stats(void);
+
+#endif // SAMPLE_CLOCK_H
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "cpu_load.h"
+#include "scheduler.h"
+
+void sched_init(scheduler_t *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+sched_task_t *sched_add(scheduler_t *s, const char *name, sched_task_fn_t fn, void *ctx,
+                        uint32_t period_us, uint32_t deadline_us, uint32_t offset_us) {
+    if (s->num_tasks >= SCHED_MAX_TASKS) {
+        return NULL;
+    }
+
+    sched_task_t *t = &s->tasks[s->num_tasks++];
+    memset(t, 0, sizeof(*t));
+    t->name = name;
+    t->fn = fn;
+    t->ctx = ctx;
+    t->period_us = period_us;
+    t->deadline_us = deadline_us ? deadline_us : period_us;
+    t->release_us = period_us ? time_us_64() + offset_us : UINT64_MAX;
+    return t;
+}
+
+void sched_signal(sched_task_t *t) {
+    t->signaled = true;
+    __sev(); // Acorda o laço se estiver em WFE
+}
+
+static bool has_signal(const scheduler_t *s) {
+    for (int i = 0; i < s->num_tasks; i++) {
+        if (s->tasks[i].signaled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sinais das ISRs viram liberações no instante em que o laço os vê
+static void take_signals(scheduler_t *s, uint64_t now) {
+    for (int i = 0; i < s->num_tasks; i++) {
+        sched_task_t *t = &s->tasks[i];
+        if (t->signaled) {
+            t->signaled = false;
+            if (t->release_us == UINT64_MAX) {
+                t->release_us = now;
+            }
+        }
+    }
+}
+
+static void complete_job(sched_task_t *t, uint32_t runtime_us, uint64_t now) {
+    t->jobs++;
+    t->last_runtime_us = runtime_us;
+    t->total_runtime_us += runtime_us;
+    if (runtime_us > t->max_runtime_us) {
+        t->max_runtime_us = runtime_us;
+    }
+
+    if (now - t->release_us > t->deadline_us) {
+        t->misses++;
+    }
+
+    if (t->period_us == 0) {
+        t->release_us = UINT64_MAX;     // Espera o próximo sinal
+        return;
+    }
+
+    // Próxima liberação no calendário absoluto; liberações já vencidas são puladas
+    t->release_us += t->period_us;
+    while (t->release_us + t->period_us <= now) {
+        t->release_us += t->period_us;
+        t->misses++;
+    }
+}
+
+bool sched_run_once(scheduler_t *s) {
+    uint64_t now = time_us_64();
+    sched_task_t *best = NULL;
+    take_signals(s, now);
+
+    // Entre as tarefas prontas, escolhe a de prazo absoluto mais próximo
+    for (int i = 0; i < s->num_tasks; i++) {
+        sched_task_t *t = &s->tasks[i];
+        if (t->release_us > now) {
+            continue;
+        }
+        if (!best || t->release_us + t->deadline_us < best->release_us + best->deadline_us) {
+            best = t;
+        }
+    }
+
+    if (!best) {
+        return false;
+    }
+
+    uint64_t latency = now - best->release_us;
+    if (latency > best->max_latency_us) {
+        best->max_latency_us = (uint32_t)latency;
+    }
+
+    uint64_t start = time_us_64();
+    best->fn(best);
+    uint64_t end = time_us_64();
+    complete_job(best, (uint32_t)(end - start), end);
+    return true;
+}
+
+uint64_t sched_next_event_us(const scheduler_t *s) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < s->num_tasks; i++) {
+        uint64_t at = s->tasks[i].release_us;
+        if (at < next) {
+            next = at;
+        }
+    }
+    return next;
+}
+
+void sched_run(scheduler_t *s) {
+    while (true) {
+        if (sched_run_once(s)) {
+            continue;
+        }
+
+        // Nenhuma tarefa pronta: dorme até a próxima liberação ou um sinal
+        // (sched_signal faz __sev, então um sinal logo antes do WFE não se perde)
+        uint64_t next = sched_next_event_us(s);
+        uint64_t now = time_us_64();
+        if (next > now) {
+            cpu_load_idle_begin();
+            while (!has_signal(s) && time_us_64() < next) {
+                best_effort_wfe_or_timeout(from_us_since_boot(next));
+            }
+            cpu_load_idle_end();
+            s->idle_us += time_us_64() - now;
+        }
+    }
+}
+
+void sched_print_stats(const scheduler_t *s) {
+    printf("Tarefa      jobs  perdas  med(us)  max(us)  lat.max(us)\n");
+    for (int i = 0; i < s->num_tasks; i++) {
+        const sched_task_t *t = &s->tasks[i];
+        uint32_t avg = t->jobs ? (uint32_t)(t->total_runtime_us / t->jobs) : 0;
+        printf("%-10s %5lu  %6lu  %7lu  %7lu  %11lu\n", t->name,
+               (unsigned long)t->jobs, (unsigned long)t->misses, (unsigned long)avg,
+               (unsigned long)t->max_runtime_us, (unsigned long)t->max_latency_us);
+    }
+}
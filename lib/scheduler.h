@@ -0,0 +1,69 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "pico/stdlib.h"
+
+// Escalonador cooperativo com tarefas periódicas.
+//
+// Cada tarefa é liberada em instantes absolutos (release += period), então o
+// período não acumula o tempo de execução. Cada job roda até o fim: esperas
+// longas (ex.: conversão do AHT20) ficam com timers, fora das tarefas.
+// Tarefas esporádicas (período 0) são liberadas por sched_signal(), que pode
+// ser chamado de uma ISR: a interrupção só sinaliza e o trabalho (ex.: I2C)
+// roda aqui, em contexto de tarefa.
+
+#define SCHED_MAX_TASKS 8
+
+typedef struct sched_task sched_task_t;
+typedef void (*sched_task_fn_t)(sched_task_t *task);
+
+struct sched_task {
+    const char *name;
+    sched_task_fn_t fn;
+    void *ctx;
+    uint32_t period_us;         // 0: esporádica (sched_signal)
+    uint32_t deadline_us;       // Prazo relativo à liberação
+    uint64_t release_us;        // Liberação do job atual (UINT64_MAX: esporádica sem sinal)
+    volatile bool signaled;     // sched_signal() pendente
+
+    // Estatísticas
+    uint32_t jobs;              // Jobs concluídos
+    uint32_t misses;            // Jobs concluídos após o prazo ou liberações puladas
+    uint32_t last_runtime_us;   // Tempo de CPU do último job
+    uint32_t max_runtime_us;
+    uint64_t total_runtime_us;
+    uint32_t max_latency_us;    // Maior atraso entre liberação e início do job
+};
+
+typedef struct {
+    sched_task_t tasks[SCHED_MAX_TASKS];
+    uint8_t num_tasks;
+    uint64_t idle_us;           // Tempo total dormindo à espera da próxima tarefa
+} scheduler_t;
+
+void sched_init(scheduler_t *s);
+
+// Adiciona uma tarefa; offset_us desloca a primeira liberação. Com period_us 0
+// a tarefa só roda após sched_signal() (deadline_us é então obrigatório).
+// Retorna NULL se não houver espaço.
+sched_task_t *sched_add(scheduler_t *s, const char *name, sched_task_fn_t fn, void *ctx,
+                        uint32_t period_us, uint32_t deadline_us, uint32_t offset_us);
+
+// Libera uma tarefa esporádica (seguro em ISR); sinais antes do job rodar se
+// juntam em um só
+void sched_signal(sched_task_t *t);
+
+// Executa a tarefa pronta de prazo mais próximo (EDF), se houver.
+// Retorna true se alguma tarefa rodou.
+bool sched_run_once(scheduler_t *s);
+
+// Instante absoluto (us) do próximo evento do escalonador
+uint64_t sched_next_event_us(const scheduler_t *s);
+
+// Laço principal: executa tarefas e dorme até o próximo evento ou sinal
+void sched_run(scheduler_t *s);
+
+// Imprime as estatísticas de cada tarefa na serial
+void sched_print_stats(const scheduler_t *s);
+
+#endif // SCHEDULER_H
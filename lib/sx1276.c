@@ -0,0 +1,633 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "sx1276.h"
+
+void lora_spi_init(lora_dev_t *dev) {
+    gpio_init(dev->pin_cs);
+    gpio_set_dir(dev->pin_cs, GPIO_OUT);
+    gpio_put(dev->pin_cs, 1);
+
+    gpio_init(dev->pin_rst);
+    gpio_set_dir(dev->pin_rst, GPIO_OUT);
+
+    spi_init(dev->spi, 1000 * 1000);
+    gpio_set_function(dev->pin_miso, GPIO_FUNC_SPI);
+    gpio_set_function(dev->pin_sck, GPIO_FUNC_SPI);
+    gpio_set_function(dev->pin_mosi, GPIO_FUNC_SPI);
+}
+
+// --- Interrupções por rádio ---
+// Um só callback de GPIO por núcleo no SDK: o despachante procura o rádio
+// dono do pino e chama a ISR registrada para ele
+static lora_dev_t *irq_devs[LORA_MAX_DEVS];
+
+bool lora_irq_attach(lora_dev_t *dev, lora_irq_handler_t handler, void *ctx) {
+    int free_slot = -1;
+    for (int i = 0; i < LORA_MAX_DEVS; i++) {
+        if (irq_devs[i] == dev) {
+            free_slot = i;
+            break;
+        }
+        if (!irq_devs[i] && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        return false;
+    }
+    dev->irq_handler = NULL;    // Nunca a ISR nova com o contexto da anterior
+    dev->irq_ctx = ctx;
+    dev->irq_handler = handler;
+    irq_devs[free_slot] = dev;
+    return true;
+}
+
+bool lora_irq_dispatch(uint gpio, uint32_t events) {
+    for (int i = 0; i < LORA_MAX_DEVS; i++) {
+        lora_dev_t *dev = irq_devs[i];
+        if (!dev || (gpio != dev->pin_dio0 && gpio != dev->pin_dio1)) {
+            continue;
+        }
+        if (dev->irq_handler) {
+            dev->irq_handler(dev, gpio == dev->pin_dio0 ? 0 : 1, events);
+        }
+        return true;
+    }
+    return false;
+}
+
+static void irq_callback(uint gpio, uint32_t events) {
+    lora_irq_dispatch(gpio, events);
+}
+
+void lora_irq_enable(lora_dev_t *dev, uint8_t dio, uint32_t events, bool enabled) {
+    gpio_set_irq_enabled_with_callback(dio == 0 ? dev->pin_dio0 : dev->pin_dio1, events, enabled, &irq_callback);
+}
+
+// --- Cópia sombra dos registradores ---
+// Guarda o último valor escrito/lido de cada registrador de configuração.
+// Escritas iguais ao valor conhecido são omitidas e leituras de configuração
+// estática são servidas da RAM. Registradores que o rádio altera sozinho
+// (FIFO, flags, status, ponteiros) nunca são armazenados. Uma cópia por
+// rádio (lora_dev_t).
+static bool reg_is_volatile(lora_dev_t *dev, uint8_t reg) {
+    switch (reg) {
+    case REG_FIFO:
+    case REG_FIFO_ADDR_PTR:         // Avança a cada acesso à FIFO
+    case REG_FIFO_RX_CURRENT_ADDR:
+    case REG_IRQ_FLAGS:             // Escrita de 1 limpa a flag
+    case REG_FIFO_RX_BYTE_ADDR:
+    case REG_RSSI_WIDEBAND:
+    case REG_TEMP_FSK:
+    case REG_IRQ_FLAGS1_FSK:
+    case REG_IRQ_FLAGS2:
+        return true;
+    default:
+        // No FSK: RSSI e a estimativa de desvio (RegFeiMsb/Lsb em 0x1D/0x1E)
+        if (dev->fsk_active && (reg == REG_RSSI_VALUE_FSK || reg == REG_MODEM_CONFIG || reg == REG_MODEM_CONFIG2)) {
+            return true;
+        }
+        // RX_NB_BYTES até HOP_CHANNEL: contadores e status de pacote
+        if (reg >= REG_RX_NB_BYTES && reg <= REG_HOP_CHANNEL) {
+            return true;
+        }
+        // Estimativa de erro de frequência (3 registradores)
+        return reg >= REG_FREQ_ERROR && reg <= REG_FREQ_ERROR + 2;
+    }
+}
+
+static inline bool shadow_has(lora_dev_t *dev, uint8_t reg) {
+    return dev->shadow_valid[reg >> 3] & (1u << (reg & 7));
+}
+
+static inline void shadow_set(lora_dev_t *dev, uint8_t reg, uint8_t val) {
+    if (reg_is_volatile(dev, reg)) {
+        return;
+    }
+    dev->shadow[reg] = val;
+    dev->shadow_valid[reg >> 3] |= (1u << (reg & 7));
+}
+
+static inline void shadow_forget(lora_dev_t *dev, uint8_t reg) {
+    dev->shadow_valid[reg >> 3] &= ~(1u << (reg & 7));
+}
+
+void lora_shadow_invalidate(lora_dev_t *dev) {
+    for (int i = 0; i < LORA_NUM_REGS / 8; i++) {
+        dev->shadow_valid[i] = 0;
+    }
+}
+
+// O modo TX volta sozinho para Standby no TxDone (assim como RX single e CAD).
+// Ao limpar as flags de IRQ o modo armazenado deixa de ser confiável.
+static void opmode_after_irq_clear(lora_dev_t *dev) {
+    if (shadow_has(dev, REG_OPMODE) && dev->shadow[REG_OPMODE] != RF95_MODE_STANDBY &&
+        dev->shadow[REG_OPMODE] != RF95_MODE_SLEEP && dev->shadow[REG_OPMODE] != RF95_MODE_RX_CONTINUOUS) {
+        shadow_forget(dev, REG_OPMODE);
+    }
+}
+
+// --- Funções de baixo nível para SPI ---
+static void spi_write_raw(lora_dev_t *dev, uint8_t reg, const uint8_t *data, size_t len) {
+    uint8_t addr = reg | 0x80;
+    gpio_put(dev->pin_cs, 0);
+    spi_write_blocking(dev->spi, &addr, 1);
+    spi_write_blocking(dev->spi, data, len);
+    gpio_put(dev->pin_cs, 1);
+}
+
+static void spi_read_raw(lora_dev_t *dev, uint8_t reg, uint8_t *data, size_t len) {
+    uint8_t addr = reg & 0x7F;
+    gpio_put(dev->pin_cs, 0);
+    spi_write_blocking(dev->spi, &addr, 1);
+    spi_read_blocking(dev->spi, 0, data, len);
+    gpio_put(dev->pin_cs, 1);
+}
+
+void lora_write_reg(lora_dev_t *dev, uint8_t reg, uint8_t val) {
+    if (shadow_has(dev, reg) && dev->shadow[reg] == val) {
+        dev->spi_stats.skipped_writes++;
+        return;
+    }
+
+    spi_write_raw(dev, reg, &val, 1);
+    dev->spi_stats.writes++;
+
+    if (reg == REG_IRQ_FLAGS) {
+        opmode_after_irq_clear(dev);
+    }
+    shadow_set(dev, reg, val);
+}
+
+uint8_t lora_read_reg(lora_dev_t *dev, uint8_t reg) {
+    // O modo pode mudar sozinho, então REG_OPMODE sempre vem do rádio
+    if (reg != REG_OPMODE && shadow_has(dev, reg)) {
+        dev->spi_stats.cached_reads++;
+        return dev->shadow[reg];
+    }
+
+    uint8_t val;
+    spi_read_raw(dev, reg, &val, 1);
+    dev->spi_stats.reads++;
+    shadow_set(dev, reg, val);
+    return val;
+}
+
+void lora_write_burst(lora_dev_t *dev, uint8_t reg, const uint8_t *data, size_t len) {
+    // Descarta as pontas que já estão com o valor desejado
+    while (len && shadow_has(dev, reg) && dev->shadow[reg] == data[0]) {
+        reg++;
+        data++;
+        len--;
+        dev->spi_stats.skipped_writes++;
+    }
+    while (len && shadow_has(dev, reg + len - 1) && dev->shadow[reg + len - 1] == data[len - 1]) {
+        len--;
+        dev->spi_stats.skipped_writes++;
+    }
+    if (len == 0) {
+        return;
+    }
+
+    // Endereço incrementa automaticamente: uma única transação SPI
+    spi_write_raw(dev, reg, data, len);
+    dev->spi_stats.bursts++;
+
+    for (size_t i = 0; i < len; i++) {
+        shadow_set(dev, reg + i, data[i]);
+    }
+}
+
+void lora_read_burst(lora_dev_t *dev, uint8_t reg, uint8_t *data, size_t len) {
+    spi_read_raw(dev, reg, data, len);
+    dev->spi_stats.reads++;
+    for (size_t i = 0; i < len; i++) {
+        shadow_set(dev, reg + i, data[i]);
+    }
+}
+
+void lora_apply_regs(lora_dev_t *dev, const lora_reg_val_t *regs, size_t count) {
+    uint8_t buf[LORA_NUM_REGS];
+    size_t i = 0;
+
+    while (i < count) {
+        // Agrupa registradores de endereços consecutivos em uma rajada
+        size_t n = 0;
+        uint8_t first = regs[i].reg;
+        while (i < count && regs[i].reg == first + n) {
+            buf[n++] = regs[i++].val;
+        }
+        lora_write_burst(dev, first, buf, n);
+    }
+}
+
+void lora_set_dio_mapping(lora_dev_t *dev, uint8_t mask, uint8_t value) {
+    // Leitura vem da cópia sombra; a escrita é omitida se nada mudar
+    uint8_t map = lora_read_reg(dev, REG_DIO_MAPPING_1);
+    lora_write_reg(dev, REG_DIO_MAPPING_1, (map & ~mask) | (value & mask));
+}
+
+void lora_write_fifo(lora_dev_t *dev, const uint8_t *data, size_t len) {
+    spi_write_raw(dev, REG_FIFO, data, len);
+    dev->spi_stats.bursts++;
+}
+
+void lora_read_fifo(lora_dev_t *dev, uint8_t *data, size_t len) {
+    spi_read_raw(dev, REG_FIFO, data, len);
+    dev->spi_stats.reads++;
+    dev->spi_stats.fifo_read_bytes += len;
+}
+
+void lora_get_spi_stats(const lora_dev_t *dev, lora_spi_stats_t *out) {
+    *out = dev->spi_stats;
+}
+
+// --- Funções de alto nível do LoRa ---
+void lora_reset(lora_dev_t *dev) {
+    // Pulso de reset (mínimo de 100 us no datasheet)
+    gpio_put(dev->pin_rst, 0);
+    sleep_us(100);
+    gpio_put(dev->pin_rst, 1);
+
+    // Após o reset os registradores voltam ao padrão
+    lora_shadow_invalidate(dev);
+}
+
+bool lora_wait_ready(lora_dev_t *dev, uint32_t timeout_ms) {
+    // Em vez de um atraso fixo, consulta o registrador de versão até o rádio responder
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    while (true) {
+        uint8_t version;
+        spi_read_raw(dev, REG_VERSION, &version, 1);
+        dev->spi_stats.reads++;
+        if (version == LORA_VERSION) {
+            shadow_set(dev, REG_VERSION, version);
+            return true;
+        }
+        if (time_reached(deadline)) {
+            return false;
+        }
+        sleep_us(100);
+    }
+}
+
+// Escreve o modo e confirma pela leitura de volta (repete até o rádio aceitar)
+static bool lora_set_mode_verified(lora_dev_t *dev, uint8_t mode, uint32_t timeout_ms) {
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+    while (true) {
+        lora_write_reg(dev, REG_OPMODE, mode);
+        if (lora_read_reg(dev, REG_OPMODE) == mode) {
+            return true;
+        }
+        if (time_reached(deadline)) {
+            return false;
+        }
+        sleep_us(100);
+    }
+}
+
+void lora_set_frequency(lora_dev_t *dev, long frequency) {
+    uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+    uint8_t buf[3] = { (uint8_t)(frf >> 16), (uint8_t)(frf >> 8), (uint8_t)(frf >> 0) };
+    lora_write_burst(dev, REG_FRF_MSB, buf, 3);
+}
+
+// Header explícito, CR 4/5, BW 125kHz, SF 7 e CRC ativado (DEVE SER IGUAL NO TX E NO RX)
+#define MODEM_CONFIG_STD    (EXPLICIT_MODE | ERROR_CODING_4_5 | BANDWIDTH_125K)
+#define MODEM_CONFIG2_STD   (SPREADING_7 | CRC_ON)
+
+// Perfil comum a TX e RX (endereços crescentes para agrupar em rajadas)
+static const lora_reg_val_t profile_common[] = {
+    { REG_LNA,              LNA_MAX_GAIN },     // LNA com ganho máximo
+    { REG_MODEM_CONFIG,     MODEM_CONFIG_STD },
+    { REG_MODEM_CONFIG2,    MODEM_CONFIG2_STD },
+    { REG_PREAMBLE_MSB,     (uint8_t)(LORA_PREAMBLE_LEN >> 8) },
+    { REG_PREAMBLE_LSB,     (uint8_t)LORA_PREAMBLE_LEN },
+    { REG_MODEM_CONFIG3,    0x04 },             // LnaGain set by REG_LNA, LnaAgcOn=1
+};
+
+static const lora_reg_val_t profile_tx[] = {
+    { REG_PA_CONFIG,        PA_MAX_BOOST },     // 20dBm (máximo com PA_BOOST)
+    { REG_FIFO_ADDR_PTR,    0 },
+    { REG_FIFO_TX_BASE_AD,  0 },
+    { REG_DIO_MAPPING_1,    DIO0_TX_DONE },     // DIO0 -> TxDone
+    { REG_PA_DAC,           PA_DAC_20 },
+};
+
+static const lora_reg_val_t profile_rx[] = {
+    { REG_FIFO_ADDR_PTR,    0 },
+    { REG_FIFO_RX_BASE_AD,  0 },
+    { REG_DIO_MAPPING_1,    DIO0_RX_DONE },     // DIO0 -> RxDone
+};
+
+// SF6 só demodula com header implícito e a detecção ajustada (datasheet 4.1.1.2)
+static const lora_reg_val_t profile_fast[] = {
+    { REG_MODEM_CONFIG,         IMPLICIT_MODE | ERROR_CODING_4_5 | BANDWIDTH_125K },
+    { REG_MODEM_CONFIG2,        SPREADING_6 | CRC_ON },
+    { REG_DETECT_OPT,           0xC5 },     // DetectionOptimize = 0x05
+    { REG_DETECTION_THRESHOLD,  0x0C },
+};
+
+static const lora_reg_val_t profile_std[] = {
+    { REG_MODEM_CONFIG,         MODEM_CONFIG_STD },
+    { REG_MODEM_CONFIG2,        MODEM_CONFIG2_STD },
+    { REG_DETECT_OPT,           0xC3 },     // SF7 a SF12 (valor de reset)
+    { REG_DETECTION_THRESHOLD,  0x0A },
+};
+
+// Reset, ativação do modo LoRa e parâmetros do modem comuns a TX e RX
+static bool lora_init_common(lora_dev_t *dev) {
+    lora_reset(dev);
+    if (!lora_wait_ready(dev, LORA_READY_TIMEOUT_MS)) {
+        printf("Radio LoRa nao responde!\n");
+        return false;
+    }
+
+    // Modo Sleep com o bit LongRangeMode (RF95_MODE_SLEEP já inclui 0x80);
+    // a leitura de volta confirma que o modo LoRa foi ativado
+    if (!lora_set_mode_verified(dev, RF95_MODE_SLEEP, LORA_READY_TIMEOUT_MS)) {
+        printf("Falha ao iniciar o modo LoRa!\n");
+        return false;
+    }
+    dev->fsk_active = false;
+    dev->fast_mode = false;
+
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY); // Volta para Standby
+
+    // Configura a frequência e os parâmetros do modem
+    lora_set_frequency(dev, dev->frequency_hz);
+    lora_apply_regs(dev, profile_common, sizeof(profile_common) / sizeof(profile_common[0]));
+
+    return true;
+}
+
+bool lora_init(lora_dev_t *dev) {
+    if (!lora_init_common(dev)) {
+        return false;
+    }
+
+    lora_apply_regs(dev, profile_tx, sizeof(profile_tx) / sizeof(profile_tx[0]));
+
+    // Colocar em modo Standby, pronto para transmitir
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY);
+    printf("Módulo LoRa (TX) inicializado com sucesso!\n");
+    return true;
+}
+
+bool lora_init_rx(lora_dev_t *dev) {
+    if (!lora_init_common(dev)) {
+        return false;
+    }
+
+    lora_apply_regs(dev, profile_rx, sizeof(profile_rx) / sizeof(profile_rx[0]));
+
+    // Colocar em modo de recepção contínua
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_RX_CONTINUOUS);
+    printf("Módulo LoRa (RX) inicializado e ouvindo...\n");
+    return true;
+}
+
+void lora_load_tx(lora_dev_t *dev, const uint8_t *payload, uint8_t len) {
+    // Colocar em modo Standby (omitido se o rádio já estiver em Standby)
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY);
+
+    // Apontar para o início da FIFO de TX e definir tamanho do payload
+    lora_write_reg(dev, REG_FIFO_ADDR_PTR, 0);
+    lora_write_reg(dev, REG_PAYLOAD_LENGTH, len);
+
+    // Escrever o payload na FIFO em uma única transação
+    lora_write_fifo(dev, payload, len);
+
+    // Limpar as flags de IRQ
+    lora_write_reg(dev, REG_IRQ_FLAGS, 0xFF);
+}
+
+void lora_start_tx(lora_dev_t *dev, const uint8_t *payload, uint8_t len) {
+    lora_load_tx(dev, payload, len);
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_TX);
+}
+
+void lora_start_cad(lora_dev_t *dev) {
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY);
+
+    dev->dio_map_before_cad = lora_read_reg(dev, REG_DIO_MAPPING_1);
+    lora_set_dio_mapping(dev, DIO0_MASK | DIO1_MASK, DIO0_CAD_DONE | DIO1_CAD_DETECTED);
+
+    lora_write_reg(dev, REG_IRQ_FLAGS, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_CAD);
+}
+
+bool lora_cad_finish(lora_dev_t *dev) {
+    // Ao fim da CAD o rádio volta sozinho para Standby
+    uint8_t flags = lora_read_reg(dev, REG_IRQ_FLAGS);
+    lora_write_reg(dev, REG_IRQ_FLAGS, IRQ_CAD_DONE | IRQ_CAD_DETECTED);
+    lora_write_reg(dev, REG_DIO_MAPPING_1, dev->dio_map_before_cad);
+    return (flags & IRQ_CAD_DETECTED) != 0;
+}
+
+void lora_start_rx_single(lora_dev_t *dev, uint16_t symb_timeout) {
+    if (symb_timeout > 0x3FF) {
+        symb_timeout = 0x3FF;
+    }
+    // SymbTimeout tem 10 bits: os 2 mais altos ficam em REG_MODEM_CONFIG2
+    uint8_t config2 = lora_read_reg(dev, REG_MODEM_CONFIG2);
+    lora_write_reg(dev, REG_MODEM_CONFIG2, (config2 & ~0x03) | (uint8_t)(symb_timeout >> 8));
+    lora_write_reg(dev, REG_SYMB_TIMEOUT_LSB, (uint8_t)symb_timeout);
+
+    lora_set_dio_mapping(dev, DIO0_MASK, DIO0_RX_DONE);
+    lora_write_reg(dev, REG_FIFO_ADDR_PTR, 0);
+    lora_write_reg(dev, REG_IRQ_FLAGS, 0xFF);
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_RX_SINGLE);
+}
+
+void lora_sleep(lora_dev_t *dev) {
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_SLEEP);
+}
+
+void lora_set_tx_power(lora_dev_t *dev, int8_t dbm) {
+    if (dbm < LORA_TX_POWER_MIN) {
+        dbm = LORA_TX_POWER_MIN;
+    } else if (dbm > LORA_TX_POWER_MAX) {
+        dbm = LORA_TX_POWER_MAX;
+    }
+    // Pout = 17 - (15 - OutputPower); com o PA_DAC em 20 dBm a saída sobe 3 dB
+    if (dbm > 17) {
+        lora_write_reg(dev, REG_PA_DAC, PA_DAC_20);
+        lora_write_reg(dev, REG_PA_CONFIG, PA_BOOST | (uint8_t)(dbm - 5));
+    } else {
+        lora_write_reg(dev, REG_PA_DAC, PA_DAC_DEFAULT);
+        lora_write_reg(dev, REG_PA_CONFIG, PA_BOOST | (uint8_t)(dbm - 2));
+    }
+}
+
+void lora_send_packet(lora_dev_t *dev, const uint8_t *payload, uint8_t len) {
+    lora_start_tx(dev, payload, len);
+
+    // Aguardar a flag TxDone
+    while ((lora_read_reg(dev, REG_IRQ_FLAGS) & 0x08) == 0);
+
+    // Limpar a flag de IRQ
+    lora_write_reg(dev, REG_IRQ_FLAGS, 0xFF);
+}
+
+// SNR, RSSI e erro de frequência do último pacote (duas rajadas)
+static void lora_read_meta(lora_dev_t *dev, lora_rx_meta_t *meta) {
+    uint8_t pkt[2];     // REG_PKT_SNR_VALUE, REG_PKT_RSSI_VALUE
+    uint8_t ferr[3];    // REG_FREQ_ERROR MSB..LSB (20 bits com sinal)
+
+    lora_read_burst(dev, REG_PKT_SNR_VALUE, pkt, 2);
+    lora_read_burst(dev, REG_FREQ_ERROR, ferr, 3);
+
+    meta->snr_q4 = (int8_t)pkt[0];
+
+    // Porta de alta frequência (> 525 MHz), conforme o datasheet do SX1276
+    if (meta->snr_q4 < 0) {
+        meta->rssi_dbm = -157 + pkt[1] + meta->snr_q4 / 4;
+    } else {
+        meta->rssi_dbm = -157 + pkt[1] * 16 / 15;
+    }
+
+    int32_t raw = ((int32_t)(ferr[0] & 0x0F) << 16) | ((int32_t)ferr[1] << 8) | ferr[2];
+    if (raw & 0x80000) {
+        raw -= 0x100000;
+    }
+    // Ferr = FreqError * 2^24 / Fxtal * BW / 500 kHz
+    meta->freq_error_hz = (int32_t)(((int64_t)raw << 24) * (LORA_BW_HZ / 1000) / (32000000LL * 500));
+}
+
+int lora_receive_packet(lora_dev_t *dev, uint8_t *buffer, int max_len, lora_rx_meta_t *meta) {
+    // Verifica se a flag de 'RxDone' foi acionada
+    uint8_t flags = lora_read_reg(dev, REG_IRQ_FLAGS);
+    if ((flags & 0x40) == 0) {
+        return 0; // Nenhum pacote recebido
+    }
+
+    // Limpa a flag de IRQ
+    lora_write_reg(dev, REG_IRQ_FLAGS, 0xFF);
+
+    // O próximo quadro vai para a outra metade da FIFO enquanto este é lido
+    // (a base vem da cópia sombra, sem leitura no SPI). O modem fixa a base
+    // no preâmbulo: com outro quadro já chegando, a troca só valeria para o
+    // seguinte a ele, que cairia por cima deste. Nesse caso a base fica; o
+    // quadro em curso vem para esta metade e a conferência no fim o detecta.
+    if (LORA_RX_DOUBLE_BUFFER &&
+        !(lora_read_reg(dev, REG_MODEM_STAT) &
+          (MODEM_STAT_SIGNAL_DETECTED | MODEM_STAT_SYNCHRONIZED | MODEM_STAT_HEADER_VALID))) {
+        lora_write_reg(dev, REG_FIFO_RX_BASE_AD, lora_read_reg(dev, REG_FIFO_RX_BASE_AD) ^ LORA_RX_REGION_LEN);
+    }
+
+    // Pega o tamanho do pacote recebido
+    int len = lora_read_reg(dev, REG_RX_NB_BYTES);
+    if (len > max_len) {
+        len = max_len;
+    }
+
+    if (meta) {
+        meta->time_us = time_us_32();
+        meta->crc_ok = (flags & 0x20) == 0;
+        meta->filtered = false;
+        meta->overrun = false;
+        meta->len = (uint8_t)len;
+    }
+
+    // Verifica se houve erro de CRC
+    if (flags & 0x20) {
+        if (meta) {
+            lora_read_meta(dev, meta);
+        }
+        printf("Erro de CRC!\n");
+        return 0;
+    }
+
+    // Aponta para o início do pacote na FIFO
+    uint8_t current_addr = lora_read_reg(dev, REG_FIFO_RX_CURRENT_ADDR);
+    lora_write_reg(dev, REG_FIFO_ADDR_PTR, current_addr);
+
+    // Só o cabeçalho primeiro: quadro de outra rede ou destino para aqui.
+    // O ponteiro da FIFO avança sozinho, então o resto vem na sequência.
+    int head = 0;
+    if (dev->rx_filter && len >= dev->rx_filter_head_len) {
+        head = dev->rx_filter_head_len;
+        lora_read_fifo(dev, buffer, head);
+        if (!dev->rx_filter(buffer, (uint8_t)head, dev->rx_filter_ctx)) {
+            if (meta) {
+                meta->filtered = true;
+            }
+            return 0;
+        }
+    }
+
+    if (meta) {
+        lora_read_meta(dev, meta);
+    }
+    lora_read_fifo(dev, buffer + head, len - head);
+
+    // Logo após o RxDone o último byte escrito pelo modem é o fim deste
+    // quadro. Se agora ele estiver antes disso, dentro do quadro, o seguinte
+    // foi escrito por cima durante a leitura.
+    if (LORA_RX_DOUBLE_BUFFER) {
+        uint8_t last = lora_read_reg(dev, REG_FIFO_RX_BYTE_ADDR);
+        if ((uint8_t)(last - current_addr) < len - 1) {
+            if (meta) {
+                meta->overrun = true;
+            }
+            return 0;
+        }
+    }
+
+    return len;
+}
+
+void lora_set_fast_mode(lora_dev_t *dev, bool fast, uint8_t frame_len) {
+    // A modulação só muda fora de TX/RX
+    lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY);
+    if (fast) {
+        lora_apply_regs(dev, profile_fast, sizeof(profile_fast) / sizeof(profile_fast[0]));
+        lora_write_reg(dev, REG_PAYLOAD_LENGTH, frame_len);  // Tamanho esperado na recepção
+    } else {
+        lora_apply_regs(dev, profile_std, sizeof(profile_std) / sizeof(profile_std[0]));
+    }
+    dev->fast_mode = fast;
+}
+
+bool lora_fast_mode(const lora_dev_t *dev) {
+    return dev->fast_mode;
+}
+
+bool lora_set_long_range(lora_dev_t *dev, bool lora) {
+    if (lora == !dev->fsk_active) {
+        return true;
+    }
+    if (!lora) {
+        dev->dio_map_lora = lora_read_reg(dev, REG_DIO_MAPPING_1);
+    }
+    // LongRangeMode só muda em Sleep: primeiro o Sleep no modem atual
+    lora_write_reg(dev, REG_OPMODE, dev->fsk_active ? FSK_MODE_SLEEP : RF95_MODE_SLEEP);
+    if (!lora_set_mode_verified(dev, lora ? RF95_MODE_SLEEP : FSK_MODE_SLEEP, LORA_READY_TIMEOUT_MS)) {
+        return false;
+    }
+    // De 0x0D a 0x3F os endereços são outros registradores no outro modem
+    lora_shadow_invalidate(dev);
+    dev->fsk_active = !lora;
+
+    if (lora) {
+        lora_write_reg(dev, REG_OPMODE, RF95_MODE_STANDBY);
+        lora_apply_regs(dev, profile_common, sizeof(profile_common) / sizeof(profile_common[0]));
+        lora_apply_regs(dev, profile_std, sizeof(profile_std) / sizeof(profile_std[0]));
+        dev->fast_mode = false;
+        lora_write_reg(dev, REG_PA_RAMP, 0x09);      // Sem o filtro gaussiano (valor de reset)
+        lora_write_reg(dev, REG_DIO_MAPPING_1, dev->dio_map_lora);
+    } else {
+        lora_write_reg(dev, REG_OPMODE, FSK_MODE_STANDBY);
+    }
+    return true;
+}
+
+void lora_set_rx_filter(lora_dev_t *dev, lora_rx_filter_t filter, uint8_t head_len, void *ctx) {
+    dev->rx_filter = NULL;       // Nunca um filtro com o contexto do anterior
+    dev->rx_filter_head_len = head_len;
+    dev->rx_filter_ctx = ctx;
+    dev->rx_filter = filter;
+}
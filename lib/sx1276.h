@@ -0,0 +1,233 @@
+#ifndef SX1276_H
+#define SX1276_H
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "lora.h"
+
+// Ligação padrão do módulo LoRa (estação, tx.c e rx.c): LORA_DEV_DEFAULT
+#define LORA_SPI_PORT   spi0
+#define LORA_PIN_MISO   16
+#define LORA_PIN_MOSI   19
+#define LORA_PIN_SCK    18
+#define LORA_PIN_CS     17
+#define LORA_PIN_RST    20
+#define LORA_PIN_DIO0   21
+#define LORA_PIN_DIO1   8       // FhssChangeChannel / CadDetected (ajuste conforme a ligação)
+
+// Frequência do LoRa (em Hz)
+#define LORA_FREQUENCY  915E6
+
+#define LORA_VERSION            0x12    // Valor de REG_VERSION no SX1276
+#define LORA_READY_TIMEOUT_MS   10      // Limite para o rádio responder após reset/troca de modo
+
+// Recepção por amostragem de preâmbulo: o receptor dorme e faz uma CAD a cada
+// LORA_SNIFF_PERIOD_US. O preâmbulo do transmissor precisa cobrir esse período,
+// então o valor deve ser igual em todos os nós (0 = recepção contínua).
+#define LORA_SYMBOL_US          1024    // 2^SF / BW (SF7, 125 kHz)
+#define LORA_SNIFF_PERIOD_US    0
+#define LORA_PREAMBLE_LEN       (LORA_SNIFF_PERIOD_US / LORA_SYMBOL_US + 8)
+
+// Recepção contínua com a FIFO em duas metades: a cada RxDone a base de RX
+// (REG_FIFO_RX_BASE_AD) passa para a outra metade, e o quadro seguinte chega
+// nela enquanto este é lido. Quadros de até LORA_RX_REGION_LEN bytes nunca se
+// sobrepõem; a sobreposição é detectada por REG_FIFO_RX_BYTE_ADDR.
+#define LORA_RX_DOUBLE_BUFFER   1
+#define LORA_RX_REGION_LEN      0x80
+
+#define LORA_NUM_REGS   0x80
+#define LORA_MAX_DEVS   2       // Rádios com interrupções despachadas (lora_irq_attach)
+
+// Par registrador/valor para aplicar perfis de configuração
+typedef struct {
+    uint8_t reg;
+    uint8_t val;
+} lora_reg_val_t;
+
+// Contadores de tráfego SPI (e do que a cópia sombra economizou)
+typedef struct {
+    uint32_t writes;            // Escritas individuais enviadas
+    uint32_t reads;             // Leituras feitas no rádio
+    uint32_t bursts;            // Transações em rajada (registradores ou FIFO)
+    uint32_t skipped_writes;    // Escritas omitidas por valor já conhecido
+    uint32_t cached_reads;      // Leituras servidas pela cópia sombra
+    uint32_t fifo_read_bytes;   // Bytes lidos da FIFO (recepção)
+} lora_spi_stats_t;
+
+// Dados de enlace de cada quadro recebido
+typedef struct {
+    uint32_t time_us;       // Instante da leitura (time_us_32); quem carimba o RxDone no ISR o substitui
+    int32_t freq_error_hz;  // Erro de frequência estimado pelo modem
+    int16_t rssi_dbm;       // RSSI do pacote (corrigido pelo SNR quando negativo)
+    int8_t snr_q4;          // SNR em passos de 0,25 dB
+    bool crc_ok;
+    bool filtered;          // Descartado pelo filtro antecipado (lora_set_rx_filter)
+    bool overrun;           // Sobrescrito pelo quadro seguinte durante a leitura
+    uint8_t len;
+} lora_rx_meta_t;
+
+// Filtro antecipado da recepção (lora_set_rx_filter)
+typedef bool (*lora_rx_filter_t)(const uint8_t *head, uint8_t len, void *ctx);
+
+typedef struct lora_dev lora_dev_t;
+
+// ISR de um rádio: dio é 0 ou 1, events são as bordas (GPIO_IRQ_EDGE_*)
+typedef void (*lora_irq_handler_t)(lora_dev_t *dev, uint8_t dio, uint32_t events);
+
+// Um módulo SX1276: ligação, cópia sombra e estado do driver. Cada rádio tem
+// o seu; todas as funções lora_* recebem o rádio em que atuam. Rádios no
+// mesmo barramento SPI não podem ser acessados de ISRs (a transação de um
+// interromperia a do outro): com acesso na ISR (FSK, FHSS) cada um no seu SPI.
+struct lora_dev {
+    // Ligação (preenchida por LORA_DEV_DEFAULT ou pela aplicação)
+    spi_inst_t *spi;
+    uint8_t pin_miso;
+    uint8_t pin_mosi;
+    uint8_t pin_sck;
+    uint8_t pin_cs;
+    uint8_t pin_rst;
+    uint8_t pin_dio0;
+    uint8_t pin_dio1;
+    uint32_t frequency_hz;
+
+    // Interrupções dos DIOs (lora_irq_attach)
+    lora_irq_handler_t irq_handler;
+    void *irq_ctx;
+
+    // Cópia sombra dos registradores e contadores do SPI
+    uint8_t shadow[LORA_NUM_REGS];
+    uint8_t shadow_valid[LORA_NUM_REGS / 8];
+    lora_spi_stats_t spi_stats;
+
+    bool fast_mode;
+    bool fsk_active;                // LongRangeMode desligado (fsk.c)
+    uint8_t dio_map_lora;           // Mapeamento dos DIOs antes de ir para o FSK
+    uint8_t dio_map_before_cad;
+    lora_rx_filter_t rx_filter;
+    uint8_t rx_filter_head_len;
+    void *rx_filter_ctx;
+
+    // Canal e salto de frequência (channel_plan.c)
+    volatile uint8_t channel;
+    int32_t frf_correction;         // Correção do AFC em passos de FRF
+    bool hopping;
+    volatile uint8_t hop_index;
+    volatile uint32_t hops;
+};
+
+// Ligação da placa (pinos LORA_PIN_*), o resto zerado
+#define LORA_DEV_DEFAULT { \
+    .spi = LORA_SPI_PORT, .pin_miso = LORA_PIN_MISO, .pin_mosi = LORA_PIN_MOSI, \
+    .pin_sck = LORA_PIN_SCK, .pin_cs = LORA_PIN_CS, .pin_rst = LORA_PIN_RST, \
+    .pin_dio0 = LORA_PIN_DIO0, .pin_dio1 = LORA_PIN_DIO1, .frequency_hz = (uint32_t)LORA_FREQUENCY }
+
+// Configura SPI e os pinos de controle (CS e RST) do módulo
+void lora_spi_init(lora_dev_t *dev);
+
+// Interrupções por rádio: as bordas dos DIOs deste rádio chegam a handler
+// (na ISR do núcleo que chamou lora_irq_enable). false se já houver
+// LORA_MAX_DEVS rádios registrados.
+bool lora_irq_attach(lora_dev_t *dev, lora_irq_handler_t handler, void *ctx);
+
+// Habilita/desabilita bordas de um DIO (0 ou 1). O callback de GPIO do núcleo
+// passa a ser o despachante dos rádios: outros pinos no mesmo núcleo precisam
+// chamar lora_irq_dispatch do próprio callback.
+void lora_irq_enable(lora_dev_t *dev, uint8_t dio, uint32_t events, bool enabled);
+
+// Entrega a borda ao rádio dono do pino; false se o pino não é de nenhum rádio
+bool lora_irq_dispatch(uint gpio, uint32_t events);
+
+// Acesso de baixo nível aos registradores do SX1276 (com cópia sombra)
+void lora_write_reg(lora_dev_t *dev, uint8_t reg, uint8_t val);
+uint8_t lora_read_reg(lora_dev_t *dev, uint8_t reg);
+
+// Escreve registradores consecutivos em uma única transação SPI
+void lora_write_burst(lora_dev_t *dev, uint8_t reg, const uint8_t *data, size_t len);
+
+// Lê registradores consecutivos em uma única transação SPI
+void lora_read_burst(lora_dev_t *dev, uint8_t reg, uint8_t *data, size_t len);
+
+// Aplica uma lista de registradores (ordenada por endereço) agrupando-os em rajadas
+void lora_apply_regs(lora_dev_t *dev, const lora_reg_val_t *regs, size_t count);
+
+// Acesso em rajada à FIFO
+void lora_write_fifo(lora_dev_t *dev, const uint8_t *data, size_t len);
+void lora_read_fifo(lora_dev_t *dev, uint8_t *data, size_t len);
+
+// Altera só os bits de um pino DIO em REG_DIO_MAPPING_1 (ex.: DIO0_MASK, DIO0_TX_DONE)
+void lora_set_dio_mapping(lora_dev_t *dev, uint8_t mask, uint8_t value);
+
+// Descarta a cópia sombra (ex.: após reset do rádio)
+void lora_shadow_invalidate(lora_dev_t *dev);
+
+void lora_get_spi_stats(const lora_dev_t *dev, lora_spi_stats_t *out);
+
+// Pulso de reset seguido da espera pelo rádio responder (REG_VERSION)
+void lora_reset(lora_dev_t *dev);
+bool lora_wait_ready(lora_dev_t *dev, uint32_t timeout_ms);
+void lora_set_frequency(lora_dev_t *dev, long frequency);
+
+// Inicializa o rádio para transmissão (DIO0 -> TxDone) e deixa em Standby
+bool lora_init(lora_dev_t *dev);
+
+// Inicializa o rádio em recepção contínua (DIO0 -> RxDone)
+bool lora_init_rx(lora_dev_t *dev);
+
+// Carrega o payload na FIFO e inicia a transmissão sem aguardar o TxDone
+void lora_start_tx(lora_dev_t *dev, const uint8_t *payload, uint8_t len);
+
+// Só carrega o payload (rádio em Standby): a transmissão começa com uma
+// única escrita de RF95_MODE_TX em REG_OPMODE, no instante exato do slot
+void lora_load_tx(lora_dev_t *dev, const uint8_t *payload, uint8_t len);
+
+// Inicia uma detecção de atividade no canal (CAD) sem bloquear.
+// DIO0 -> CadDone e DIO1 -> CadDetected até lora_cad_finish().
+void lora_start_cad(lora_dev_t *dev);
+
+// Conclui a CAD depois do CadDone: limpa as flags, restaura o mapeamento dos
+// DIOs e retorna true se um preâmbulo foi detectado
+bool lora_cad_finish(lora_dev_t *dev);
+
+// Recepção única após uma CAD positiva; volta sozinho para Standby se nenhum
+// preâmbulo aparecer em symb_timeout símbolos (flag RxTimeout)
+void lora_start_rx_single(lora_dev_t *dev, uint16_t symb_timeout);
+
+// Coloca o rádio em Sleep (a configuração LoRa é mantida)
+void lora_sleep(lora_dev_t *dev);
+
+// Potência de TX no PA_BOOST, limitada a LORA_TX_POWER_MIN..LORA_TX_POWER_MAX
+// dBm (acima de 17 dBm com o PA_DAC de 20 dBm). Vale para os dois modems.
+#define LORA_TX_POWER_MIN   2
+#define LORA_TX_POWER_MAX   20
+void lora_set_tx_power(lora_dev_t *dev, int8_t dbm);
+
+// Transmite um pacote e aguarda a flag TxDone
+void lora_send_packet(lora_dev_t *dev, const uint8_t *payload, uint8_t len);
+
+#define LORA_BW_HZ      125000  // Largura de banda configurada (para o erro de frequência)
+
+// Lê um pacote recebido; retorna 0 se não houver pacote válido.
+// meta (opcional) é preenchido também para quadros com erro de CRC.
+int lora_receive_packet(lora_dev_t *dev, uint8_t *buffer, int max_len, lora_rx_meta_t *meta);
+
+// Modo rápido: SF6 com header implícito para quadros curtos de tamanho fixo
+// frame_len (o receptor não tem outro meio de saber o tamanho). O SF6 exige
+// REG_DETECT_OPT = 0x05 e REG_DETECTION_THRESHOLD = 0x0C, trocados junto com o
+// SF. Transmissor e receptor precisam estar no mesmo modo. Deixa o rádio em
+// Standby; fast = false volta ao perfil padrão (SF7, header explícito).
+void lora_set_fast_mode(lora_dev_t *dev, bool fast, uint8_t frame_len);
+bool lora_fast_mode(const lora_dev_t *dev);
+
+// Troca de modem sem reset: lora = false passa para FSK/OOK (o perfil fica a
+// cargo de fsk.c), lora = true volta ao LoRa com o perfil padrão (modo rápido
+// desligado) e o mapeamento dos DIOs de antes. O bit LongRangeMode só muda em
+// Sleep, então o conteúdo da FIFO se perde. Deixa o rádio em Standby; false
+// se o rádio não confirmar o modo.
+bool lora_set_long_range(lora_dev_t *dev, bool lora);
+
+// Filtro antecipado da recepção: após o RxDone só os primeiros head_len bytes
+// saem da FIFO; se o filtro recusar, o resto do quadro (e o RSSI/SNR) não é
+// lido e lora_receive_packet retorna 0 com meta->filtered. NULL desliga.
+void lora_set_rx_filter(lora_dev_t *dev, lora_rx_filter_t filter, uint8_t head_len, void *ctx);
+
+#endif // SX1276_H
@@ -0,0 +1,205 @@
+#include <string.h>
+#include "tdma.h"
+#include "arq.h"
+#include "downlink.h"
+
+uint32_t tdma_slot_us(const lora_modem_cfg_t *modem) {
+    // A janela de RX da estação cresce com o downlink (comando junto com o ACK)
+    return lora_airtime_us(modem, ARQ_HEADER_LEN + TDMA_MAX_PAYLOAD) + arq_ack_slot_us(modem) +
+           downlink_window_extra_us(modem) + TDMA_GUARD_US;
+}
+
+uint32_t tdma_cycle_us(const tdma_map_t *map) {
+    return map->first_slot_us + map->num_slots * map->slot_us;
+}
+
+// --- Receptor ---
+
+void tdma_gw_init(tdma_gw_t *g, const lora_modem_cfg_t *modem) {
+    memset(g, 0, sizeof(*g));
+    g->modem = *modem;
+    g->map.num_slots = TDMA_MIN_SLOTS;
+    g->map.slot_us = tdma_slot_us(modem);
+}
+
+uint8_t tdma_gw_members(const tdma_gw_t *g) {
+    uint8_t n = 0;
+    for (int i = 0; i < TDMA_MAX_SLOTS; i++) {
+        if (g->map.owner[i] != TDMA_SLOT_FREE) {
+            n++;
+        }
+    }
+    return n;
+}
+
+size_t tdma_gw_build_beacon(tdma_gw_t *g, uint8_t *out) {
+    tdma_map_t *m = &g->map;
+    m->cycle++;
+
+    // Libera os slots de estações que sumiram e acha o último ocupado
+    int last = -1;
+    for (int i = 0; i < TDMA_MAX_SLOTS; i++) {
+        if (m->owner[i] == TDMA_SLOT_FREE) {
+            continue;
+        }
+        if ((uint16_t)(m->cycle - g->last_heard[i]) > TDMA_RELEASE_CYCLES) {
+            m->owner[i] = TDMA_SLOT_FREE;
+            g->released++;
+        } else {
+            last = i;
+        }
+    }
+
+    // Slots para todas as reservas e ainda TDMA_MIN_FREE_SLOTS livres, mais
+    // TDMA_JOIN_FREE_SLOTS por reserva do último ciclo: enquanto há recém-
+    // -chegadas entrando, outras provavelmente disputam os slots livres
+    int needed = tdma_gw_members(g) + TDMA_MIN_FREE_SLOTS + TDMA_JOIN_FREE_SLOTS * g->joins;
+    g->joins = 0;
+    if (needed < last + 1) {
+        needed = last + 1;
+    }
+    needed = (needed + TDMA_MIN_SLOTS - 1) / TDMA_MIN_SLOTS * TDMA_MIN_SLOTS;
+    m->num_slots = (uint8_t)(needed > TDMA_MAX_SLOTS ? TDMA_MAX_SLOTS : needed);
+
+    size_t len = TDMA_BEACON_HEADER_LEN + m->num_slots;
+    m->first_slot_us = lora_airtime_us(&g->modem, (uint8_t)(ARQ_HEADER_LEN + len)) + TDMA_GUARD_US;
+
+    out[0] = (uint8_t)m->cycle;
+    out[1] = (uint8_t)(m->cycle >> 8);
+    out[2] = m->num_slots;
+    for (int i = 0; i < 4; i++) {
+        out[3 + i] = (uint8_t)(m->slot_us >> (8 * i));
+        out[7 + i] = (uint8_t)(m->first_slot_us >> (8 * i));
+    }
+    memcpy(out + TDMA_BEACON_HEADER_LEN, m->owner, m->num_slots);
+    return len;
+}
+
+void tdma_gw_on_frame(tdma_gw_t *g, uint8_t src) {
+    tdma_map_t *m = &g->map;
+    int free_slot = -1;
+    for (int i = 0; i < TDMA_MAX_SLOTS; i++) {
+        if (m->owner[i] == src) {
+            g->last_heard[i] = m->cycle;
+            return;
+        }
+        if (m->owner[i] == TDMA_SLOT_FREE && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    // Recém-chegada: o slot mais baixo livre entra no próximo beacon
+    if (src == TDMA_SLOT_FREE || free_slot < 0 || tdma_gw_members(g) >= TDMA_MAX_SLOTS - TDMA_MIN_FREE_SLOTS) {
+        g->full++;
+        return;
+    }
+    m->owner[free_slot] = src;
+    g->last_heard[free_slot] = m->cycle;
+    g->assigned++;
+    g->joins++;
+}
+
+// --- Estação ---
+
+void tdma_node_init(tdma_node_t *n, uint8_t addr) {
+    memset(n, 0, sizeof(*n));
+    n->addr = addr;
+    n->own_slot = TDMA_NO_SLOT;
+}
+
+bool tdma_node_on_beacon(tdma_node_t *n, const uint8_t *payload, size_t len, uint32_t start_us) {
+    if (len < TDMA_BEACON_HEADER_LEN) {
+        return false;
+    }
+    uint8_t num_slots = payload[2];
+    uint32_t slot_us = 0, first_slot_us = 0;
+    for (int i = 0; i < 4; i++) {
+        slot_us |= (uint32_t)payload[3 + i] << (8 * i);
+        first_slot_us |= (uint32_t)payload[7 + i] << (8 * i);
+    }
+    if (num_slots == 0 || num_slots > TDMA_MAX_SLOTS || len < (size_t)(TDMA_BEACON_HEADER_LEN + num_slots) ||
+        slot_us == 0) {
+        return false;
+    }
+
+    tdma_map_t *m = &n->map;
+    m->cycle = (uint16_t)(payload[0] | (payload[1] << 8));
+    m->num_slots = num_slots;
+    m->slot_us = slot_us;
+    m->first_slot_us = first_slot_us;
+    memcpy(m->owner, payload + TDMA_BEACON_HEADER_LEN, num_slots);
+
+    // Uma varredura por beacon: o sorteio do slot livre não percorre o mapa
+    n->own_slot = TDMA_NO_SLOT;
+    n->num_free = 0;
+    for (uint8_t i = 0; i < num_slots; i++) {
+        if (m->owner[i] == n->addr) {
+            n->own_slot = i;
+        } else if (m->owner[i] == TDMA_SLOT_FREE) {
+            n->free_slot[n->num_free++] = i;
+        }
+    }
+    if (n->own_slot != TDMA_NO_SLOT) {
+        n->join_backoff = 0;
+    } else if (n->joining && n->join_backoff < TDMA_JOIN_MAX_BACKOFF) {
+        // A tentativa do ciclo anterior não rendeu reserva
+        n->join_backoff++;
+    }
+    n->joining = false;
+    n->beacon_us = start_us;
+    n->synced = true;
+    n->beacons++;
+    return true;
+}
+
+// Slot da estação num ciclo: o reservado ou um livre sorteado pelo endereço
+// e pelo ciclo (duas recém-chegadas não colidem em todos os ciclos). Com
+// recuo, o sorteio é entre num_free << join_backoff posições e só as
+// primeiras num_free são slots neste ciclo.
+static uint8_t node_slot(const tdma_node_t *n, uint16_t cycle) {
+    if (n->own_slot != TDMA_NO_SLOT) {
+        return n->own_slot;
+    }
+    uint32_t num_free = n->num_free;
+    if (num_free == 0) {
+        return TDMA_NO_SLOT;
+    }
+    uint32_t h = n->addr * 0x9E3779B1u ^ cycle * 0x85EBCA6Bu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    uint32_t pick = h % (num_free << n->join_backoff);
+    return pick < num_free ? n->free_slot[pick] : TDMA_NO_SLOT;
+}
+
+bool tdma_node_next_slot(tdma_node_t *n, uint32_t now_us, uint32_t lead_us, uint32_t *slot_start_us) {
+    if (!n->synced) {
+        return false;
+    }
+    uint32_t cycle_us = tdma_cycle_us(&n->map);
+    // Com muitos slots o ciclo passa de 50 s: o prazo sem beacon para também
+    // pela deriva dos cristais, não só pelo número de ciclos
+    uint32_t sync_us = cycle_us < TDMA_SYNC_MAX_US / TDMA_SYNC_CYCLES ? TDMA_SYNC_CYCLES * cycle_us : TDMA_SYNC_MAX_US;
+    if (now_us - n->beacon_us > sync_us) {
+        // Sem beacon há muito tempo: o relógio pode ter derivado além da guarda
+        n->synced = false;
+        n->lost_sync++;
+        return false;
+    }
+    // Ciclos seguintes ao último beacon usam o mesmo mapa
+    for (uint16_t k = 0; k < TDMA_SYNC_CYCLES; k++) {
+        uint8_t slot = node_slot(n, (uint16_t)(n->map.cycle + k));
+        if (slot == TDMA_NO_SLOT) {
+            continue;
+        }
+        uint32_t start = n->beacon_us + k * cycle_us + n->map.first_slot_us + slot * n->map.slot_us;
+        if (start - n->beacon_us > sync_us) {
+            break;
+        }
+        if ((int32_t)(start - now_us) >= (int32_t)lead_us) {
+            *slot_start_us = start;
+            n->joining = n->own_slot == TDMA_NO_SLOT;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+#ifndef TDMA_H
+#define TDMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "airtime.h"
+
+// MAC TDMA sincronizado por beacon. O receptor transmite um beacon no início
+// de cada ciclo; depois dele vêm slots de duração fixa, calculada pelo tempo no
+// ar do maior quadro (TDMA_MAX_PAYLOAD), a janela de ACK do ARQ e uma guarda.
+// O beacon traz o mapa de slots (o endereço do dono de cada um; 0 = livre).
+// A estação com slot no mapa transmite só nele; a que ainda não tem (recém-
+// -chegada) usa um slot livre escolhido por hash do endereço e do ciclo, e o
+// receptor reserva um slot para ela no beacon seguinte; cada tentativa sem
+// reserva dobra o número de ciclos sobre o qual ela espalha as seguintes
+// (recuo exponencial). O número de slots cresce com as estações ativas, e o
+// ciclo com ele, até o maior mapa que cabe num quadro: 230 estações com slot,
+// quase todo o espaço de endereços de 8 bits. Além disso as excedentes seguem
+// nos slots livres, como recém-chegadas.
+// Sem dependência do SDK: o mesmo código roda no RP2040 e no simulador de
+// rede (sim/netsim.c).
+
+#define TDMA_ENABLED            0       // 1: estação e rx.c usam os slots (0: ALOHA com LBT)
+#define TDMA_MAX_SLOTS          232     // Beacon cabe em LINK_MAX_PAYLOAD (249); múltiplo de TDMA_MIN_SLOTS
+#define TDMA_MIN_SLOTS          8       // O número de slots anda em múltiplos deste
+#define TDMA_MIN_FREE_SLOTS     2       // Slots livres mantidos para as recém-chegadas
+#define TDMA_MAX_PAYLOAD        64      // Maior payload (após o cabeçalho de enlace) que cabe num slot
+#define TDMA_GUARD_US           4000    // Deriva dos cristais e latência da leitura do beacon
+#define TDMA_RELEASE_CYCLES     64      // Ciclos sem ouvir a estação até liberar o slot dela
+#define TDMA_SYNC_CYCLES        4       // Ciclos sem beacon até a estação perder o sincronismo
+#define TDMA_SYNC_MAX_US        100000000   // Teto desse prazo: ±20 ppm em 100 s somam a guarda
+#define TDMA_JOIN_MAX_BACKOFF   5       // Recuo máximo da recém-chegada: 2^5 ciclos
+#define TDMA_JOIN_FREE_SLOTS    2       // Slots livres a mais por reserva feita no último ciclo
+#define TDMA_SLOT_FREE          0x00    // LINK_ADDR_GATEWAY nunca é dono de slot
+#define TDMA_NO_SLOT            0xFF
+
+// Beacon: [ciclo LE16][slots][duração do slot LE32][início do slot 0 LE32][dono de cada slot]
+#define TDMA_BEACON_HEADER_LEN  11
+#define TDMA_BEACON_MAX_LEN     (TDMA_BEACON_HEADER_LEN + TDMA_MAX_SLOTS)
+
+typedef struct {
+    uint16_t cycle;
+    uint8_t num_slots;
+    uint32_t slot_us;
+    uint32_t first_slot_us;     // Do início do beacon ao início do slot 0
+    uint8_t owner[TDMA_MAX_SLOTS];
+} tdma_map_t;
+
+typedef struct {
+    lora_modem_cfg_t modem;
+    tdma_map_t map;
+    uint16_t last_heard[TDMA_MAX_SLOTS];    // Ciclo em que o dono foi ouvido
+    uint8_t joins;              // Reservas feitas no ciclo em curso
+    uint32_t assigned;
+    uint32_t released;
+    uint32_t full;              // Quadros de estações sem slot por falta de espaço
+} tdma_gw_t;
+
+typedef struct {
+    uint8_t addr;
+    bool synced;
+    tdma_map_t map;             // Do último beacon recebido
+    uint32_t beacon_us;         // Início do último beacon (relógio local)
+    uint8_t own_slot;           // TDMA_NO_SLOT enquanto não houver reserva
+    uint8_t num_free;           // Slots livres do mapa, listados em free_slot
+    uint8_t free_slot[TDMA_MAX_SLOTS];
+    uint8_t join_backoff;       // Tentativas sem reserva (expoente do recuo)
+    bool joining;               // Usou um slot livre desde o último beacon
+    uint32_t beacons;
+    uint32_t lost_sync;
+} tdma_node_t;
+
+// Duração de um slot: maior quadro + janela de ACK (com o downlink) + guarda
+uint32_t tdma_slot_us(const lora_modem_cfg_t *modem);
+
+// Duração do ciclo descrito pelo mapa (beacon + slots)
+uint32_t tdma_cycle_us(const tdma_map_t *map);
+
+void tdma_gw_init(tdma_gw_t *g, const lora_modem_cfg_t *modem);
+
+// Monta o beacon do próximo ciclo em out (até TDMA_BEACON_MAX_LEN bytes):
+// libera slots ociosos e ajusta o número de slots. Retorna o tamanho.
+size_t tdma_gw_build_beacon(tdma_gw_t *g, uint8_t *out);
+
+// Quadro válido de src: renova o slot dela ou reserva um livre
+void tdma_gw_on_frame(tdma_gw_t *g, uint8_t src);
+
+// Estações com slot reservado
+uint8_t tdma_gw_members(const tdma_gw_t *g);
+
+void tdma_node_init(tdma_node_t *n, uint8_t addr);
+
+// Processa o payload de um beacon cujo início foi em start_us (relógio local,
+// estimado pelo fim da recepção menos o tempo no ar). false se inválido.
+bool tdma_node_on_beacon(tdma_node_t *n, const uint8_t *payload, size_t len, uint32_t start_us);
+
+// Início do próximo slot da estação com pelo menos lead_us de antecedência
+// em relação a now_us. false sem sincronismo (nenhum beacon recente).
+bool tdma_node_next_slot(tdma_node_t *n, uint32_t now_us, uint32_t lead_us, uint32_t *slot_start_us);
+
+#endif // TDMA_H
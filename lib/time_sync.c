@@ -0,0 +1,113 @@
+#include <string.h>
+#include "time_sync.h"
+
+size_t time_sync_build(uint64_t tx_start_us, uint8_t *out) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(tx_start_us >> (8 * i));
+    }
+    return TIME_SYNC_PAYLOAD_LEN;
+}
+
+void time_sync_init(time_sync_t *ts) {
+    memset(ts, 0, sizeof(*ts));
+}
+
+// Correção da deriva acumulada em dt_us
+static int64_t drift_us(int32_t drift_ppb, int64_t dt_us) {
+    return dt_us * drift_ppb / 1000000000;
+}
+
+static void anchor(time_sync_t *ts, uint32_t local_us, uint64_t net_us) {
+    ts->ref_local_us = local_us;
+    ts->ref_net_us = net_us;
+    ts->synced = true;
+}
+
+bool time_sync_on_frame(time_sync_t *ts, const uint8_t *payload, size_t len, uint32_t start_us) {
+    if (len < TIME_SYNC_PAYLOAD_LEN) {
+        return false;
+    }
+    uint64_t net_us = 0;
+    for (int i = 0; i < 8; i++) {
+        net_us |= (uint64_t)payload[i] << (8 * i);
+    }
+    start_us -= TIME_SYNC_RX_DELAY_US;
+
+    if (!ts->synced) {
+        // Primeiro quadro: só o offset; a deriva sai do intervalo até o próximo
+        anchor(ts, start_us, net_us);
+        ts->drift_ppb = 0;
+        ts->drift_valid = false;
+        ts->max_error_us = 0;
+        ts->samples++;
+        return true;
+    }
+
+    int32_t dt = (int32_t)(start_us - ts->ref_local_us);
+    if (dt <= 0) {
+        ts->outliers++;
+        return false;
+    }
+    if ((uint32_t)dt > TIME_SYNC_MAX_AGE_US) {
+        // Intervalo longo demais para medir a deriva: só reancora o offset
+        anchor(ts, start_us, net_us);
+        ts->samples++;
+        return true;
+    }
+
+    int64_t error = (int64_t)(net_us - ts->ref_net_us) - dt - drift_us(ts->drift_ppb, dt);
+    int64_t limit = TIME_SYNC_MAX_ERROR_US + (int64_t)dt * TIME_SYNC_MAX_PPM / 1000000;
+    if (error > limit || error < -limit) {
+        // Quadro atrasado (ISR bloqueada, leitura fora de ordem) ou salto do
+        // relógio do receptor: descarta, e recomeça se persistir
+        ts->outliers++;
+        if (++ts->outlier_run >= TIME_SYNC_MAX_OUTLIERS) {
+            ts->outlier_run = 0;
+            ts->resets++;
+            ts->synced = false;
+            return time_sync_on_frame(ts, payload, len, start_us + TIME_SYNC_RX_DELAY_US);
+        }
+        return false;
+    }
+    ts->outlier_run = 0;
+    ts->last_error_us = (int32_t)error;
+    uint32_t abs_error = (uint32_t)(error < 0 ? -error : error);
+    if (abs_error > ts->max_error_us) {
+        ts->max_error_us = abs_error;
+    }
+
+    // O erro residual dividido pelo intervalo é o erro da deriva estimada.
+    // A primeira medida entra inteira; as seguintes são filtradas contra o
+    // jitter dos carimbos.
+    int32_t correction_ppb = (int32_t)(error * 1000000000 / dt);
+    ts->drift_ppb += ts->drift_valid ? correction_ppb / TIME_SYNC_DRIFT_GAIN : correction_ppb;
+    ts->drift_valid = true;
+    anchor(ts, start_us, net_us);
+    ts->samples++;
+    return true;
+}
+
+bool time_sync_to_net(const time_sync_t *ts, uint32_t local_us, uint64_t *net_us) {
+    if (!ts->synced) {
+        return false;
+    }
+    int32_t dt = (int32_t)(local_us - ts->ref_local_us);
+    if (dt > (int32_t)TIME_SYNC_MAX_AGE_US || dt < -(int32_t)TIME_SYNC_MAX_AGE_US) {
+        return false;
+    }
+    *net_us = ts->ref_net_us + (uint64_t)((int64_t)dt + drift_us(ts->drift_ppb, dt));
+    return true;
+}
+
+bool time_sync_to_local(const time_sync_t *ts, uint64_t net_us, uint32_t *local_us) {
+    if (!ts->synced) {
+        return false;
+    }
+    int64_t dn = (int64_t)(net_us - ts->ref_net_us);
+    if (dn > TIME_SYNC_MAX_AGE_US || dn < -(int64_t)TIME_SYNC_MAX_AGE_US) {
+        return false;
+    }
+    // dn / (1 + deriva), em primeira ordem: a deriva é de dezenas de ppm
+    *local_us = ts->ref_local_us + (uint32_t)(dn - drift_us(ts->drift_ppb, dn));
+    return true;
+}
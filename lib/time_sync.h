@@ -0,0 +1,58 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Tempo de rede: o relógio do receptor (time_us_64 do rx.c) é a referência.
+// O receptor transmite periodicamente um quadro com o instante exato do início
+// do próprio TX (TX temporizado: a FIFO é carregada antes e o OPMODE é escrito
+// no instante marcado). A estação carimba o RxDone no ISR do DIO0, desconta o
+// tempo no ar e obtém o mesmo instante no seu relógio: a diferença é o offset.
+// Entre quadros a deriva do cristal é corrigida pela taxa estimada (ppb).
+// Sem dependência do SDK: instantes locais em uint32 (time_us_32), seguros na
+// virada do contador para intervalos de até ~35 min.
+
+#define TIME_SYNC_ENABLED       0       // 1: rx.c transmite o tempo e a estação fica em escuta
+#define TIME_SYNC_PERIOD_MS     30000   // Intervalo entre quadros de tempo do receptor
+#define TIME_SYNC_PAYLOAD_LEN   8       // Instante do início do TX (LE64, us do receptor)
+#define TIME_SYNC_TX_LEAD_US    2000    // Carga da FIFO antes do instante marcado no quadro
+#define TIME_SYNC_RX_DELAY_US   0       // Fim do último símbolo -> borda do RxDone (calibração)
+#define TIME_SYNC_MAX_ERROR_US  5000    // Erro tolerado além da deriva máxima no intervalo
+#define TIME_SYNC_MAX_PPM       100     // Deriva relativa máxima entre dois cristais
+#define TIME_SYNC_MAX_OUTLIERS  3       // Quadros descartados seguidos até recomeçar do zero
+#define TIME_SYNC_DRIFT_GAIN    4       // Filtro da deriva: 1/N de cada nova medida
+#define TIME_SYNC_MAX_AGE_US    (20u * 60u * 1000000u)  // Sem quadro há mais que isso: sem sincronismo
+
+typedef struct {
+    bool synced;
+    uint32_t ref_local_us;      // Início do último quadro aceito (relógio local)
+    uint64_t ref_net_us;        // O mesmo instante no tempo de rede
+    int32_t drift_ppb;          // Rede - local, em partes por bilhão
+    bool drift_valid;           // Deriva já medida em pelo menos um intervalo
+    int32_t last_error_us;      // Tempo do quadro - tempo previsto (antes da correção)
+    uint32_t max_error_us;      // Maior |erro| desde a sincronização
+    uint32_t samples;           // Quadros aceitos
+    uint32_t outliers;          // Quadros descartados por erro excessivo
+    uint32_t resets;            // Reinícios após TIME_SYNC_MAX_OUTLIERS descartes
+    uint8_t outlier_run;
+} time_sync_t;
+
+// Receptor: payload do quadro com o instante de início do TX
+size_t time_sync_build(uint64_t tx_start_us, uint8_t *out);
+
+void time_sync_init(time_sync_t *ts);
+
+// Estação: processa um quadro de tempo cujo início foi em start_us (relógio
+// local: carimbo do RxDone no ISR menos o tempo no ar). false se descartado.
+bool time_sync_on_frame(time_sync_t *ts, const uint8_t *payload, size_t len, uint32_t start_us);
+
+// Converte um instante local em tempo de rede; false sem sincronismo recente
+bool time_sync_to_net(const time_sync_t *ts, uint32_t local_us, uint64_t *net_us);
+
+// Converte um instante de rede no relógio local (ex.: acesso por slot
+// marcado pela rede); false sem sincronismo ou fora do alcance do uint32
+bool time_sync_to_local(const time_sync_t *ts, uint64_t net_us, uint32_t *local_us);
+
+#endif // TIME_SYNC_H
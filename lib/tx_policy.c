@@ -0,0 +1,121 @@
+#include <math.h>
+#include <string.h>
+#include "tx_policy.h"
+
+void tx_policy_init(tx_policy_t *p, uint32_t heartbeat_ms) {
+    memset(p, 0, sizeof(*p));
+    p->heartbeat_ms = heartbeat_ms;
+}
+
+int tx_policy_add_channel(tx_policy_t *p, float min, float max, float hysteresis, float deadband) {
+    if (p->num_channels >= TX_POLICY_MAX_CHANNELS) {
+        return -1;
+    }
+
+    tx_policy_channel_t *c = &p->ch[p->num_channels];
+    c->min = min;
+    c->max = max;
+    c->hysteresis = hysteresis;
+    c->deadband = deadband;
+    c->level = TX_LEVEL_NORMAL;
+    c->sent_level = TX_LEVEL_NORMAL;
+    c->last_sent = 0;
+
+    return p->num_channels++;
+}
+
+void tx_policy_set_limits(tx_policy_t *p, int ch, float min, float max) {
+    if (ch < 0 || ch >= p->num_channels) {
+        return;
+    }
+    p->ch[ch].min = min;
+    p->ch[ch].max = max;
+}
+
+// Calcula o novo estado do canal aplicando a histerese apenas na saída do alarme
+static tx_level_t next_level(const tx_policy_channel_t *c, float v) {
+    if (v > c->max) {
+        return TX_LEVEL_HIGH;
+    }
+    if (v < c->min) {
+        return TX_LEVEL_LOW;
+    }
+
+    // Dentro dos limites: só volta ao normal após atravessar a histerese
+    if (c->level == TX_LEVEL_HIGH && v > c->max - c->hysteresis) {
+        return TX_LEVEL_HIGH;
+    }
+    if (c->level == TX_LEVEL_LOW && v < c->min + c->hysteresis) {
+        return TX_LEVEL_LOW;
+    }
+    return TX_LEVEL_NORMAL;
+}
+
+void tx_policy_set_heartbeat(tx_policy_t *p, uint32_t heartbeat_ms) {
+    p->heartbeat_ms = heartbeat_ms;
+}
+
+uint8_t tx_policy_evaluate(tx_policy_t *p, const float *values, uint32_t now_ms) {
+    uint8_t reasons = TX_REASON_NONE;
+
+    p->evaluations++;
+
+    for (int i = 0; i < p->num_channels; i++) {
+        tx_policy_channel_t *c = &p->ch[i];
+        float v = values[i];
+
+        if (isnan(v)) {
+            continue; // Leitura inválida não dispara transmissão
+        }
+
+        // O estado acompanha a leitura; o motivo fica até o envio do estado
+        c->level = next_level(c, v);
+        if (c->level != c->sent_level) {
+            reasons |= TX_REASON_ALARM;
+        }
+
+        if (p->has_tx && fabsf(v - c->last_sent) >= c->deadband) {
+            reasons |= TX_REASON_DEADBAND;
+        }
+    }
+
+    if (!p->has_tx) {
+        reasons |= TX_REASON_FIRST;
+    } else if ((uint32_t)(now_ms - p->last_tx_ms) >= p->heartbeat_ms) {
+        reasons |= TX_REASON_HEARTBEAT;
+    }
+
+    return reasons;
+}
+
+void tx_policy_mark_sent(tx_policy_t *p, const float *values, uint8_t reasons, uint32_t now_ms) {
+    for (int i = 0; i < p->num_channels; i++) {
+        if (!isnan(values[i])) {
+            p->ch[i].last_sent = values[i];
+        }
+        p->ch[i].sent_level = p->ch[i].level;
+    }
+
+    p->last_tx_ms = now_ms;
+    p->has_tx = true;
+    p->tx_count++;
+
+    if (reasons & TX_REASON_ALARM) {
+        p->alarm_count++;
+    }
+    if (reasons & TX_REASON_DEADBAND) {
+        p->deadband_count++;
+    }
+    if (reasons & TX_REASON_HEARTBEAT) {
+        p->heartbeat_count++;
+    }
+}
+
+bool tx_policy_in_alarm(const tx_policy_t *p) {
+    for (int i = 0; i < p->num_channels; i++) {
+        if (p->ch[i].level != TX_LEVEL_NORMAL) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef TX_POLICY_H
+#define TX_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Política de transmissão por exceção: só transmite quando um limite é
+// cruzado, quando um valor varia mais que a banda morta do canal ou quando
+// o intervalo de heartbeat expira.
+
+#define TX_POLICY_MAX_CHANNELS  4
+
+// Motivos de transmissão (máscara de bits retornada por tx_policy_evaluate)
+#define TX_REASON_NONE          0x00
+#define TX_REASON_FIRST         0x01    // Nenhum envio feito ainda
+#define TX_REASON_ALARM         0x02    // Mudança de estado de alarme (entrada ou saída)
+#define TX_REASON_DEADBAND      0x04    // Variação maior que a banda morta
+#define TX_REASON_HEARTBEAT     0x08    // Intervalo máximo sem transmitir
+
+typedef enum {
+    TX_LEVEL_NORMAL = 0,
+    TX_LEVEL_LOW,
+    TX_LEVEL_HIGH
+} tx_level_t;
+
+typedef struct {
+    float min;          // Limite inferior (-INFINITY desabilita)
+    float max;          // Limite superior (INFINITY desabilita)
+    float hysteresis;   // Margem para sair do estado de alarme
+    float deadband;     // Variação mínima em relação ao último valor enviado
+    tx_level_t level;   // Estado atual do canal
+    tx_level_t sent_level; // Último estado transmitido (difere de level: alarme pendente)
+    float last_sent;    // Último valor transmitido
+} tx_policy_channel_t;
+
+typedef struct {
+    tx_policy_channel_t ch[TX_POLICY_MAX_CHANNELS];
+    uint8_t num_channels;
+    uint32_t heartbeat_ms;
+    uint32_t last_tx_ms;
+    bool has_tx;
+    uint32_t evaluations;       // Número de avaliações
+    uint32_t tx_count;          // Número de transmissões efetivas
+    uint32_t alarm_count;       // Transmissões motivadas por alarme
+    uint32_t deadband_count;    // Transmissões motivadas pela banda morta
+    uint32_t heartbeat_count;   // Transmissões motivadas pelo heartbeat
+} tx_policy_t;
+
+void tx_policy_init(tx_policy_t *p, uint32_t heartbeat_ms);
+
+// Adiciona um canal e retorna seu índice (ou -1 se não houver espaço)
+int tx_policy_add_channel(tx_policy_t *p, float min, float max, float hysteresis, float deadband);
+
+// Atualiza os limites de um canal (ex.: após mudança em ConfigData)
+void tx_policy_set_limits(tx_policy_t *p, int ch, float min, float max);
+
+// Troca o intervalo máximo sem transmitir (vale a partir da próxima avaliação)
+void tx_policy_set_heartbeat(tx_policy_t *p, uint32_t heartbeat_ms);
+
+// Avalia os valores atuais e retorna a máscara de motivos (0 = não transmitir).
+// Uma transição de alarme segue pedindo TX_REASON_ALARM até tx_policy_mark_sent:
+// se o quadro não sair (rádio parado, janela do ARQ cheia) ela não se perde.
+uint8_t tx_policy_evaluate(tx_policy_t *p, const float *values, uint32_t now_ms);
+
+// Registra que os valores foram transmitidos (e os estados de alarme avaliados)
+void tx_policy_mark_sent(tx_policy_t *p, const float *values, uint8_t reasons, uint32_t now_ms);
+
+// Retorna true se algum canal está fora dos limites
+bool tx_policy_in_alarm(const tx_policy_t *p);
+
+#endif // TX_POLICY_H
@@ -1,107 +1,173 @@
-/* EMBARCATECH - INTRODUÇÃO AO PROTOCOLO LORA - CAPÍTULO 3 / PARTE 5
- * BitDogLAB - Transmissor LoRa (TX)
- * Biblioteca com endereços do registradores do SX1276 - Módulo LoRa.
- * Prof: Ricardo Prates
- */
-
-#ifndef LORA_INCLUDED
-#define LORA_INCLUDED
-
-// Registradores
-#define REG_FIFO                    0x00
-#define REG_OPMODE                  0x01            //IMPORTANTE
-#define REG_FIFO_ADDR_PTR           0x0D 
-#define REG_FIFO_TX_BASE_AD         0x0E
-#define REG_FIFO_RX_BASE_AD         0x0F
-#define REG_FIFO_RX_CURRENT_ADDR    0x10
-#define REG_IRQ_FLAGS_MASK          0x11
-#define REG_IRQ_FLAGS               0x12
-#define REG_RX_NB_BYTES             0x13            //IMPORTANTE
-#define REG_MODEM_CONFIG            0x1D            //IMPORTANTE
-#define REG_MODEM_CONFIG2           0x1E            //IMPORTANTE
-#define REG_MODEM_CONFIG3           0x26            //IMPORTANTE
-#define REG_PREAMBLE_MSB            0x20
-#define REG_PREAMBLE_LSB            0x21
-#define REG_PAYLOAD_LENGTH          0x22            //IMPORTANTE
-#define REG_HOP_PERIOD              0x24
-#define REG_FREQ_ERROR              0x28
-#define REG_DETECT_OPT              0x31            //IMPORTANTE
-#define	REG_DETECTION_THRESHOLD     0x37            //IMPORTANTE
-#define REG_DIO_MAPPING_1           0x40            //IMPORTANTE
-#define REG_DIO_MAPPING_2           0x41            //IMPORTANTE
-
-// FSK stuff
-#define REG_PREAMBLE_MSB_FSK        0x25
-#define REG_PREAMBLE_LSB_FSK        0x26
-#define REG_PACKET_CONFIG1          0x30
-#define REG_PAYLOAD_LENGTH_FSK      0x32
-#define REG_FIFO_THRESH             0x35
-#define REG_FDEV_MSB                0x04
-#define REG_FDEV_LSB                0x05
-#define REG_FRF_MSB                 0x06            //IMPORTANTE
-#define REG_FRF_MID                 0x07            //IMPORTANTE
-#define REG_FRF_LSB                 0x08            //IMPORTANTE
-#define REG_BITRATE_MSB             0x02
-#define REG_BITRATE_LSB             0x03
-#define REG_IRQ_FLAGS2              0x3F
-
-// MODOS DE OPERAÇÃO
-#define RF95_MODE_RX_CONTINUOUS     0x85
-#define RF95_MODE_TX                0x83
-#define RF95_MODE_SLEEP             0x80
-#define RF95_MODE_STANDBY           0x81
-
-#define PAYLOAD_LENGTH              255
-
-// CONFIGURAÇÃO DO PACOTE DE DADOS
-#define EXPLICIT_MODE               0x00
-#define IMPLICIT_MODE               0x01
-
-#define ERROR_CODING_4_5            0x02
-#define ERROR_CODING_4_6            0x04
-#define ERROR_CODING_4_7            0x06
-#define ERROR_CODING_4_8            0x08
-
-// CONFIGURAÇÃO DA LARGURA DE BANDA (BW)
-#define BANDWIDTH_7K8               0x00
-#define BANDWIDTH_10K4              0x10
-#define BANDWIDTH_15K6              0x20
-#define BANDWIDTH_20K8              0x30
-#define BANDWIDTH_31K25             0x40
-#define BANDWIDTH_41K7              0x50
-#define BANDWIDTH_62K5              0x60
-#define BANDWIDTH_125K              0x70
-#define BANDWIDTH_250K              0x80
-#define BANDWIDTH_500K              0x90
-
-// COFIGURAÇÃO DO SPREADING FACTOR (FS)
-#define SPREADING_6                 0x60
-#define SPREADING_7                 0x70
-#define SPREADING_8                 0x80
-#define SPREADING_9                 0x90
-#define SPREADING_10                0xA0
-#define SPREADING_11                0xB0
-#define SPREADING_12                0xC0
-
-#define CRC_OFF                     0x00
-#define CRC_ON                      0x04
-
-// POWER AMPLIFIER CONFIG
-#define REG_PA_CONFIG               0x09
-#define PA_MAX_BOOST                0x8F    // 100mW (max 869.4 - 869.65)
-#define PA_LOW_BOOST                0x81
-#define PA_MED_BOOST                0x8A
-#define PA_MAX_UK                   0x88    // 10mW (max 434)
-#define PA_OFF_BOOST                0x00
-#define RFO_MIN                     0x00
-
-// 20DBm
-#define REG_PA_DAC                  0x4D
-#define PA_DAC_20                   0x87
-
-// LOW NOISE AMPLIFIER
-#define REG_LNA                     0x0C
-#define LNA_MAX_GAIN                0x23  // 0010 0011
-#define LNA_OFF_GAIN                0x00
-
-#endif
\ No newline at end of file
+/* EMBARCATECH - INTRODUÇÃO AO PROTOCOLO LORA - CAPÍTULO 3 / PARTE 5
+ * BitDogLAB - Transmissor LoRa (TX)
+ * Biblioteca com endereços do registradores do SX1276 - Módulo LoRa.
+ * Prof: Ricardo Prates
+ */
+
+#ifndef LORA_INCLUDED
+#define LORA_INCLUDED
+
+// Registradores
+#define REG_FIFO                    0x00
+#define REG_OPMODE                  0x01            //IMPORTANTE
+#define REG_FIFO_ADDR_PTR           0x0D 
+#define REG_FIFO_TX_BASE_AD         0x0E
+#define REG_FIFO_RX_BASE_AD         0x0F
+#define REG_FIFO_RX_CURRENT_ADDR    0x10
+#define REG_IRQ_FLAGS_MASK          0x11
+#define REG_IRQ_FLAGS               0x12
+#define REG_RX_NB_BYTES             0x13            //IMPORTANTE
+#define REG_MODEM_STAT              0x18
+#define REG_PKT_SNR_VALUE           0x19
+#define REG_PKT_RSSI_VALUE          0x1A
+#define REG_RSSI_VALUE              0x1B
+#define REG_HOP_CHANNEL             0x1C
+#define REG_FIFO_RX_BYTE_ADDR       0x25
+#define REG_RSSI_WIDEBAND           0x2C
+#define REG_MODEM_CONFIG            0x1D            //IMPORTANTE
+#define REG_MODEM_CONFIG2           0x1E            //IMPORTANTE
+#define REG_MODEM_CONFIG3           0x26            //IMPORTANTE
+#define REG_SYMB_TIMEOUT_LSB        0x1F
+#define REG_PREAMBLE_MSB            0x20
+#define REG_PREAMBLE_LSB            0x21
+#define REG_PAYLOAD_LENGTH          0x22            //IMPORTANTE
+#define REG_HOP_PERIOD              0x24
+#define REG_FREQ_ERROR              0x28
+#define REG_DETECT_OPT              0x31            //IMPORTANTE
+#define	REG_DETECTION_THRESHOLD     0x37            //IMPORTANTE
+#define REG_DIO_MAPPING_1           0x40            //IMPORTANTE
+#define REG_DIO_MAPPING_2           0x41            //IMPORTANTE
+#define REG_VERSION                 0x42            // Deve ler 0x12 no SX1276
+
+// FSK stuff
+#define REG_PREAMBLE_MSB_FSK        0x25
+#define REG_PREAMBLE_LSB_FSK        0x26
+#define REG_PACKET_CONFIG1          0x30
+#define REG_PAYLOAD_LENGTH_FSK      0x32
+#define REG_FIFO_THRESH             0x35
+#define REG_FDEV_MSB                0x04
+#define REG_FDEV_LSB                0x05
+#define REG_FRF_MSB                 0x06            //IMPORTANTE
+#define REG_FRF_MID                 0x07            //IMPORTANTE
+#define REG_FRF_LSB                 0x08            //IMPORTANTE
+#define REG_BITRATE_MSB             0x02
+#define REG_BITRATE_LSB             0x03
+#define REG_TEMP_FSK                0x3C
+#define REG_IRQ_FLAGS1_FSK          0x3E
+#define REG_IRQ_FLAGS2              0x3F
+#define REG_PA_RAMP                 0x0A            // Bits 6-5: filtro gaussiano (GFSK)
+#define REG_RX_CONFIG_FSK           0x0D
+#define REG_RSSI_VALUE_FSK          0x11            // -RSSI/2 dBm
+#define REG_RX_BW_FSK               0x12
+#define REG_AFC_BW_FSK              0x13
+#define REG_PREAMBLE_DETECT_FSK     0x1F
+#define REG_SYNC_CONFIG_FSK         0x27
+#define REG_SYNC_VALUE1_FSK         0x28
+#define REG_PACKET_CONFIG2          0x31
+#define REG_BITRATE_FRAC            0x5D
+
+// MODOS DE OPERAÇÃO FSK (LongRangeMode = 0, banda alta)
+#define FSK_MODE_SLEEP              0x00
+#define FSK_MODE_STANDBY            0x01
+#define FSK_MODE_TX                 0x03
+#define FSK_MODE_RX                 0x05
+
+// FLAGS DE INTERRUPÇÃO FSK (REG_IRQ_FLAGS2)
+#define IRQ2_FIFO_FULL              0x80
+#define IRQ2_FIFO_EMPTY             0x40
+#define IRQ2_FIFO_LEVEL             0x20            // Bytes na FIFO > FifoThreshold
+#define IRQ2_FIFO_OVERRUN           0x10
+#define IRQ2_PACKET_SENT            0x08
+#define IRQ2_PAYLOAD_READY          0x04
+#define IRQ2_CRC_OK                 0x02
+
+// MODOS DE OPERAÇÃO
+#define RF95_MODE_RX_CONTINUOUS     0x85
+#define RF95_MODE_TX                0x83
+#define RF95_MODE_SLEEP             0x80
+#define RF95_MODE_STANDBY           0x81
+#define RF95_MODE_RX_SINGLE         0x86
+#define RF95_MODE_CAD               0x87
+
+#define PAYLOAD_LENGTH              255
+
+// FLAGS DE INTERRUPÇÃO (REG_IRQ_FLAGS)
+#define IRQ_RX_TIMEOUT              0x80
+#define IRQ_RX_DONE                 0x40
+#define IRQ_PAYLOAD_CRC_ERROR       0x20
+#define IRQ_VALID_HEADER            0x10
+#define IRQ_TX_DONE                 0x08
+#define IRQ_CAD_DONE                0x04
+#define IRQ_FHSS_CHANGE_CHANNEL     0x02
+#define IRQ_CAD_DETECTED            0x01
+
+// STATUS DO MODEM (REG_MODEM_STAT)
+#define MODEM_STAT_HEADER_VALID     0x08
+#define MODEM_STAT_RX_ONGOING       0x04
+#define MODEM_STAT_SYNCHRONIZED     0x02
+#define MODEM_STAT_SIGNAL_DETECTED  0x01
+
+// MAPEAMENTO DOS PINOS DIO (REG_DIO_MAPPING_1)
+#define DIO0_MASK                   0xC0
+#define DIO0_RX_DONE                0x00
+#define DIO0_TX_DONE                0x40
+#define DIO0_CAD_DONE               0x80
+#define DIO1_MASK                   0x30
+#define DIO1_RX_TIMEOUT             0x00
+#define DIO1_FHSS_CHANGE_CHANNEL    0x10
+#define DIO1_CAD_DETECTED           0x20
+
+// CONFIGURAÇÃO DO PACOTE DE DADOS
+#define EXPLICIT_MODE               0x00
+#define IMPLICIT_MODE               0x01
+
+#define ERROR_CODING_4_5            0x02
+#define ERROR_CODING_4_6            0x04
+#define ERROR_CODING_4_7            0x06
+#define ERROR_CODING_4_8            0x08
+
+// CONFIGURAÇÃO DA LARGURA DE BANDA (BW)
+#define BANDWIDTH_7K8               0x00
+#define BANDWIDTH_10K4              0x10
+#define BANDWIDTH_15K6              0x20
+#define BANDWIDTH_20K8              0x30
+#define BANDWIDTH_31K25             0x40
+#define BANDWIDTH_41K7              0x50
+#define BANDWIDTH_62K5              0x60
+#define BANDWIDTH_125K              0x70
+#define BANDWIDTH_250K              0x80
+#define BANDWIDTH_500K              0x90
+
+// COFIGURAÇÃO DO SPREADING FACTOR (FS)
+#define SPREADING_6                 0x60
+#define SPREADING_7                 0x70
+#define SPREADING_8                 0x80
+#define SPREADING_9                 0x90
+#define SPREADING_10                0xA0
+#define SPREADING_11                0xB0
+#define SPREADING_12                0xC0
+
+#define CRC_OFF                     0x00
+#define CRC_ON                      0x04
+
+// POWER AMPLIFIER CONFIG
+#define REG_PA_CONFIG               0x09
+#define PA_MAX_BOOST                0x8F    // 100mW (max 869.4 - 869.65)
+#define PA_LOW_BOOST                0x81
+#define PA_MED_BOOST                0x8A
+#define PA_MAX_UK                   0x88    // 10mW (max 434)
+#define PA_OFF_BOOST                0x00
+#define RFO_MIN                     0x00
+
+// 20DBm
+#define REG_PA_DAC                  0x4D
+#define PA_DAC_20                   0x87
+#define PA_DAC_DEFAULT              0x84    // Até 17 dBm no PA_BOOST
+#define PA_BOOST                    0x80    // Saída pelo PA_BOOST (OutputPower nos bits 3-0)
+
+// LOW NOISE AMPLIFIER
+#define REG_LNA                     0x0C
+#define LNA_MAX_GAIN                0x23  // 0010 0011
+#define LNA_OFF_GAIN                0x00
+
+#endif
@@ -1,165 +1,717 @@
 // lora_rx.c
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "pico/stdlib.h"
-#include "hardware/spi.h"
 #include "hardware/gpio.h"
-#include "lora.h" // Nosso cabeçalho com as definições
-
-// Definições dos Pinos
-#define SPI_PORT spi0
-#define PIN_MISO 16
-#define PIN_MOSI 19
-#define PIN_SCK  18
-#define PIN_CS   17
-#define PIN_RST  20
-#define PIN_DIO0 21
+#include "sx1276.h"     // Driver do SX1276 (registradores em lora.h)
+#include "event_loop.h"
+#include "boot_trace.h"
+#include "channel_plan.h"
+#include "link_frame.h"
+#include "link_stats.h"
+#include "afc.h"
+#include "arq.h"
+#include "frag.h"
+#include "fec.h"
+#include "tdma.h"
+#include "time_sync.h"
+#include "fast_frame.h"
+#include "fsk.h"
+#include "downlink.h"
+#include "downlink_key.h"    // Chave da rede, fora do git (downlink_key.h.example)
 
-// Frequência do LoRa (DEVE SER A MESMA DO TRANSMISSOR!)
-#define LORA_FREQUENCY 915E6
+#define USB_WAIT_MS     2000    // Espera máxima pela serial USB (segue ao conectar)
+#define STATS_PERIOD_MS 60000   // Intervalo entre relatórios de estatísticas
+#define RX_NODE_ID      LINK_ADDR_GATEWAY   // Endereço deste receptor
+#define ARQ_MAX_SOURCES 8       // Estações com estado de ARQ acompanhado
+#define CONSOLE_POLL_MS 100     // Leitura dos comandos de downlink digitados na serial
+#define CONSOLE_LINE_LEN 128
 
-// --- Funções de baixo nível para SPI (idênticas ao TX) ---
-void lora_write_reg(uint8_t reg, uint8_t val) {
-    uint8_t buf[2];
-    buf[0] = reg | 0x80;
-    buf[1] = val;
-    gpio_put(PIN_CS, 0);
-    spi_write_blocking(SPI_PORT, buf, 2);
-    gpio_put(PIN_CS, 1);
+// 1: escuta o modo rápido (SF6, header implícito) e só recebe quadros fixos
+// (fast_frame.h), como os alarmes da estação com ALARM_FAST_FRAME
+#define RX_FAST_MODE    0
+
+// 1: nó de serviço em FSK (fsk.h), recebe os despejos da estação com
+// BULK_FSK. Só recepção: sem ACK, TDMA, tempo de rede nem amostragem.
+#define RX_FSK_MODE     0
+
+#if RX_FSK_MODE && (TDMA_ENABLED || TIME_SYNC_ENABLED || LORA_SNIFF_PERIOD_US > 0)
+#error "RX_FSK_MODE não combina com TDMA, tempo de rede nem amostragem de preâmbulo"
+#endif
+
+// Amostragem de preâmbulo (LORA_SNIFF_PERIOD_US em sx1276.h): o rádio dorme,
+// acorda para uma CAD a cada período e só entra em RX quando há preâmbulo
+#define SNIFF_RX_TIMEOUT_SYMB   (LORA_PREAMBLE_LEN + 4)
+
+#define TIMER_STATS     0       // Argumento de EVT_TIMER
+#define TIMER_SNIFF     1
+#define TIMER_BEACON    2
+#define TIMER_TIME      3
+#define TIMER_CONSOLE   4
+
+typedef enum {
+    SNIFF_OFF = 0,      // Recepção contínua
+    SNIFF_SLEEP,        // Rádio em Sleep até o próximo período
+    SNIFF_CAD,          // Procurando preâmbulo
+    SNIFF_RX            // Preâmbulo detectado: recepção única em andamento
+} sniff_state_t;
+
+static lora_dev_t radio = LORA_DEV_DEFAULT;
+static fsk_t fsk;                   // Nó de serviço (RX_FSK_MODE)
+static repeating_timer_t stats_timer;
+static repeating_timer_t sniff_timer;
+static repeating_timer_t time_timer;
+static repeating_timer_t console_timer;
+static volatile sniff_state_t sniff_state = SNIFF_OFF;
+static uint32_t sniff_cads, sniff_wakes, sniff_timeouts;
+
+// Estado do ARQ por estação: base e bitmap do próximo ACK, e o comando de
+// downlink que segue no lugar do ACK até a estação confirmá-lo (status no
+// uplink, que também traz o nonce de boot com que o comando é assinado)
+typedef struct {
+    bool used;
+    uint8_t src;
+    uint32_t last_us;           // Último quadro ouvido (escolha de quem sai com a tabela cheia)
+    arq_rx_t rx;
+    bool cmd_pending;
+    downlink_cmd_t cmd;         // counter 0: ainda não transmitido
+    uint32_t dl_nonce;          // Nonce do boot atual da estação (0: ainda não anunciado)
+    uint32_t dl_counter;        // Último contador usado com esta estação
+} arq_source_t;
+
+static arq_source_t arq_sources[ARQ_MAX_SOURCES];
+static bool ack_tx = false;
+static uint16_t ack_seq = 0;
+static uint32_t acks_sent = 0;
+static uint32_t arq_evictions = 0;
+
+// Comandos de downlink (DOWNLINK_ENABLED em downlink.h)
+static const uint8_t downlink_key[DOWNLINK_KEY_LEN] = DOWNLINK_KEY;
+static char console_line[CONSOLE_LINE_LEN];
+static size_t console_len;
+static uint32_t cmds_queued, cmds_sent, cmds_confirmed, cmds_rejected;
+static uint32_t status_rejected;    // Uplinks sem status ou com MAC inválido
+
+static uint32_t rx_overruns;     // Quadros sobrescritos na FIFO pelo seguinte
+static link_filter_t rx_filter;  // Outra rede, outro destino e duplicados sem ler a FIFO toda
+static frag_rx_t frag_pool;     // Remontagem das mensagens longas (no lugar, sem alocação)
+static fec_rx_t fec_pool;       // Blocos FEC: recupera fragmentos perdidos pela paridade
+
+// TDMA (TDMA_ENABLED em tdma.h): este receptor marca o início de cada ciclo
+static tdma_gw_t tdma;
+static uint32_t next_beacon_us;     // Início do próximo ciclo (time_us_32)
+static bool bcast_tx = false;     // Beacon ou quadro de tempo no ar
+static uint32_t beacons_sent, beacons_skipped;
+
+// Tempo de rede (TIME_SYNC_ENABLED em time_sync.h): este relógio é a referência
+static uint16_t time_seq = 0;
+static uint32_t time_sent, time_skipped;
+static uint32_t sample_latency_n, sample_latency_max_us;
+static uint64_t sample_latency_sum_us;
+
+static void on_fragment(uint8_t src, const uint8_t *frag, size_t len, uint32_t now_us) {
+    frag_message_t msg;
+    if (frag_rx_on_fragment(&frag_pool, src, frag, len, now_us, &msg) == FRAG_RX_COMPLETE) {
+        printf("Mensagem %u de %02X (%u bytes):\n%.*s\n", msg.id, msg.src, msg.len,
+               (int)msg.len, (const char *)msg.data);
+    }
 }
 
-uint8_t lora_read_reg(uint8_t reg) {
-    uint8_t val;
-    gpio_put(PIN_CS, 0);
-    spi_write_blocking(SPI_PORT, &reg, 1);
-    spi_read_blocking(SPI_PORT, 0, &val, 1);
-    gpio_put(PIN_CS, 1);
-    return val;
+// --- ISRs: apenas publicam eventos ---
+void radio_irq(lora_dev_t *dev, uint8_t dio, uint32_t events) {
+    if (RX_FSK_MODE) {
+        // A FIFO de 64 bytes enche em ~2 ms a 250 kbps: esvaziada aqui
+        if (dio == 1 && (events & GPIO_IRQ_EDGE_RISE)) {
+            fsk_rx_drain(&fsk);
+        } else if (dio == 0 && (events & GPIO_IRQ_EDGE_RISE) && fsk_rx_finish(&fsk)) {
+            event_post(EVT_DIO0, 0);
+        }
+        return;
+    }
+    if (dio == 0 && (events & GPIO_IRQ_EDGE_RISE)) {
+        event_post(EVT_DIO0, 0);
+    } else if (dio == 1 && (events & GPIO_IRQ_EDGE_RISE) && sniff_state != SNIFF_CAD) {
+        // Salto de canal não pode esperar o laço de eventos (na CAD o DIO1 é CadDetected)
+        fhss_on_change_channel(dev);
+    }
 }
 
-// --- Funções de alto nível do LoRa ---
-void lora_reset() {
-    gpio_put(PIN_RST, 0);
-    sleep_ms(1);
-    gpio_put(PIN_RST, 1);
-    sleep_ms(5);
+bool stats_timer_callback(repeating_timer_t *rt) {
+    event_post(EVT_TIMER, TIMER_STATS);
+    return true;
 }
 
-void lora_set_frequency(long frequency) {
-    uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
-    lora_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
-    lora_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
-    lora_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
+bool sniff_timer_callback(repeating_timer_t *rt) {
+    event_post(EVT_TIMER, TIMER_SNIFF);
+    return true;
 }
 
-void lora_init_rx() {
-    lora_reset();
+bool time_timer_callback(repeating_timer_t *rt) {
+    event_post(EVT_TIMER, TIMER_TIME);
+    return true;
+}
 
-    // Entra em modo Sleep para configurar o modo LoRa
-    lora_write_reg(REG_OPMODE, RF95_MODE_SLEEP);
-    sleep_ms(10);
-    
-    // Ativa o modo LoRa
-    lora_write_reg(REG_OPMODE, RF95_MODE_SLEEP);
-    lora_write_reg(REG_OPMODE, lora_read_reg(REG_OPMODE) | 0x80);
-    sleep_ms(10);
+bool console_timer_callback(repeating_timer_t *rt) {
+    event_post(EVT_TIMER, TIMER_CONSOLE);
+    return true;
+}
 
-    // Verifica se o modo LoRa foi ativado
-    if (lora_read_reg(REG_OPMODE) != (RF95_MODE_SLEEP | 0x80)) {
-        printf("Falha ao iniciar o modo LoRa!\n");
-        while(1);
+int64_t beacon_alarm_callback(alarm_id_t id, void *user_data) {
+    event_post(EVT_TIMER, TIMER_BEACON);
+    return 0;
+}
+
+// O alarme é de disparo único e rearmado contra o instante absoluto do
+// ciclo: a latência do laço de eventos não se acumula de um ciclo a outro
+static void schedule_beacon(void) {
+    next_beacon_us += tdma_cycle_us(&tdma.map);
+    int32_t wait_us = (int32_t)(next_beacon_us - time_us_32());
+    add_alarm_in_us(wait_us > 0 ? (uint64_t)wait_us : 0, beacon_alarm_callback, NULL, true);
+}
+
+static void sniff_sleep(void) {
+    sniff_state = SNIFF_SLEEP;
+    lora_sleep(&radio);
+}
+
+// Estado da estação src, só se ela já foi ouvida (não aloca nem despeja)
+static arq_source_t *find_arq_source(uint8_t src) {
+    for (int i = 0; i < ARQ_MAX_SOURCES; i++) {
+        if (arq_sources[i].used && arq_sources[i].src == src) {
+            return &arq_sources[i];
+        }
     }
-    
-    lora_write_reg(REG_OPMODE, RF95_MODE_STANDBY); // Volta para Standby
-    
-    // Configura a frequência
-    lora_set_frequency(LORA_FREQUENCY);
+    return NULL;
+}
 
-    // Configura ponteiros da FIFO para RX
-    lora_write_reg(REG_FIFO_RX_BASE_AD, 0);
-    lora_write_reg(REG_FIFO_ADDR_PTR, 0);
+// Estado da estação src; sem slot livre reaproveita o da estação ouvida há
+// mais tempo (ela recomeça com SYN ou pelo primeiro contato do ARQ)
+static arq_source_t *arq_source(uint8_t src, uint32_t now_us) {
+    arq_source_t *victim = find_arq_source(src);
+    if (victim) {
+        return victim;
+    }
+    victim = &arq_sources[0];
+    for (int i = 0; i < ARQ_MAX_SOURCES; i++) {
+        if (!arq_sources[i].used) {
+            victim = &arq_sources[i];
+            break;
+        }
+        if (now_us - arq_sources[i].last_us > now_us - victim->last_us) {
+            victim = &arq_sources[i];
+        }
+    }
+    if (victim->used) {
+        arq_evictions++;
+    }
+    memset(victim, 0, sizeof(*victim));
+    victim->used = true;
+    victim->src = src;
+    victim->last_us = now_us;
+    arq_rx_init(&victim->rx);
+    return victim;
+}
 
-    // Configura LNA para ganho máximo
-    lora_write_reg(REG_LNA, LNA_MAX_GAIN);
+// Responde dentro da janela de ACK que a estação abre após cada TX. Com um
+// comando pendente o quadro é LINK_FRAME_CMD: o ACK seguido do comando.
+static void send_ack(arq_source_t *s) {
+    uint8_t ack[ARQ_ACK_LEN + DOWNLINK_MAX_LEN];
+    uint8_t frame[ARQ_ACK_FRAME_LEN + DOWNLINK_MAX_LEN];
+    link_header_t hdr = { .net_id = LINK_NET_ID, .src = RX_NODE_ID, .dst = s->src,
+                          .seq = ack_seq++, .type = LINK_FRAME_ACK };
 
-    // Configura parâmetros do modem (DEVE SER IGUAL AO TX)
-    lora_write_reg(REG_MODEM_CONFIG, EXPLICIT_MODE | ERROR_CODING_4_5 | BANDWIDTH_125K);
-    lora_write_reg(REG_MODEM_CONFIG2, SPREADING_7 | CRC_ON);
-    lora_write_reg(REG_MODEM_CONFIG3, 0x04); // LnaGain set by REG_LNA, LnaAgcOn=1
+    size_t ack_len = arq_rx_build_ack(&s->rx, ack);
+    if (DOWNLINK_ENABLED && s->cmd_pending && s->dl_nonce != 0) {
+        if (s->cmd.counter == 0) {
+            s->cmd.counter = ++s->dl_counter;
+        }
+        ack_len += downlink_build(downlink_key, LINK_NET_ID, s->src, s->dl_nonce, &s->cmd, ack + ack_len);
+        hdr.type = LINK_FRAME_CMD;
+        cmds_sent++;
+    }
+    size_t len = link_frame_encode(&hdr, ack, ack_len, frame, sizeof(frame));
+    lora_set_dio_mapping(&radio, DIO0_MASK, DIO0_TX_DONE);
+    lora_start_tx(&radio, frame, (uint8_t)len);
+    ack_tx = true;
+    acks_sent++;
+}
 
-    // Mapear interrupção DIO0 para RxDone (00 -> RxDone)
-    lora_write_reg(REG_DIO_MAPPING_1, 0x00);
+// Início do ciclo: mapa de slots para as estações. Com um ACK no ar o ciclo
+// segue sem beacon; as estações toleram TDMA_SYNC_CYCLES beacons perdidos.
+static void send_beacon(void) {
+    uint8_t beacon[TDMA_BEACON_MAX_LEN];
+    uint8_t frame[LINK_HEADER_LEN + TDMA_BEACON_MAX_LEN];
+    size_t beacon_len = tdma_gw_build_beacon(&tdma, beacon);
+    if (ack_tx) {
+        beacons_skipped++;
+        return;
+    }
+    link_header_t hdr = { .net_id = LINK_NET_ID, .src = RX_NODE_ID, .dst = LINK_ADDR_BROADCAST,
+                          .seq = tdma.map.cycle, .type = LINK_FRAME_BEACON };
+    size_t len = link_frame_encode(&hdr, beacon, beacon_len, frame, sizeof(frame));
+    lora_set_dio_mapping(&radio, DIO0_MASK, DIO0_TX_DONE);
+    lora_start_tx(&radio, frame, (uint8_t)len);
+    bcast_tx = true;
+    beacons_sent++;
+}
 
-    // Colocar em modo de recepção contínua
-    lora_write_reg(REG_OPMODE, RF95_MODE_RX_CONTINUOUS);
-    printf("Módulo LoRa (RX) inicializado e ouvindo...\n");
+// Quadro de tempo: leva o instante exato em que o TX começa. A FIFO é
+// carregada antes e o TX sai com uma única escrita do OPMODE nesse instante;
+// a estação chega ao mesmo instante pelo RxDone menos o tempo no ar.
+static void send_time(void) {
+    if (ack_tx || bcast_tx || sniff_state == SNIFF_CAD || sniff_state == SNIFF_RX) {
+        time_skipped++;
+        return;
+    }
+    uint8_t payload[TIME_SYNC_PAYLOAD_LEN];
+    uint8_t frame[LINK_HEADER_LEN + TIME_SYNC_PAYLOAD_LEN];
+    uint64_t tx_at_us = time_us_64() + TIME_SYNC_TX_LEAD_US;
+    link_header_t hdr = { .net_id = LINK_NET_ID, .src = RX_NODE_ID, .dst = LINK_ADDR_BROADCAST,
+                          .seq = time_seq++, .type = LINK_FRAME_TIME };
+    size_t payload_len = time_sync_build(tx_at_us, payload);
+    size_t len = link_frame_encode(&hdr, payload, payload_len, frame, sizeof(frame));
+    lora_set_dio_mapping(&radio, DIO0_MASK, DIO0_TX_DONE);
+    lora_load_tx(&radio, frame, (uint8_t)len);
+    while (time_us_64() < tx_at_us) {
+        tight_loop_contents();
+    }
+    lora_write_reg(&radio, REG_OPMODE, RF95_MODE_TX);
+    bcast_tx = true;
+    time_sent++;
 }
 
-int lora_receive_packet(uint8_t *buffer, int max_len) {
-    // Verifica se a flag de 'RxDone' foi acionada
-    if ((lora_read_reg(REG_IRQ_FLAGS) & 0x40) == 0) {
-        return 0; // Nenhum pacote recebido
+// Status assinado depois do texto do uplink (downlink_status_build): boot
+// atual da estação e último comando aceito por ela, ou recusado (valor fora
+// das faixas da estação). Sem MAC válido o status é ignorado: ninguém troca o
+// nonce nem dá um comando por entregue em nome da estação.
+static void downlink_confirm(arq_source_t *s, const uint8_t *payload, size_t len) {
+    size_t text_len = strnlen((const char *)payload, len);
+    downlink_status_t st;
+    if (text_len == len ||
+        !downlink_status_parse(downlink_key, LINK_NET_ID, s->src, payload + text_len + 1, len - text_len - 1, &st)) {
+        status_rejected++;
+        return;
     }
+    if (st.nonce != s->dl_nonce) {
+        // A estação reiniciou (ou este receptor reiniciou e não a conhecia):
+        // o comando pendente é assinado de novo, acima do contador dela
+        if (s->dl_nonce != 0) {
+            printf("Estacao %02X reiniciou (nonce %08lx)\n", s->src, (unsigned long)st.nonce);
+        }
+        s->dl_nonce = st.nonce;
+        s->dl_counter = st.counter;
+        s->cmd.counter = 0;
+    } else if (s->cmd_pending && s->cmd.counter != 0 && st.counter >= s->cmd.counter) {
+        // Recusado não é repetido: o operador corrige e envia de novo
+        s->cmd_pending = false;
+        if (st.nacked && st.counter == s->cmd.counter) {
+            cmds_rejected++;
+            printf("Comando %lu recusado por %02X (valor fora da faixa)\n", (unsigned long)st.counter, s->src);
+        } else {
+            cmds_confirmed++;
+            printf("Comando %lu confirmado por %02X\n", (unsigned long)st.counter, s->src);
+        }
+    }
+}
+
+// Campos do comando "cfg": valor digitado x escala = valor do TLV
+static const struct {
+    const char *name;
+    downlink_tlv_t type;
+    float scale;
+    int32_t min, max;           // Faixa do TLV
+} cmd_fields[] = {
+    { "tmin",         DOWNLINK_MIN_TEMP,      100, INT16_MIN, INT16_MAX },
+    { "tmax",         DOWNLINK_MAX_TEMP,      100, INT16_MIN, INT16_MAX },
+    { "umin",         DOWNLINK_MIN_HUM,       100, INT16_MIN, INT16_MAX },
+    { "umax",         DOWNLINK_MAX_HUM,       100, INT16_MIN, INT16_MAX },
+    { "otemp",        DOWNLINK_OFFSET_TEMP,   100, INT16_MIN, INT16_MAX },
+    { "oumid",        DOWNLINK_OFFSET_HUM,    100, INT16_MIN, INT16_MAX },
+    { "opress",       DOWNLINK_OFFSET_PRESS,  100, INT16_MIN, INT16_MAX },
+    { "amostra_ms",   DOWNLINK_SAMPLE_PERIOD, 1,   0, UINT16_MAX },
+    { "heartbeat_s",  DOWNLINK_HEARTBEAT,     1,   0, UINT16_MAX },
+    { "potencia_dbm", DOWNLINK_TX_POWER,      1,   INT8_MIN, INT8_MAX },
+};
 
-    // Limpa a flag de IRQ
-    lora_write_reg(REG_IRQ_FLAGS, 0xFF);
+static void queue_command(arq_source_t *s, const downlink_cmd_t *cmd) {
+    downlink_cmd_t merged;
+    uint8_t probe[DOWNLINK_MAX_LEN];
+    if (s->cmd_pending) {
+        merged = s->cmd;
+    } else {
+        downlink_cmd_init(&merged);
+    }
+    for (int t = 0; t < DOWNLINK_NUM_TLVS; t++) {
+        if (cmd->present & (1u << t)) {
+            downlink_cmd_set(&merged, (downlink_tlv_t)t, cmd->value[t]);
+        }
+    }
+    // O quadro precisa caber na janela de RX da estação
+    if (downlink_build(downlink_key, LINK_NET_ID, s->src, s->dl_nonce, &merged, probe) == 0) {
+        printf("cfg: comando para %02X passa de %u bytes de TLVs\n", s->src, DOWNLINK_MAX_TLV_LEN);
+        return;
+    }
+    s->cmd = merged;
+    s->cmd.counter = 0;
+    s->cmd_pending = true;
+    cmds_queued++;
+    printf("Comando para %02X na fila (enviado no proximo ACK)\n", s->src);
+}
 
-    // Verifica se houve erro de CRC
-    if ((lora_read_reg(REG_IRQ_FLAGS) & 0x20)) {
-        printf("Erro de CRC!\n");
-        return 0;
+// "cfg <estacao em hex | FF para todas> campo=valor ...": o comando segue
+// no próximo ACK de cada estação. Campos novos se somam ao comando ainda
+// não confirmado, que ganha contador novo.
+static void console_command(char *line) {
+    char *tok = strtok(line, " \t");
+    if (!tok || strcmp(tok, "cfg") != 0) {
+        printf("Comandos: cfg <estacao|FF> campo=valor ... (campos:");
+        for (size_t f = 0; f < sizeof(cmd_fields) / sizeof(cmd_fields[0]); f++) {
+            printf(" %s", cmd_fields[f].name);
+        }
+        printf(")\n");
+        return;
+    }
+    tok = strtok(NULL, " \t");
+    if (!tok) {
+        printf("cfg: falta a estacao\n");
+        return;
     }
+    uint8_t dst = (uint8_t)strtoul(tok, NULL, 16);
 
-    // Pega o tamanho do pacote recebido
-    int len = lora_read_reg(REG_RX_NB_BYTES);
-    if (len > max_len) {
-        len = max_len;
+    downlink_cmd_t cmd;
+    downlink_cmd_init(&cmd);
+    while ((tok = strtok(NULL, " \t")) != NULL) {
+        char *eq = strchr(tok, '=');
+        size_t f = 0;
+        if (eq) {
+            *eq = '\0';
+            while (f < sizeof(cmd_fields) / sizeof(cmd_fields[0]) && strcmp(tok, cmd_fields[f].name) != 0) {
+                f++;
+            }
+        }
+        if (!eq || f == sizeof(cmd_fields) / sizeof(cmd_fields[0])) {
+            printf("cfg: campo invalido '%s'\n", tok);
+            return;
+        }
+        long value = lroundf(strtof(eq + 1, NULL) * cmd_fields[f].scale);
+        if (value < cmd_fields[f].min || value > cmd_fields[f].max) {
+            printf("cfg: %s fora da faixa\n", tok);
+            return;
+        }
+        downlink_cmd_set(&cmd, cmd_fields[f].type, (int32_t)value);
+    }
+    if (!cmd.present) {
+        printf("cfg: nenhum campo\n");
+        return;
     }
 
-    // Aponta para o início do pacote na FIFO
-    uint8_t current_addr = lora_read_reg(REG_FIFO_RX_CURRENT_ADDR);
-    lora_write_reg(REG_FIFO_ADDR_PTR, current_addr);
+    if (dst != LINK_ADDR_BROADCAST) {
+        // Só estações já ouvidas: o comando precisa do nonce de boot delas, e
+        // um endereço digitado não pode despejar o estado de outra estação
+        arq_source_t *s = find_arq_source(dst);
+        if (!s) {
+            printf("cfg: estacao %02X desconhecida\n", dst);
+            return;
+        }
+        queue_command(s, &cmd);
+        return;
+    }
+    // Todas as estações já ouvidas
+    for (int i = 0; i < ARQ_MAX_SOURCES; i++) {
+        if (arq_sources[i].used) {
+            queue_command(&arq_sources[i], &cmd);
+        }
+    }
+}
 
-    // Lê os dados da FIFO
-    for (int i = 0; i < len; i++) {
-        buffer[i] = lora_read_reg(REG_FIFO);
+static void console_poll(void) {
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == '\r' || c == '\n') {
+            if (console_len > 0) {
+                console_line[console_len] = '\0';
+                console_len = 0;
+                console_command(console_line);
+            }
+        } else if (console_len < CONSOLE_LINE_LEN - 1) {
+            console_line[console_len++] = (char)c;
+        }
     }
+}
 
-    return len;
+// Volta a ouvir depois do ACK, do beacon ou do quadro de tempo
+static void resume_rx(void) {
+    if (sniff_state != SNIFF_OFF) {
+        sniff_sleep();
+        return;
+    }
+    lora_set_dio_mapping(&radio, DIO0_MASK, DIO0_RX_DONE);
+    lora_write_reg(&radio, REG_FIFO_ADDR_PTR, 0);
+    lora_write_reg(&radio, REG_OPMODE, RF95_MODE_RX_CONTINUOUS);
 }
 
 // --- Função Principal ---
 int main() {
+    boot_trace_init();
     stdio_init_all();
-    sleep_ms(2000);
+    boot_wait_usb(USB_WAIT_MS); // Segue assim que a serial conectar
+    boot_trace_mark("stdio");
     printf("Inicializando Receptor LoRa...\n");
 
     // Inicializa hardware (SPI e GPIO)
-    gpio_init(PIN_CS);
-    gpio_set_dir(PIN_CS, GPIO_OUT);
-    gpio_put(PIN_CS, 1);
-
-    gpio_init(PIN_RST);
-    gpio_set_dir(PIN_RST, GPIO_OUT);
+    lora_spi_init(&radio);
 
-    spi_init(SPI_PORT, 1000 * 1000);
-    gpio_set_function(PIN_MISO, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_SCK, GPIO_FUNC_SPI);
-    gpio_set_function(PIN_MOSI, GPIO_FUNC_SPI);
+    // O RxDone chega pelo DIO0: nenhuma leitura de REG_IRQ_FLAGS enquanto ocioso
+    gpio_init(radio.pin_dio0);
+    gpio_set_dir(radio.pin_dio0, GPIO_IN);
+    gpio_init(radio.pin_dio1);
+    gpio_set_dir(radio.pin_dio1, GPIO_IN);
 
     // Inicializa o rádio LoRa no modo RX
-    lora_init_rx();
+    if (!lora_init_rx(&radio)) {
+        while (1);
+    }
+    // Mesma sequência de saltos da estação (FHSS_HOP_PERIOD em channel_plan.h)
+    fhss_init(&radio, FHSS_HOP_PERIOD, FHSS_SEED);
+    boot_trace_mark("radio");
+
+    lora_irq_attach(&radio, radio_irq, NULL);
+    lora_irq_enable(&radio, 0, GPIO_IRQ_EDGE_RISE, true);
+    if (fhss_enabled(&radio)) {
+        lora_irq_enable(&radio, 1, GPIO_IRQ_EDGE_RISE, true);
+    }
+    add_repeating_timer_ms(STATS_PERIOD_MS, stats_timer_callback, NULL, &stats_timer);
+    if (TDMA_ENABLED) {
+        // Os slots são do tamanho do quadro no modem padrão da estação.
+        // A amostragem de preâmbulo não combina com o TDMA: o receptor
+        // precisa ouvir todos os slots.
+        lora_modem_cfg_t modem = LORA_MODEM_CFG_DEFAULT(LORA_PREAMBLE_LEN);
+        tdma_gw_init(&tdma, &modem);
+        next_beacon_us = time_us_32();
+        schedule_beacon();
+    } else if (LORA_SNIFF_PERIOD_US > 0) {
+        sniff_sleep();
+        add_repeating_timer_us(-(int64_t)LORA_SNIFF_PERIOD_US, sniff_timer_callback, NULL, &sniff_timer);
+    }
+    // No TDMA o quadro de tempo cairia no slot de uma estação: só sem TDMA
+    if (TIME_SYNC_ENABLED && !TDMA_ENABLED) {
+        add_repeating_timer_ms(-TIME_SYNC_PERIOD_MS, time_timer_callback, NULL, &time_timer);
+    }
+    if (DOWNLINK_ENABLED && !RX_FSK_MODE && !RX_FAST_MODE) {
+        add_repeating_timer_ms(CONSOLE_POLL_MS, console_timer_callback, NULL, &console_timer);
+    }
 
     uint8_t buffer[256];
+    lora_rx_meta_t meta;
+    event_t evt;
+
+    link_stats_init();
+    link_filter_init(&rx_filter, LINK_NET_ID, link_stats_seen);
+    link_filter_add_addr(&rx_filter, RX_NODE_ID);
+    if (RX_FSK_MODE) {
+        // O cabeçalho de enlace é conferido depois de o pacote sair da FIFO
+        fsk_init(&fsk, &radio);
+        if (!fsk_begin(&fsk)) {
+            while (1);
+        }
+        fsk_start_rx(&fsk);
+        lora_irq_enable(&radio, 1, GPIO_IRQ_EDGE_RISE, true);
+    } else if (RX_FAST_MODE) {
+        // O quadro fixo não tem o cabeçalho de enlace: sem filtro antecipado
+        lora_set_fast_mode(&radio, true, FAST_FRAME_LEN);
+        resume_rx();
+    } else {
+        lora_set_rx_filter(&radio, link_filter_accept, LINK_HEADER_LEN, &rx_filter);
+    }
+    afc_init(&radio);
+    frag_rx_init(&frag_pool);
+    fec_init();
+    fec_rx_init(&fec_pool);
+    boot_trace_print();     // Inicialização completa: a linha do tempo sai uma vez
 
     while (1) {
-        int packet_len = lora_receive_packet(buffer, sizeof(buffer));
-        if (packet_len > 0) {
-            buffer[packet_len] = '\0'; // Adiciona terminador nulo para imprimir como string
-            printf("Pacote recebido (%d bytes): '%s'\n", packet_len, buffer);
+        event_wait(&evt);
+
+        if (evt.type == EVT_DIO0 && (ack_tx || bcast_tx)) {
+            // TxDone do ACK, do beacon ou do quadro de tempo
+            lora_write_reg(&radio, REG_IRQ_FLAGS, 0xFF);
+            fhss_packet_done(&radio);
+            ack_tx = false;
+            bcast_tx = false;
+            resume_rx();
+        } else if (evt.type == EVT_DIO0 && sniff_state == SNIFF_CAD) {
+            // CadDone: acorda o receptor só se houver preâmbulo no ar
+            if (lora_cad_finish(&radio)) {
+                sniff_wakes++;
+                sniff_state = SNIFF_RX;
+                lora_start_rx_single(&radio, SNIFF_RX_TIMEOUT_SYMB);
+            } else {
+                sniff_sleep();
+            }
+        } else if (evt.type == EVT_DIO0) {
+            fhss_packet_done(&radio);
+            meta.crc_ok = true;
+            int packet_len = RX_FSK_MODE ? fsk_rx_take(&fsk, buffer, sizeof(buffer) - 1, &meta)
+                                         : lora_receive_packet(&radio, buffer, sizeof(buffer) - 1, &meta);
+            meta.time_us = evt.post_us;     // Borda do RxDone, carimbada na ISR pelo event_post
+            fast_frame_t fast;
+            if (packet_len > 0 && RX_FAST_MODE) {
+                uint8_t reasons;
+                float temp, hum;
+                if (fast_frame_decode(buffer, (size_t)packet_len, LINK_NET_ID, &fast) && fast.type == FAST_FRAME_ALARM) {
+                    fast_frame_alarm_values(&fast, &reasons, &temp, &hum);
+                    printf("Alarme rapido de %02X seq %u: motivo 0x%02X, T=%.1f, U=%.0f (RSSI %d dBm, SNR %.2f dB)\n",
+                           fast.src, fast.seq, reasons, temp, hum, meta.rssi_dbm, meta.snr_q4 / 4.0);
+                } else {
+                    printf("Quadro rapido invalido (%d bytes)\n", packet_len);
+                }
+            } else if (packet_len > 0) {
+                buffer[packet_len] = '\0'; // Adiciona terminador nulo para imprimir como string
+
+                link_header_t hdr;
+                const uint8_t *payload;
+                int payload_len = link_frame_decode(buffer, packet_len, &hdr, &payload);
+                // Quadros com pedido de ACK são confirmados mesmo se duplicados:
+                // o ACK anterior pode ter se perdido
+                if (payload_len >= 0 && (hdr.flags & LINK_FLAG_ACK_REQ) && hdr.dst == RX_NODE_ID) {
+                    arq_source_t *s = arq_source(hdr.src, meta.time_us);
+                    s->last_us = meta.time_us;
+                    bool fresh = arq_rx_on_frame(&s->rx, hdr.seq, hdr.flags & LINK_FLAG_SYN);
+                    // A confirmação do comando vem antes: evita reenviá-lo neste
+                    // ACK. Só de quadros novos no ARQ: um status repetido não
+                    // volta o nonce a um boot anterior.
+                    if (DOWNLINK_ENABLED && fresh && hdr.type == LINK_FRAME_DATA) {
+                        downlink_confirm(s, payload, (size_t)payload_len);
+                    }
+                    send_ack(s);
+                }
+                // Qualquer quadro para este receptor renova (ou pede) o slot da estação
+                if (TDMA_ENABLED && payload_len >= 0 && hdr.dst == RX_NODE_ID) {
+                    tdma_gw_on_frame(&tdma, hdr.src);
+                }
+
+                if (payload_len < 0) {
+                    printf("Quadro sem cabecalho de enlace (%d bytes, RSSI %d dBm): '%s'\n",
+                           packet_len, meta.rssi_dbm, buffer);
+                } else if (link_stats_record(hdr.src, hdr.seq, (uint16_t)payload_len, &meta) == LINK_SEQ_DUPLICATE) {
+                    printf("Quadro duplicado de %02X (seq %u) descartado\n", hdr.src, hdr.seq);
+                } else if (hdr.type == LINK_FRAME_FRAG) {
+                    on_fragment(hdr.src, payload, (size_t)payload_len, meta.time_us);
+                } else if (hdr.type == LINK_FRAME_FEC) {
+                    // Fragmentos recebidos saem na hora; os perdidos, quando o
+                    // bloco tiver N quadros
+                    fec_output_t out;
+                    fec_rx_on_frame(&fec_pool, hdr.src, payload, (size_t)payload_len, meta.time_us, &out);
+                    for (uint8_t i = 0; i < out.count; i++) {
+                        on_fragment(hdr.src, out.data[i], out.len[i], meta.time_us);
+                    }
+                } else {
+                    printf("Pacote de %02X seq %u tipo %u (%d bytes, RSSI %d dBm, SNR %.2f dB, Ferr %ld Hz): '%s'\n",
+                           hdr.src, hdr.seq, hdr.type, payload_len, meta.rssi_dbm, meta.snr_q4 / 4.0,
+                           (long)meta.freq_error_hz, (const char *)payload);
+
+                    // A temperatura da estação (T=) alimenta o modelo de deriva do cristal
+                    float temp = NAN;
+                    if (hdr.type == LINK_FRAME_DATA) {
+                        sscanf((const char *)payload, "T=%f", &temp);
+                    }
+                    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+                    afc_update(hdr.src, meta.freq_error_hz, temp, now_ms);
+                    afc_retune(now_ms);
+
+                    // N= é o instante da amostra no tempo de rede (este relógio)
+                    const char *stamp = strstr((const char *)payload, ";N=");
+                    unsigned long sample_us;
+                    if (stamp && sscanf(stamp, ";N=%lu", &sample_us) == 1) {
+                        uint32_t latency = meta.time_us - (uint32_t)sample_us;
+                        sample_latency_n++;
+                        sample_latency_sum_us += latency;
+                        if (latency > sample_latency_max_us) {
+                            sample_latency_max_us = latency;
+                        }
+                    }
+                }
+            } else if (!meta.crc_ok) {
+                link_stats_crc_error(&meta);
+            } else if (meta.overrun) {
+                rx_overruns++;
+            }
+            if (sniff_state == SNIFF_RX && !ack_tx) {
+                sniff_sleep();
+            }
+        } else if (evt.type == EVT_TIMER && evt.arg == TIMER_SNIFF) {
+            if (sniff_state == SNIFF_SLEEP) {
+                sniff_cads++;
+                sniff_state = SNIFF_CAD;
+                lora_start_cad(&radio);
+            } else if (sniff_state == SNIFF_RX && (lora_read_reg(&radio, REG_IRQ_FLAGS) & IRQ_RX_TIMEOUT)) {
+                // Falso alarme: o preâmbulo não se confirmou dentro do timeout
+                lora_write_reg(&radio, REG_IRQ_FLAGS, 0xFF);
+                sniff_timeouts++;
+                sniff_sleep();
+            }
+        } else if (evt.type == EVT_TIMER && evt.arg == TIMER_BEACON) {
+            send_beacon();
+            schedule_beacon();
+        } else if (evt.type == EVT_TIMER && evt.arg == TIMER_TIME) {
+            send_time();
+        } else if (evt.type == EVT_TIMER && evt.arg == TIMER_CONSOLE) {
+            console_poll();
+        } else if (evt.type == EVT_TIMER) {
+            event_loop_print_stats();
+            link_stats_print();
+            printf("Filtro de RX: %lu aceitos, %lu de outra rede, %lu para outro destino, %lu duplicados; "
+                   "%lu sobrescritos na FIFO\n",
+                   (unsigned long)rx_filter.accepted, (unsigned long)rx_filter.foreign_net,
+                   (unsigned long)rx_filter.other_dst, (unsigned long)rx_filter.duplicates,
+                   (unsigned long)rx_overruns);
+            afc_print();
+            printf("ARQ: %lu ACKs enviados, %lu estacoes substituidas na tabela\n",
+                   (unsigned long)acks_sent, (unsigned long)arq_evictions);
+            if (DOWNLINK_ENABLED) {
+                printf("Downlink: %lu comandos na fila, %lu envios, %lu confirmados, %lu recusados, %lu status invalidos\n",
+                       (unsigned long)cmds_queued, (unsigned long)cmds_sent, (unsigned long)cmds_confirmed,
+                       (unsigned long)cmds_rejected, (unsigned long)status_rejected);
+            }
+            frag_rx_expire(&frag_pool, time_us_32());
+            printf("Fragmentos: %lu recebidos, %lu mensagens (%lu bytes), %lu duplicados, %lu invalidos, %lu sem slot, %lu expiradas\n",
+                   (unsigned long)frag_pool.stats.fragments, (unsigned long)frag_pool.stats.messages,
+                   (unsigned long)frag_pool.stats.bytes, (unsigned long)frag_pool.stats.duplicates,
+                   (unsigned long)frag_pool.stats.invalid, (unsigned long)frag_pool.stats.no_slot,
+                   (unsigned long)frag_pool.stats.timeouts);
+            fec_rx_expire(&fec_pool, time_us_32());
+            printf("FEC: %lu quadros, %lu blocos, %lu fragmentos recuperados, %lu blocos perdidos\n",
+                   (unsigned long)fec_pool.stats.frames, (unsigned long)fec_pool.stats.blocks,
+                   (unsigned long)fec_pool.stats.recovered, (unsigned long)fec_pool.stats.lost_blocks);
+            if (TIME_SYNC_ENABLED) {
+                printf("Tempo de rede: %lu quadros (%lu pulados); amostra -> RxDone: %lu medidas, media %lu us, max %lu us\n",
+                       (unsigned long)time_sent, (unsigned long)time_skipped, (unsigned long)sample_latency_n,
+                       (unsigned long)(sample_latency_n ? sample_latency_sum_us / sample_latency_n : 0),
+                       (unsigned long)sample_latency_max_us);
+            }
+            if (TDMA_ENABLED) {
+                printf("TDMA: ciclo %u, %u slots de %lu us, %u estacoes, %lu beacons (%lu pulados), "
+                       "%lu reservas, %lu liberados, %lu sem slot\n",
+                       tdma.map.cycle, tdma.map.num_slots, (unsigned long)tdma.map.slot_us, tdma_gw_members(&tdma),
+                       (unsigned long)beacons_sent, (unsigned long)beacons_skipped, (unsigned long)tdma.assigned,
+                       (unsigned long)tdma.released, (unsigned long)tdma.full);
+            }
+            if (RX_FSK_MODE) {
+                fsk_stats_t fsk_stats;
+                fsk_get_stats(&fsk, &fsk_stats);
+                printf("FSK: %lu pacotes, %lu erros de CRC, %lu FIFOs transbordadas, %lu sem slot\n",
+                       (unsigned long)fsk_stats.rx_frames, (unsigned long)fsk_stats.rx_crc_errors,
+                       (unsigned long)fsk_stats.rx_overruns, (unsigned long)fsk_stats.rx_dropped);
+            }
+            if (sniff_state != SNIFF_OFF) {
+                printf("Amostragem de preambulo: %lu CADs, %lu despertares, %lu timeouts\n",
+                       (unsigned long)sniff_cads, (unsigned long)sniff_wakes, (unsigned long)sniff_timeouts);
+            }
         }
     }
 
     return 0;
-}
\ No newline at end of file
+}
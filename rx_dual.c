@@ -0,0 +1,132 @@
+// lora_rx_dual.c (gateway com dois rádios)
+//
+// Dois SX1276 na mesma placa, cada um no seu barramento SPI, recebendo ao
+// mesmo tempo em canais diferentes: o rádio A no canal padrão (o dos nós) e o
+// rádio B no canal seguinte. Cada rádio tem o seu lora_dev_t e a sua ISR; o
+// evento leva o índice do rádio que recebeu.
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "sx1276.h"
+#include "channel_plan.h"
+#include "event_loop.h"
+#include "boot_trace.h"
+#include "link_frame.h"
+
+#define USB_WAIT_MS     2000    // Espera máxima pela serial USB (segue ao conectar)
+#define STATS_EVERY_PACKETS 20  // Imprime estatísticas a cada N pacotes
+#define NUM_RADIOS      2
+
+// Segundo módulo no spi1 (ajuste conforme a ligação)
+#define LORA_B_SPI_PORT spi1
+#define LORA_B_PIN_MISO 12
+#define LORA_B_PIN_MOSI 11
+#define LORA_B_PIN_SCK  10
+#define LORA_B_PIN_CS   13
+#define LORA_B_PIN_RST  14
+#define LORA_B_PIN_DIO0 15
+#define LORA_B_PIN_DIO1 26
+
+static lora_dev_t radios[NUM_RADIOS] = {
+    LORA_DEV_DEFAULT,
+    {
+        .spi = LORA_B_SPI_PORT, .pin_miso = LORA_B_PIN_MISO, .pin_mosi = LORA_B_PIN_MOSI,
+        .pin_sck = LORA_B_PIN_SCK, .pin_cs = LORA_B_PIN_CS, .pin_rst = LORA_B_PIN_RST,
+        .pin_dio0 = LORA_B_PIN_DIO0, .pin_dio1 = LORA_B_PIN_DIO1,
+        .frequency_hz = CHANNEL_PLAN_HZ(CHANNEL_PLAN_DEFAULT + 1),
+    },
+};
+
+// Sequência acompanhada por rádio (um transmissor por canal neste exemplo)
+static link_seq_tracker_t trackers[NUM_RADIOS];
+
+// --- Rotina de Tratamento de Interrupção (ISR) ---
+// ctx é o índice do rádio; a leitura da FIFO fica para o laço principal
+void radio_irq(lora_dev_t *dev, uint8_t dio, uint32_t events) {
+    if (dio == 0 && (events & GPIO_IRQ_EDGE_RISE) != 0) {
+        event_post(EVT_DIO0, (uint32_t)(uintptr_t)dev->irq_ctx);
+    }
+}
+
+void lora_processar_pacote(uint32_t idx) {
+    uint8_t buffer[256];
+    lora_rx_meta_t meta = { .crc_ok = true };   // Sem RxDone meta não é preenchido
+
+    int len = lora_receive_packet(&radios[idx], buffer, sizeof(buffer) - 1, &meta);
+    if (len == 0) {
+        if (!meta.crc_ok) {
+            printf("[%c] Erro de CRC!\n", 'A' + (int)idx);
+        }
+        return;
+    }
+    buffer[len] = '\0';
+
+    link_header_t hdr;
+    const uint8_t *payload;
+    int payload_len = link_frame_decode(buffer, len, &hdr, &payload);
+    if (payload_len < 0) {
+        printf("[%c] Pacote recebido (%d bytes): '%s'\n", 'A' + (int)idx, len, buffer);
+        return;
+    }
+
+    if (link_seq_track(&trackers[idx], hdr.seq, (uint16_t)payload_len, time_us_32()) == LINK_SEQ_DUPLICATE) {
+        printf("[%c] Duplicado de %02X (seq %u) descartado\n", 'A' + (int)idx, hdr.src, hdr.seq);
+        return;
+    }
+    printf("[%c] Pacote de %02X seq %u (%d bytes, RSSI %d dBm): '%s'\n", 'A' + (int)idx,
+           hdr.src, hdr.seq, payload_len, meta.rssi_dbm, (const char *)payload);
+}
+
+// --- Função Principal ---
+int main() {
+    boot_trace_init();
+    stdio_init_all();
+    boot_wait_usb(USB_WAIT_MS); // Segue assim que a serial conectar
+    boot_trace_mark("stdio");
+    printf("Inicializando Gateway LoRa com %d rádios...\n", NUM_RADIOS);
+
+    for (int i = 0; i < NUM_RADIOS; i++) {
+        lora_dev_t *dev = &radios[i];
+        lora_spi_init(dev);
+        gpio_init(dev->pin_dio0);
+        gpio_set_dir(dev->pin_dio0, GPIO_IN);
+
+        if (!lora_init_rx(dev)) {
+            printf("Rádio %c não respondeu\n", 'A' + i);
+            while (1);
+        }
+        lora_irq_attach(dev, radio_irq, (void *)(uintptr_t)i);
+        lora_irq_enable(dev, 0, GPIO_IRQ_EDGE_RISE, true);
+        printf("Rádio %c em %lu Hz\n", 'A' + i, (unsigned long)dev->frequency_hz);
+    }
+    boot_trace_mark("radio");
+
+    uint32_t packets = 0;
+    event_t evt;
+
+    while (1) {
+        // O processador dorme em WFI até a próxima interrupção publicar um evento
+        event_wait(&evt);
+
+        if (evt.type == EVT_DIO0 && evt.arg < NUM_RADIOS) {
+            lora_processar_pacote(evt.arg);
+            if (++packets % STATS_EVERY_PACKETS == 0) {
+                boot_trace_print();
+                event_loop_print_stats();
+                for (int i = 0; i < NUM_RADIOS; i++) {
+                    lora_spi_stats_t spi;
+                    lora_get_spi_stats(&radios[i], &spi);
+                    printf("Rádio %c: %lu recebidos, %lu perdidos, %lu duplicados, goodput %lu bit/s, SPI %lu leituras/%lu escritas\n",
+                           'A' + i, (unsigned long)trackers[i].received, (unsigned long)trackers[i].lost,
+                           (unsigned long)trackers[i].duplicates,
+                           (unsigned long)link_seq_goodput_bps(&trackers[i]),
+                           (unsigned long)spi.reads, (unsigned long)spi.writes);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,2 @@
+// Substituto do cabeçalho do Pico SDK para o simulador no host
+#include "pico_host.h"
@@ -0,0 +1,460 @@
+// Implementação no Linux das funções do Pico SDK usadas pelo firmware.
+// Relógio: tempo monotônico real desde o início do processo multiplicado por
+// SIM_SPEEDUP. SIM_DURATION_S encerra a execução (tempo simulado) e imprime o
+// relatório do modelo do rádio.
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "pico_host.h"
+
+#define HOST_MAX_ALARMS     16
+#define HOST_IDLE_STEP_US   200     // Maior passo de espera real no WFI/sleep
+
+spi_inst_t host_spi0, host_spi1;
+
+static bool started;
+static uint64_t boot_real_us;
+static double speedup = 1.0;
+static uint64_t end_us;             // 0: sem limite
+static volatile sig_atomic_t stop_requested;
+
+static uint32_t irq_masked;
+static bool in_irq;
+
+static repeating_timer_t *timers;
+
+typedef struct {
+    bool active;
+    alarm_id_t id;
+    uint64_t target_us;
+    alarm_callback_t callback;
+    void *user_data;
+} host_alarm_t;
+
+static host_alarm_t alarms[HOST_MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+
+static bool gpio_out[HOST_NUM_GPIOS];
+static bool gpio_last[HOST_NUM_GPIOS];
+static uint32_t gpio_irq_events[HOST_NUM_GPIOS];
+static uint32_t gpio_latched[HOST_NUM_GPIOS];     // Bordas aguardando a ISR
+static gpio_irq_callback_t gpio_irq_callback;
+
+uint64_t host_real_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+double host_speedup(void) {
+    return speedup;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void host_start(void) {
+    if (started) {
+        return;
+    }
+    started = true;
+    boot_real_us = host_real_us();
+
+    const char *env = getenv("SIM_SPEEDUP");
+    if (env && atof(env) > 0) {
+        speedup = atof(env);
+    }
+    env = getenv("SIM_DURATION_S");
+    if (env && atof(env) > 0) {
+        end_us = (uint64_t)(atof(env) * 1e6);
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    sx_model_init();
+    atexit(sx_model_report);
+}
+
+static void check_exit(void) {
+    if (stop_requested || (end_us && time_us_64() >= end_us)) {
+        fflush(stdout);
+        exit(0);
+    }
+}
+
+// Espera real correspondente a us de tempo simulado
+static void real_sleep(uint64_t us) {
+    uint64_t real = (uint64_t)(us / speedup);
+    if (real == 0) {
+        real = 1;
+    }
+    struct timespec ts = { .tv_sec = (time_t)(real / 1000000u), .tv_nsec = (long)(real % 1000000u) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+// --- Tempo ---
+uint64_t time_us_64(void) {
+    host_start();
+    return (uint64_t)((host_real_us() - boot_real_us) * speedup);
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return time_us_64() + (uint64_t)ms * 1000u;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us) {
+    return time_us_64() + us;
+}
+
+bool time_reached(absolute_time_t t) {
+    return time_us_64() >= t;
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+// --- "Interrupções" ---
+
+static bool timer_due(uint64_t now, uint64_t *next) {
+    bool due = false;
+    for (repeating_timer_t *t = timers; t; t = t->next) {
+        if (t->active) {
+            due |= now >= t->next_us;
+            if (t->next_us < *next) {
+                *next = t->next_us;
+            }
+        }
+    }
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].active) {
+            due |= now >= alarms[i].target_us;
+            if (alarms[i].target_us < *next) {
+                *next = alarms[i].target_us;
+            }
+        }
+    }
+    return due;
+}
+
+// Amostra os pinos do rádio e trava as bordas habilitadas, como o detector de
+// bordas do RP2040 (a borda fica pendente até a ISR rodar)
+static bool sample_pins(void) {
+    bool pending = false;
+    sx_model_update();
+    for (uint g = 0; g < HOST_NUM_GPIOS; g++) {
+        int level = sx_model_pin_level(g);
+        if (level >= 0 && level != gpio_last[g]) {
+            gpio_latched[g] |= (level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL) & gpio_irq_events[g];
+            gpio_last[g] = level;
+        }
+        pending |= gpio_latched[g] != 0;
+    }
+    return pending;
+}
+
+// Algo para atender? Preenche next com o próximo prazo de timer
+static bool host_pending(uint64_t *next) {
+    bool pins = sample_pins();
+    return timer_due(time_us_64(), next) || pins;
+}
+
+static void run_timers(void) {
+    uint64_t now = time_us_64();
+    for (repeating_timer_t *t = timers; t; t = t->next) {
+        if (!t->active || now < t->next_us) {
+            continue;
+        }
+        uint64_t scheduled = t->next_us;
+        if (!t->callback(t)) {
+            t->active = false;
+        } else if (t->delay_us < 0) {
+            t->next_us = scheduled + (uint64_t)(-t->delay_us);
+        } else {
+            t->next_us = time_us_64() + (uint64_t)t->delay_us;
+        }
+    }
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        host_alarm_t *a = &alarms[i];
+        if (!a->active || now < a->target_us) {
+            continue;
+        }
+        a->active = false;
+        int64_t again = a->callback(a->id, a->user_data);
+        if (again > 0) {
+            a->target_us = time_us_64() + (uint64_t)again;
+            a->active = true;
+        } else if (again < 0) {
+            a->target_us += (uint64_t)(-again);
+            a->active = true;
+        }
+    }
+}
+
+// Atende as bordas dos DIOs e os timers vencidos, como as ISRs fariam
+static void host_dispatch(void) {
+    if (irq_masked || in_irq) {
+        return;
+    }
+    check_exit();
+    in_irq = true;
+    sample_pins();
+    for (uint g = 0; g < HOST_NUM_GPIOS; g++) {
+        uint32_t events = gpio_latched[g];
+        if (events) {
+            gpio_latched[g] = 0;
+            if (gpio_irq_callback) {
+                gpio_irq_callback(g, events);
+            }
+        }
+    }
+    run_timers();
+    in_irq = false;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    uint32_t old = irq_masked;
+    irq_masked = 1;
+    return old;
+}
+
+void restore_interrupts(uint32_t status) {
+    irq_masked = status;
+    if (!irq_masked) {
+        host_dispatch();
+    }
+}
+
+// Como no M0+, o WFI com interrupções mascaradas acorda com uma pendente e a
+// ISR só roda ao reabilitar
+void __wfi(void) {
+    if (in_irq) {
+        return;
+    }
+    while (true) {
+        check_exit();
+        uint64_t next = UINT64_MAX;
+        if (host_pending(&next)) {
+            break;
+        }
+        uint64_t now = time_us_64();
+        uint64_t wait = next > now ? next - now : 0;
+        real_sleep(wait < HOST_IDLE_STEP_US ? wait : HOST_IDLE_STEP_US);
+    }
+    host_dispatch();
+}
+
+void __wfe(void) {
+    __wfi();
+}
+
+void __sev(void) {
+}
+
+void __dmb(void) {
+}
+
+void sleep_us(uint64_t us) {
+    uint64_t deadline = time_us_64() + us;
+    while (time_us_64() < deadline) {
+        host_dispatch();
+        uint64_t left = deadline - time_us_64();
+        if (left > 0x8000000000000000ull) {
+            break;
+        }
+        real_sleep(left < HOST_IDLE_STEP_US ? left : HOST_IDLE_STEP_US);
+    }
+    host_dispatch();
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void busy_wait_us(uint64_t us) {
+    uint64_t deadline = time_us_64() + us;
+    while (time_us_64() < deadline) {
+    }
+}
+
+void tight_loop_contents(void) {
+    host_dispatch();
+}
+
+// --- Timers ---
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    if (delay_us == 0) {
+        delay_us = 1;
+    }
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->next_us = time_us_64() + (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+    if (!out->active) {
+        out->next = timers;
+        timers = out;
+    }
+    out->active = true;
+    return true;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+    bool was = timer->active;
+    timer->active = false;
+    return was;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        host_alarm_t *a = &alarms[i];
+        if (!a->active) {
+            a->id = next_alarm_id++;
+            a->target_us = time_us_64() + us;
+            a->callback = callback;
+            a->user_data = user_data;
+            a->active = true;
+            return a->id;
+        }
+    }
+    return -1;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000u, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    for (int i = 0; i < HOST_MAX_ALARMS; i++) {
+        if (alarms[i].active && alarms[i].id == id) {
+            alarms[i].active = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Núcleo ---
+bool stdio_init_all(void) {
+    host_start();
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    return true;
+}
+
+bool stdio_usb_connected(void) {
+    return true;
+}
+
+// Sem console na simulação: a saída padrão é o log
+int getchar_timeout_us(uint32_t timeout_us) {
+    return PICO_ERROR_TIMEOUT;
+}
+
+uint get_core_num(void) {
+    return 0;
+}
+
+void critical_section_init(critical_section_t *cs) {
+    cs->saved = 0;
+}
+
+void critical_section_enter_blocking(critical_section_t *cs) {
+    cs->saved = save_and_disable_interrupts();
+}
+
+void critical_section_exit(critical_section_t *cs) {
+    restore_interrupts(cs->saved);
+}
+
+// --- GPIO ---
+void gpio_init(uint gpio) {
+    if (gpio < HOST_NUM_GPIOS) {
+        gpio_out[gpio] = false;
+    }
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < HOST_NUM_GPIOS) {
+        gpio_out[gpio] = value;
+        sx_model_gpio_put(gpio, value);
+    }
+}
+
+bool gpio_get(uint gpio) {
+    int level = sx_model_pin_level(gpio);
+    if (level >= 0) {
+        return level;
+    }
+    return gpio < HOST_NUM_GPIOS ? gpio_out[gpio] : false;
+}
+
+void gpio_set_function(uint gpio, int fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (gpio < HOST_NUM_GPIOS) {
+        gpio_out[gpio] = true;
+    }
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (gpio >= HOST_NUM_GPIOS) {
+        return;
+    }
+    if (enabled) {
+        gpio_irq_events[gpio] |= events;
+    } else {
+        gpio_irq_events[gpio] &= ~events;
+        gpio_latched[gpio] &= ~events;
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    gpio_irq_callback = callback;
+    gpio_set_irq_enabled(gpio, events, enabled);
+}
+
+// --- SPI ---
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    sx_model_spi_write(src, len);
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    (void)spi;
+    (void)repeated_tx_data;
+    sx_model_spi_read(dst, len);
+    return (int)len;
+}
@@ -0,0 +1,142 @@
+#ifndef PICO_HOST_H
+#define PICO_HOST_H
+
+// Camada de compatibilidade do Pico SDK para rodar o firmware no Linux.
+// Implementa só o que os exemplos e o driver usam: tempo, timers, GPIO com
+// interrupção, SPI e seções críticas. As "ISRs" (callbacks de GPIO e timers)
+// rodam nos pontos de espera (__wfi, sleep_*, tight_loop_contents) e ao
+// reabilitar as interrupções, nunca no meio de um trecho mascarado.
+// O SPI e os pinos do rádio vão para o modelo do SX1276 (sx1276_model.c).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+// --- Tempo ---
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t make_timeout_time_us(uint64_t us);
+bool time_reached(absolute_time_t t);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+void tight_loop_contents(void);
+
+// --- Timers ---
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+
+struct repeating_timer {
+    int64_t delay_us;           // < 0: entre inícios; > 0: após o fim do callback
+    repeating_timer_callback_t callback;
+    void *user_data;
+    uint64_t next_us;
+    bool active;
+    repeating_timer_t *next;    // Lista de timers ativos
+};
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t id);
+
+// --- Núcleo e interrupções ---
+bool stdio_init_all(void);
+bool stdio_usb_connected(void);
+#define PICO_ERROR_TIMEOUT  (-1)
+int getchar_timeout_us(uint32_t timeout_us);
+uint get_core_num(void);
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+void __wfi(void);
+void __wfe(void);
+void __sev(void);
+void __dmb(void);
+
+typedef struct {
+    uint32_t saved;
+} critical_section_t;
+
+void critical_section_init(critical_section_t *cs);
+void critical_section_enter_blocking(critical_section_t *cs);
+void critical_section_exit(critical_section_t *cs);
+
+// --- GPIO ---
+#define GPIO_IN             false
+#define GPIO_OUT            true
+#define GPIO_FUNC_SPI       1
+#define GPIO_FUNC_I2C       3
+#define GPIO_FUNC_SIO       5
+#define GPIO_IRQ_LEVEL_LOW  0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL  0x4u
+#define GPIO_IRQ_EDGE_RISE  0x8u
+#define HOST_NUM_GPIOS      30
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, int fn);
+void gpio_pull_up(uint gpio);
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+
+// --- SPI ---
+typedef struct {
+    uint baudrate;
+} spi_inst_t;
+
+extern spi_inst_t host_spi0, host_spi1;
+#define spi0 (&host_spi0)
+#define spi1 (&host_spi1)
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+// --- Interface com o modelo do rádio (sx1276_model.c) ---
+// Tempo real monotônico do sistema em us (comum a todos os processos)
+uint64_t host_real_us(void);
+// Fator de aceleração do relógio simulado (SIM_SPEEDUP)
+double host_speedup(void);
+
+void sx_model_init(void);
+void sx_model_update(void);
+// Pinos de saída do firmware (CS e RST do rádio)
+void sx_model_gpio_put(uint gpio, bool value);
+void sx_model_spi_write(const uint8_t *src, size_t len);
+void sx_model_spi_read(uint8_t *dst, size_t len);
+// Nível dos pinos DIO ligados ao modelo; -1 se o pino não é do rádio
+int sx_model_pin_level(uint gpio);
+void sx_model_report(void);
+
+#endif // PICO_HOST_H
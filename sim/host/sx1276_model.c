@@ -0,0 +1,903 @@
+// Modelo do SX1276 no nível de registradores, ligado atrás do SPI e dos GPIOs
+// do simulador. Implementa os registradores de lora.h usados pelo driver:
+// modos de operação (com a volta automática para Standby após TX, RX single
+// e CAD), FIFO com ponteiros de TX/RX, flags de IRQ, mapeamento dos DIOs,
+// RX_NB_BYTES, SNR/RSSI do pacote e erro de frequência. O tempo no ar vem de
+// SF, BW, CR e preâmbulo programados (lib/airtime.c).
+//
+// O "ar" é um arquivo compartilhado (SIM_ETHER): cada TX acrescenta um
+// registro com instante de início/fim e frequência; cada nó lê os registros
+// dos outros. Quadros sobrepostos no mesmo canal e SF colidem (erro de CRC).
+//
+// Variáveis de ambiente:
+//   SIM_ETHER            arquivo do meio compartilhado (padrão /tmp/sx1276_ether)
+//   SIM_NODE             identificador do nó (padrão: pid)
+//   SIM_RSSI_DBM         RSSI dos pacotes recebidos (padrão -80)
+//   SIM_SNR_DB           SNR dos pacotes recebidos (padrão 9)
+//   SIM_LOSS             probabilidade de perder cada pacote (padrão 0)
+//   SIM_FREQ_OFFSET_HZ   desvio do cristal deste nó (padrão 0)
+// FHSS (FhssChangeChannel) não é modelado.
+//
+// Modem FSK (LongRangeMode = 0), só no modo pacote de tamanho variável usado
+// por lib/fsk.c: página própria de registradores em 0x0D..0x3F, FIFO de 64
+// bytes que se esvazia (TX) e se enche (RX) no ritmo da taxa de bits,
+// FifoLevel/PacketSent/PayloadReady/CrcOk nos DIOs. O registro vai ao arquivo
+// no PacketSent, com o payload completo; o receptor recebe os bytes no mesmo
+// ritmo a partir de quando lê o registro (um pacote de atraso). FIFO vazia no
+// meio do TX corrompe o pacote; FIFO cheia no RX levanta FifoOverrun.
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "pico_host.h"
+#include "sx1276.h"
+#include "airtime.h"
+
+#define ETHER_MAGIC         0x58313237u
+#define ETHER_MAX_ACTIVE    64      // Registros lembrados para colisão/entrega
+#define FSTEP_HZ            (32e6 / 524288.0)
+#define CAD_SYMBOLS         2       // Duração da CAD em símbolos
+#define FSK_FIFO_SIZE       64
+#define FSK_PAGE_FIRST      0x0D    // Registradores próprios de cada modem
+#define FSK_PAGE_LAST       0x3F
+
+typedef struct {
+    uint32_t magic;
+    uint32_t node;
+    uint64_t start_us;      // Tempo real monotônico (comum aos processos)
+    uint64_t end_us;
+    int64_t freq_hz;        // Frequência transmitida (com o desvio do cristal)
+    uint8_t sf;
+    uint8_t bw;             // Código de BW de REG_MODEM_CONFIG (bits 7..4)
+    uint8_t len;
+    uint8_t implicit;       // Header implícito (sem campo de tamanho no ar)
+    uint8_t corrupt;        // FSK: FIFO vazia no meio do TX
+    uint16_t bitrate;       // FSK: REG_BITRATE_MSB/LSB (sf = 0 nos quadros FSK)
+    uint8_t payload[256];
+} ether_rec_t;
+
+typedef struct {
+    bool used;
+    bool done;              // Já entregue ou descartado por este nó
+    bool collided;
+    ether_rec_t rec;
+} ether_slot_t;
+
+typedef struct {
+    uint32_t tx_frames;
+    uint64_t tx_airtime_us;
+    uint32_t rx_frames;
+    uint32_t rx_bytes;
+    uint32_t rx_crc_errors;     // Colisões
+    uint32_t rx_missed;         // No ar no canal, mas o rádio não estava ouvindo
+    uint32_t rx_dropped;        // Perda injetada (SIM_LOSS)
+    uint32_t rx_timeouts;
+    uint32_t cads;
+    uint32_t cad_detected;
+    uint32_t reads;             // Pacotes lidos da FIFO pelo firmware
+    uint64_t irq_to_read_us;    // RxDone -> primeira leitura da FIFO
+    uint32_t irq_to_read_max_us;
+    uint64_t e2e_us;            // Início do TX -> leitura no receptor
+    uint32_t e2e_max_us;
+    uint32_t e2e_min_us;
+    uint32_t fsk_underruns;     // TX FSK com a FIFO vazia antes do fim do pacote
+    uint32_t fsk_overruns;      // RX FSK com a FIFO cheia
+} model_stats_t;
+
+static uint8_t regs[LORA_NUM_REGS];
+static uint8_t fifo[256];
+static uint8_t fsk_regs[LORA_NUM_REGS];     // Página FSK (FSK_PAGE_FIRST..FSK_PAGE_LAST)
+static uint8_t fsk_fifo[FSK_FIFO_SIZE];
+static uint8_t fsk_fifo_rd;
+static uint8_t fsk_fifo_count;
+static uint8_t fsk_flags2;          // Flags travadas de REG_IRQ_FLAGS2 (sem as de nível da FIFO)
+static bool fsk_tx_active;
+static uint64_t fsk_tx_start_real;
+static uint16_t fsk_tx_out;         // Bytes do pacote (tamanho + payload) já no ar
+static uint8_t fsk_tx_buf[256];
+static bool fsk_tx_underrun;
+static bool reset_done;
+
+static bool spi_selected;
+static bool spi_have_addr;
+static bool spi_write_mode;
+static uint8_t spi_addr;
+
+static uint64_t mode_since_real;    // Entrada no modo atual (tempo real)
+static uint64_t tx_end_real;
+static uint64_t rx_timeout_real;    // RX single: prazo para surgir um preâmbulo
+static uint64_t cad_end_real;
+
+static const char *ether_path;
+static int ether_fd = -1;
+static off_t ether_off;
+static uint32_t node_id;
+static ether_slot_t active[ETHER_MAX_ACTIVE];
+
+static int rssi_dbm = -80;
+static int snr_db = 9;
+static double loss;
+static int32_t freq_offset_hz;
+static uint32_t rng = 0x9E3779B9u;
+
+static bool pending_read;           // RxDone sinalizado e FIFO ainda não lida
+static uint64_t rx_done_real;
+static uint64_t rx_start_real;      // Início do TX do último pacote entregue
+static uint8_t rx_base_prev;        // REG_FIFO_RX_BASE_AD antes da última troca
+static uint64_t rx_base_changed_real;
+static model_stats_t stats;
+
+static const uint32_t bw_table[10] = {
+    7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
+
+static double random_unit(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) / 16777216.0;
+}
+
+static uint64_t sim_to_real(uint64_t sim_us) {
+    return (uint64_t)(sim_us / host_speedup());
+}
+
+static uint32_t real_to_sim(uint64_t real_us) {
+    return (uint32_t)(real_us * host_speedup());
+}
+
+static uint8_t op_mode(void) {
+    return regs[REG_OPMODE] & 0x07;
+}
+
+static bool lora_mode(void) {
+    return regs[REG_OPMODE] & 0x80;
+}
+
+static void set_mode_bits(uint8_t mode) {
+    regs[REG_OPMODE] = (regs[REG_OPMODE] & 0xF8) | (mode & 0x07);
+}
+
+static lora_modem_cfg_t modem_cfg(void) {
+    uint8_t bw = regs[REG_MODEM_CONFIG] >> 4;
+    lora_modem_cfg_t cfg = {
+        .sf = regs[REG_MODEM_CONFIG2] >> 4,
+        .bw_hz = bw < 10 ? bw_table[bw] : 125000,
+        .cr = (regs[REG_MODEM_CONFIG] >> 1) & 0x07,
+        .preamble = (uint16_t)((regs[REG_PREAMBLE_MSB] << 8) | regs[REG_PREAMBLE_LSB]),
+        .implicit_header = regs[REG_MODEM_CONFIG] & 0x01,
+        .crc = regs[REG_MODEM_CONFIG2] & 0x04,
+        .low_dr_opt = regs[REG_MODEM_CONFIG3] & 0x08,
+    };
+    return cfg;
+}
+
+static int64_t tuned_hz(void) {
+    uint32_t frf = ((uint32_t)regs[REG_FRF_MSB] << 16) | ((uint32_t)regs[REG_FRF_MID] << 8) | regs[REG_FRF_LSB];
+    return (int64_t)(frf * FSTEP_HZ) + freq_offset_hz;
+}
+
+// Mesmo canal e mesmos parâmetros de modulação (dentro de 1/4 da banda)
+static bool rec_matches(const ether_rec_t *r) {
+    if (r->sf == 0 || !lora_mode()) {
+        return false;
+    }
+    uint8_t bw = regs[REG_MODEM_CONFIG] >> 4;
+    int64_t df = r->freq_hz - tuned_hz();
+    uint32_t bw_hz = bw < 10 ? bw_table[bw] : 125000;
+    return r->sf == (regs[REG_MODEM_CONFIG2] >> 4) && r->bw == bw && llabs(df) < bw_hz / 4;
+}
+
+static void model_reset(void) {
+    memset(regs, 0, sizeof(regs));
+    memset(fifo, 0, sizeof(fifo));
+    memset(fsk_regs, 0, sizeof(fsk_regs));
+    fsk_fifo_count = 0;
+    fsk_flags2 = 0;
+    fsk_tx_active = false;
+    regs[REG_OPMODE] = 0x09;            // FSK, Standby (padrão do datasheet)
+    regs[REG_FRF_MSB] = 0x6C;           // 434 MHz
+    regs[REG_FRF_MID] = 0x80;
+    regs[REG_FIFO_TX_BASE_AD] = 0x80;
+    regs[REG_MODEM_CONFIG] = 0x72;
+    regs[REG_MODEM_CONFIG2] = 0x70;
+    regs[REG_SYMB_TIMEOUT_LSB] = 0x64;
+    regs[REG_PREAMBLE_LSB] = 0x08;
+    regs[REG_PAYLOAD_LENGTH] = 0x01;
+    regs[REG_DETECT_OPT] = 0xC3;
+    regs[REG_DETECTION_THRESHOLD] = 0x0A;
+    regs[REG_VERSION] = LORA_VERSION;
+    pending_read = false;
+    rx_base_prev = 0;
+    rx_base_changed_real = 0;
+    mode_since_real = host_real_us();
+}
+
+void sx_model_init(void) {
+    const char *env;
+    ether_path = (env = getenv("SIM_ETHER")) ? env : "/tmp/sx1276_ether";
+    node_id = (env = getenv("SIM_NODE")) ? (uint32_t)strtoul(env, NULL, 0) : (uint32_t)getpid();
+    if ((env = getenv("SIM_RSSI_DBM"))) {
+        rssi_dbm = atoi(env);
+    }
+    if ((env = getenv("SIM_SNR_DB"))) {
+        snr_db = atoi(env);
+    }
+    if ((env = getenv("SIM_LOSS"))) {
+        loss = atof(env);
+    }
+    if ((env = getenv("SIM_FREQ_OFFSET_HZ"))) {
+        freq_offset_hz = atoi(env);
+    }
+    rng ^= node_id * 2654435761u;
+
+    ether_fd = open(ether_path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (ether_fd < 0) {
+        perror("SIM_ETHER");
+        exit(1);
+    }
+    // Só interessa o que for transmitido a partir de agora
+    struct stat st;
+    fstat(ether_fd, &st);
+    ether_off = st.st_size - st.st_size % (off_t)sizeof(ether_rec_t);
+
+    stats.e2e_min_us = UINT32_MAX;
+    model_reset();
+}
+
+// --- Meio compartilhado ---
+static void ether_transmit(void) {
+    lora_modem_cfg_t cfg = modem_cfg();
+    ether_rec_t rec = { .magic = ETHER_MAGIC, .node = node_id };
+    rec.len = regs[REG_PAYLOAD_LENGTH];
+    uint32_t airtime = lora_airtime_us(&cfg, rec.len);
+
+    rec.start_us = host_real_us();
+    rec.end_us = rec.start_us + sim_to_real(airtime);
+    rec.freq_hz = tuned_hz();
+    rec.sf = cfg.sf;
+    rec.bw = regs[REG_MODEM_CONFIG] >> 4;
+    rec.implicit = cfg.implicit_header;
+    for (int i = 0; i < rec.len; i++) {
+        rec.payload[i] = fifo[(uint8_t)(regs[REG_FIFO_TX_BASE_AD] + i)];
+    }
+    if (write(ether_fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) {
+        perror("SIM_ETHER");
+    }
+    tx_end_real = rec.end_us;
+    stats.tx_frames++;
+    stats.tx_airtime_us += airtime;
+}
+
+static bool overlaps(const ether_rec_t *a, const ether_rec_t *b) {
+    return a->start_us < b->end_us && b->start_us < a->end_us;
+}
+
+// Lê os registros novos dos outros nós e marca as colisões entre eles
+static void ether_poll(uint64_t now) {
+    struct stat st;
+    if (fstat(ether_fd, &st) != 0) {
+        return;
+    }
+    while (ether_off + (off_t)sizeof(ether_rec_t) <= st.st_size) {
+        ether_rec_t rec;
+        if (pread(ether_fd, &rec, sizeof(rec), ether_off) != (ssize_t)sizeof(rec)) {
+            break;
+        }
+        ether_off += sizeof(rec);
+        if (rec.magic != ETHER_MAGIC || rec.node == node_id) {
+            continue;
+        }
+
+        ether_slot_t *slot = NULL;
+        for (int i = 0; i < ETHER_MAX_ACTIVE && !slot; i++) {
+            // Registros de outro canal/modem nunca são entregues: também vencem
+            if (!active[i].used || active[i].rec.end_us + 1000000u < now) {
+                slot = &active[i];
+            }
+        }
+        if (!slot) {
+            continue;
+        }
+        memset(slot, 0, sizeof(*slot));
+        slot->used = true;
+        slot->rec = rec;
+        for (int i = 0; i < ETHER_MAX_ACTIVE; i++) {
+            ether_slot_t *o = &active[i];
+            if (o != slot && o->used && o->rec.sf == rec.sf && o->rec.bw == rec.bw &&
+                llabs(o->rec.freq_hz - rec.freq_hz) < 30000 && overlaps(&o->rec, &rec)) {
+                o->collided = true;
+                slot->collided = true;
+            }
+        }
+    }
+}
+
+static void deliver(ether_slot_t *s) {
+    const ether_rec_t *r = &s->rec;
+    // Com header implícito o tamanho vem do REG_PAYLOAD_LENGTH do receptor.
+    // Modo de header diferente do transmissor, tamanho diferente ou SF6 sem a
+    // detecção ajustada: o quadro sai corrompido.
+    bool implicit = regs[REG_MODEM_CONFIG] & 0x01;
+    uint8_t len = implicit ? regs[REG_PAYLOAD_LENGTH] : r->len;
+    bool garbled = implicit != (r->implicit != 0) || len != r->len ||
+                   (r->sf == 6 && ((regs[REG_DETECT_OPT] & 0x07) != 0x05 || regs[REG_DETECTION_THRESHOLD] != 0x0C));
+    // O modem fixa a base no preâmbulo: uma troca durante o quadro só vale
+    // para o seguinte
+    uint8_t base = r->start_us < rx_base_changed_real ? rx_base_prev : regs[REG_FIFO_RX_BASE_AD];
+    for (int i = 0; i < len; i++) {
+        fifo[(uint8_t)(base + i)] = i < r->len ? r->payload[i] : 0;
+    }
+    regs[REG_FIFO_RX_CURRENT_ADDR] = base;
+    regs[REG_FIFO_RX_BYTE_ADDR] = (uint8_t)(base + len - 1);
+    regs[REG_RX_NB_BYTES] = len;
+    regs[REG_PKT_SNR_VALUE] = (uint8_t)(int8_t)(snr_db * 4);
+    regs[REG_PKT_RSSI_VALUE] = (uint8_t)(rssi_dbm + 157);
+
+    // Erro de frequência: raw = Ferr * 2^24 / Fxtal * 500 kHz / BW (20 bits)
+    uint32_t bw_hz = r->bw < 10 ? bw_table[r->bw] : 125000;
+    int64_t ferr = r->freq_hz - tuned_hz();
+    int32_t raw = (int32_t)(ferr * 32000000LL / (1LL << 24) * 500000LL / bw_hz);
+    regs[REG_FREQ_ERROR] = (uint8_t)((raw >> 16) & 0x0F);
+    regs[REG_FREQ_ERROR + 1] = (uint8_t)(raw >> 8);
+    regs[REG_FREQ_ERROR + 2] = (uint8_t)raw;
+
+    regs[REG_IRQ_FLAGS] |= IRQ_RX_DONE | IRQ_VALID_HEADER;
+    if (s->collided || garbled) {
+        regs[REG_IRQ_FLAGS] |= IRQ_PAYLOAD_CRC_ERROR;
+        stats.rx_crc_errors++;
+    } else {
+        stats.rx_frames++;
+        stats.rx_bytes += len;
+    }
+    pending_read = true;
+    rx_done_real = r->end_us;
+    rx_start_real = r->start_us;
+}
+
+// --- Modem FSK ---
+static ether_slot_t *fsk_rx_slot;   // Pacote entrando na FIFO
+static uint64_t fsk_rx_start_real;
+static uint16_t fsk_rx_in;          // Bytes do pacote (tamanho + payload) já na FIFO
+
+static uint16_t fsk_bitrate_reg(void) {
+    return (uint16_t)((regs[REG_BITRATE_MSB] << 8) | regs[REG_BITRATE_LSB]);
+}
+
+// Duração de um byte no ar, em tempo real
+static double fsk_byte_real_us(void) {
+    double bitrate = 32e6 / (fsk_bitrate_reg() + (regs[REG_BITRATE_FRAC] & 0x0F) / 16.0);
+    return 8e6 / bitrate / host_speedup();
+}
+
+// Preâmbulo e palavra de sincronismo antes do byte de tamanho
+static uint32_t fsk_header_bytes(void) {
+    uint32_t preamble = (uint32_t)((fsk_regs[REG_PREAMBLE_MSB_FSK] << 8) | fsk_regs[REG_PREAMBLE_LSB_FSK]);
+    uint32_t sync = (fsk_regs[REG_SYNC_CONFIG_FSK] & 0x10) ? (fsk_regs[REG_SYNC_CONFIG_FSK] & 0x07) + 1 : 0;
+    return preamble + sync;
+}
+
+static bool fsk_rec_matches(const ether_rec_t *r) {
+    return r->sf == 0 && r->bitrate == fsk_bitrate_reg() && llabs(r->freq_hz - tuned_hz()) < 50000;
+}
+
+static void fsk_fifo_clear(void) {
+    fsk_fifo_count = 0;
+    fsk_flags2 &= ~(IRQ2_PAYLOAD_READY | IRQ2_CRC_OK);
+}
+
+static void fsk_fifo_push(uint8_t b) {
+    if (fsk_fifo_count == FSK_FIFO_SIZE) {
+        fsk_flags2 |= IRQ2_FIFO_OVERRUN;
+        return;
+    }
+    fsk_fifo[(fsk_fifo_rd + fsk_fifo_count) % FSK_FIFO_SIZE] = b;
+    fsk_fifo_count++;
+}
+
+static uint8_t fsk_fifo_pop(void) {
+    if (fsk_fifo_count == 0) {
+        return 0;
+    }
+    uint8_t b = fsk_fifo[fsk_fifo_rd];
+    fsk_fifo_rd = (fsk_fifo_rd + 1) % FSK_FIFO_SIZE;
+    // PayloadReady e CrcOk caem com a FIFO vazia (e o RX reinicia)
+    if (--fsk_fifo_count == 0) {
+        fsk_flags2 &= ~(IRQ2_PAYLOAD_READY | IRQ2_CRC_OK);
+    }
+    return b;
+}
+
+static uint8_t fsk_irq_flags2(void) {
+    uint8_t flags = fsk_flags2;
+    if (fsk_fifo_count == FSK_FIFO_SIZE) {
+        flags |= IRQ2_FIFO_FULL;
+    }
+    if (fsk_fifo_count == 0) {
+        flags |= IRQ2_FIFO_EMPTY;
+    }
+    if (fsk_fifo_count > (fsk_regs[REG_FIFO_THRESH] & 0x3F)) {
+        flags |= IRQ2_FIFO_LEVEL;
+    }
+    return flags;
+}
+
+static void fsk_rx_abort(void) {
+    if (fsk_rx_slot) {
+        stats.rx_crc_errors++;
+        fsk_rx_slot = NULL;
+    }
+}
+
+// Fim do pacote: vai ao meio compartilhado inteiro
+static void fsk_transmit(uint64_t now, uint32_t airtime) {
+    ether_rec_t rec = { .magic = ETHER_MAGIC, .node = node_id };
+    rec.start_us = fsk_tx_start_real;
+    rec.end_us = now;
+    rec.freq_hz = tuned_hz();
+    rec.len = fsk_tx_buf[0];
+    rec.corrupt = fsk_tx_underrun;
+    rec.bitrate = fsk_bitrate_reg();
+    memcpy(rec.payload, fsk_tx_buf + 1, rec.len);
+    if (write(ether_fd, &rec, sizeof(rec)) != (ssize_t)sizeof(rec)) {
+        perror("SIM_ETHER");
+    }
+    stats.tx_frames++;
+    stats.tx_airtime_us += airtime;
+}
+
+static void fsk_update(uint64_t now) {
+    double byte_us = fsk_byte_real_us();
+    uint32_t header = fsk_header_bytes();
+
+    if (fsk_tx_active && op_mode() == FSK_MODE_TX) {
+        // Cada byte sai da FIFO no seu instante; o primeiro é o tamanho
+        while (true) {
+            uint16_t total = fsk_tx_out ? 1 + fsk_tx_buf[0] : 1;
+            if (fsk_tx_out >= total) {
+                break;
+            }
+            if (fsk_tx_start_real + (uint64_t)((header + fsk_tx_out) * byte_us) > now) {
+                break;
+            }
+            if (fsk_fifo_count == 0 && !fsk_tx_underrun) {
+                fsk_tx_underrun = true;
+                stats.fsk_underruns++;
+            }
+            fsk_tx_buf[fsk_tx_out++] = fsk_fifo_pop();
+        }
+        uint32_t bytes = header + 1 + fsk_tx_buf[0] + 2;    // + CRC
+        if (fsk_tx_out > 0 && fsk_tx_out == 1 + fsk_tx_buf[0] &&
+            now >= fsk_tx_start_real + (uint64_t)(bytes * byte_us)) {
+            fsk_tx_active = false;
+            fsk_flags2 |= IRQ2_PACKET_SENT;     // O modo segue TX até o firmware trocar
+            fsk_transmit(now, real_to_sim((uint64_t)(bytes * byte_us)));
+        }
+    }
+
+    bool rx = op_mode() == FSK_MODE_RX;
+    for (int i = 0; i < ETHER_MAX_ACTIVE; i++) {
+        ether_slot_t *s = &active[i];
+        if (!s->used || s->done || !fsk_rec_matches(&s->rec) || s == fsk_rx_slot) {
+            continue;
+        }
+        if (!rx || mode_since_real > s->rec.start_us) {
+            s->done = true;
+            stats.rx_missed++;
+        } else if (!fsk_rx_slot && !(fsk_flags2 & IRQ2_PAYLOAD_READY)) {
+            fsk_rx_slot = s;
+            fsk_rx_start_real = now;
+            fsk_rx_in = 0;
+        }
+    }
+
+    ether_slot_t *s = fsk_rx_slot;
+    if (!s) {
+        return;
+    }
+    uint16_t total = 1 + s->rec.len;
+    while (fsk_rx_in < total && fsk_rx_start_real + (uint64_t)((fsk_rx_in + 1) * byte_us) <= now) {
+        fsk_fifo_push(fsk_rx_in == 0 ? s->rec.len : s->rec.payload[fsk_rx_in - 1]);
+        fsk_rx_in++;
+        if (fsk_flags2 & IRQ2_FIFO_OVERRUN) {
+            stats.fsk_overruns++;
+            s->done = true;
+            fsk_rx_abort();
+            return;
+        }
+    }
+    if (fsk_rx_in == total && now >= fsk_rx_start_real + (uint64_t)((total + 2) * byte_us)) {
+        s->done = true;
+        fsk_rx_slot = NULL;
+        bool ok = !s->collided && !s->rec.corrupt && !(loss > 0 && random_unit() < loss);
+        fsk_flags2 |= IRQ2_PAYLOAD_READY | (ok ? IRQ2_CRC_OK : 0);
+        if (ok) {
+            stats.rx_frames++;
+            stats.rx_bytes += s->rec.len;
+        } else {
+            stats.rx_crc_errors++;
+        }
+    }
+}
+
+static void fsk_enter_mode(uint8_t mode, uint64_t now) {
+    fsk_flags2 &= ~IRQ2_PACKET_SENT;
+    fsk_tx_active = mode == FSK_MODE_TX;
+    if (fsk_tx_active) {
+        fsk_tx_start_real = now;
+        fsk_tx_out = 0;
+        fsk_tx_underrun = false;
+    }
+    if (mode != FSK_MODE_RX) {
+        fsk_rx_abort();
+    }
+    if (mode == FSK_MODE_SLEEP) {
+        fsk_fifo_clear();
+    }
+}
+
+static void fsk_reg_write(uint8_t addr, uint8_t val) {
+    switch (addr) {
+    case REG_IRQ_FLAGS2:
+        // FifoOverrun: limpa a flag e a FIFO
+        if (val & IRQ2_FIFO_OVERRUN) {
+            fsk_flags2 &= ~IRQ2_FIFO_OVERRUN;
+            fsk_fifo_clear();
+            fsk_rx_abort();
+        }
+        break;
+    case REG_RX_CONFIG_FSK:
+        if (val & 0x40) {
+            fsk_rx_abort();             // RestartRxWithoutPllLock
+        }
+        fsk_regs[addr] = val & ~0x40;
+        break;
+    case REG_RSSI_VALUE_FSK:
+    case REG_IRQ_FLAGS1_FSK:
+        break;                          // Somente leitura
+    default:
+        fsk_regs[addr] = val;
+        break;
+    }
+}
+
+static uint8_t fsk_reg_read(uint8_t addr) {
+    switch (addr) {
+    case REG_IRQ_FLAGS2:
+        return fsk_irq_flags2();
+    case REG_IRQ_FLAGS1_FSK:
+        return 0x80;                    // ModeReady
+    case REG_RSSI_VALUE_FSK:
+        return (uint8_t)(fsk_rx_slot ? -rssi_dbm * 2 : 120 * 2);
+    default:
+        return fsk_regs[addr];
+    }
+}
+
+// Avança o rádio até o instante atual: fim de TX, CAD, timeout e entregas
+void sx_model_update(void) {
+    if (ether_fd < 0) {
+        return;
+    }
+    uint64_t now = host_real_us();
+    ether_poll(now);
+    if (!lora_mode()) {
+        fsk_update(now);
+        return;
+    }
+    uint8_t mode = op_mode();
+
+    if (mode == (RF95_MODE_TX & 0x07) && now >= tx_end_real) {
+        regs[REG_IRQ_FLAGS] |= IRQ_TX_DONE;
+        set_mode_bits(RF95_MODE_STANDBY);
+    }
+
+    if (mode == (RF95_MODE_CAD & 0x07) && now >= cad_end_real) {
+        regs[REG_IRQ_FLAGS] |= IRQ_CAD_DONE;
+        stats.cads++;
+        for (int i = 0; i < ETHER_MAX_ACTIVE; i++) {
+            const ether_rec_t *r = &active[i].rec;
+            if (active[i].used && rec_matches(r) && r->start_us < cad_end_real && r->end_us > mode_since_real) {
+                regs[REG_IRQ_FLAGS] |= IRQ_CAD_DETECTED;
+                stats.cad_detected++;
+                break;
+            }
+        }
+        set_mode_bits(RF95_MODE_STANDBY);
+    }
+
+    bool rx = mode == (RF95_MODE_RX_CONTINUOUS & 0x07) || mode == (RF95_MODE_RX_SINGLE & 0x07);
+    bool single = mode == (RF95_MODE_RX_SINGLE & 0x07);
+    bool preamble_seen = false;
+
+    for (int i = 0; i < ETHER_MAX_ACTIVE; i++) {
+        ether_slot_t *s = &active[i];
+        if (!s->used || s->done || !rec_matches(&s->rec)) {
+            continue;
+        }
+        // O rádio precisa estar ouvindo desde o preâmbulo do pacote
+        bool heard = rx && mode_since_real <= s->rec.start_us;
+        if (heard && s->rec.start_us <= now) {
+            preamble_seen = true;
+        }
+        if (now < s->rec.end_us) {
+            continue;
+        }
+        s->done = true;
+        if (!heard) {
+            stats.rx_missed++;
+        } else if (loss > 0 && random_unit() < loss) {
+            stats.rx_dropped++;
+        } else {
+            deliver(s);
+            if (single) {
+                set_mode_bits(RF95_MODE_STANDBY);
+                rx = single = false;
+            }
+        }
+    }
+
+    if (single && !preamble_seen && now >= rx_timeout_real) {
+        regs[REG_IRQ_FLAGS] |= IRQ_RX_TIMEOUT;
+        stats.rx_timeouts++;
+        set_mode_bits(RF95_MODE_STANDBY);
+    }
+}
+
+static void enter_mode(uint8_t value) {
+    uint8_t old_mode = op_mode();
+    // LongRangeMode só muda em Sleep
+    if (old_mode != 0) {
+        value = (value & 0x7F) | (regs[REG_OPMODE] & 0x80);
+    }
+    regs[REG_OPMODE] = value;
+    uint8_t mode = value & 0x07;
+    if (mode == old_mode && mode != (RF95_MODE_TX & 0x07)) {
+        return;
+    }
+    uint64_t now = host_real_us();
+    mode_since_real = now;
+    if (!lora_mode()) {
+        fsk_enter_mode(mode, now);
+        return;
+    }
+
+    lora_modem_cfg_t cfg = modem_cfg();
+    uint64_t symbol_real = sim_to_real(lora_symbol_time_us(&cfg));
+    switch (mode) {
+    case RF95_MODE_TX & 0x07:
+        ether_transmit();
+        break;
+    case RF95_MODE_CAD & 0x07:
+        cad_end_real = now + CAD_SYMBOLS * symbol_real;
+        break;
+    case RF95_MODE_RX_SINGLE & 0x07: {
+        uint16_t symbols = (uint16_t)(((regs[REG_MODEM_CONFIG2] & 0x03) << 8) | regs[REG_SYMB_TIMEOUT_LSB]);
+        rx_timeout_real = now + symbols * symbol_real;
+        break;
+    }
+    case RF95_MODE_SLEEP & 0x07:
+        memset(fifo, 0, sizeof(fifo));     // A FIFO não é mantida em Sleep
+        break;
+    default:
+        break;
+    }
+}
+
+// --- Registradores ---
+static void reg_write(uint8_t addr, uint8_t val) {
+    if (!lora_mode() && addr == REG_FIFO) {
+        fsk_fifo_push(val);
+        return;
+    }
+    if (!lora_mode() && addr >= FSK_PAGE_FIRST && addr <= FSK_PAGE_LAST) {
+        fsk_reg_write(addr, val);
+        return;
+    }
+    switch (addr) {
+    case REG_FIFO:
+        fifo[regs[REG_FIFO_ADDR_PTR]++] = val;
+        break;
+    case REG_OPMODE:
+        enter_mode(val);
+        break;
+    case REG_IRQ_FLAGS:
+        regs[REG_IRQ_FLAGS] &= ~val;    // Escrever 1 limpa a flag
+        break;
+    case REG_FIFO_RX_BASE_AD:
+        if (val != regs[addr]) {
+            rx_base_prev = regs[addr];
+            rx_base_changed_real = host_real_us();
+            regs[addr] = val;
+        }
+        break;
+    case REG_FIFO_RX_CURRENT_ADDR:
+    case REG_FIFO_RX_BYTE_ADDR:
+    case REG_RX_NB_BYTES:
+    case REG_MODEM_STAT:
+    case REG_PKT_SNR_VALUE:
+    case REG_PKT_RSSI_VALUE:
+    case REG_RSSI_VALUE:
+    case REG_VERSION:
+        break;                          // Somente leitura
+    default:
+        if (addr < LORA_NUM_REGS) {
+            regs[addr] = val;
+        }
+        break;
+    }
+}
+
+// Quadro ouvido desde o preâmbulo e ainda no ar: sinal, sincronismo e header
+static uint8_t modem_stat(void) {
+    uint8_t mode = op_mode();
+    if (mode != (RF95_MODE_RX_CONTINUOUS & 0x07) && mode != (RF95_MODE_RX_SINGLE & 0x07)) {
+        return 0;
+    }
+    uint64_t now = host_real_us();
+    ether_poll(now);
+    for (int i = 0; i < ETHER_MAX_ACTIVE; i++) {
+        const ether_slot_t *s = &active[i];
+        if (s->used && !s->done && rec_matches(&s->rec) && mode_since_real <= s->rec.start_us &&
+            s->rec.start_us <= now && now < s->rec.end_us) {
+            return MODEM_STAT_SIGNAL_DETECTED | MODEM_STAT_SYNCHRONIZED | MODEM_STAT_HEADER_VALID |
+                   MODEM_STAT_RX_ONGOING;
+        }
+    }
+    return 0;
+}
+
+static uint8_t reg_read(uint8_t addr) {
+    if (!lora_mode() && addr == REG_FIFO) {
+        return fsk_fifo_pop();
+    }
+    if (!lora_mode() && addr >= FSK_PAGE_FIRST && addr <= FSK_PAGE_LAST) {
+        return fsk_reg_read(addr);
+    }
+    if (addr == REG_FIFO) {
+        if (pending_read) {
+            uint64_t now = host_real_us();
+            uint32_t irq_lat = real_to_sim(now - rx_done_real);
+            uint32_t e2e = real_to_sim(now - rx_start_real);
+            pending_read = false;
+            stats.reads++;
+            stats.irq_to_read_us += irq_lat;
+            stats.e2e_us += e2e;
+            if (irq_lat > stats.irq_to_read_max_us) {
+                stats.irq_to_read_max_us = irq_lat;
+            }
+            if (e2e > stats.e2e_max_us) {
+                stats.e2e_max_us = e2e;
+            }
+            if (e2e < stats.e2e_min_us) {
+                stats.e2e_min_us = e2e;
+            }
+        }
+        return fifo[regs[REG_FIFO_ADDR_PTR]++];
+    }
+    if (addr == REG_RSSI_VALUE) {
+        return (uint8_t)(-120 + 157);   // Piso de ruído
+    }
+    if (addr == REG_MODEM_STAT) {
+        return modem_stat();
+    }
+    return addr < LORA_NUM_REGS ? regs[addr] : 0;
+}
+
+// --- SPI e pinos ---
+void sx_model_gpio_put(uint gpio, bool value) {
+    if (gpio == LORA_PIN_CS) {
+        spi_selected = !value;
+        spi_have_addr = false;
+        if (spi_selected) {
+            sx_model_update();
+        }
+    } else if (gpio == LORA_PIN_RST) {
+        if (!value) {
+            reset_done = false;
+        } else if (!reset_done) {
+            reset_done = true;
+            model_reset();
+        }
+    }
+}
+
+// Primeiro byte: endereço (bit 7 = escrita); os seguintes acessam registradores
+// consecutivos, exceto a FIFO, que fica no mesmo endereço
+static void spi_byte_addr(uint8_t b) {
+    spi_addr = b & 0x7F;
+    spi_write_mode = b & 0x80;
+    spi_have_addr = true;
+}
+
+void sx_model_spi_write(const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!spi_selected) {
+            continue;
+        }
+        if (!spi_have_addr) {
+            spi_byte_addr(src[i]);
+            continue;
+        }
+        if (spi_write_mode) {
+            reg_write(spi_addr, src[i]);
+            if (spi_addr != REG_FIFO) {
+                spi_addr++;
+            }
+        }
+    }
+}
+
+void sx_model_spi_read(uint8_t *dst, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = 0;
+        if (!spi_selected || !spi_have_addr || spi_write_mode) {
+            continue;
+        }
+        dst[i] = reg_read(spi_addr);
+        if (spi_addr != REG_FIFO) {
+            spi_addr++;
+        }
+    }
+}
+
+int sx_model_pin_level(uint gpio) {
+    if (!lora_mode() && (gpio == LORA_PIN_DIO0 || gpio == LORA_PIN_DIO1)) {
+        // Mapeamento 00 do modo pacote: PacketSent/PayloadReady e FifoLevel
+        uint8_t map = regs[REG_DIO_MAPPING_1];
+        uint8_t flags = fsk_irq_flags2();
+        if (gpio == LORA_PIN_DIO0) {
+            return (map & DIO0_MASK) == 0 && (flags & (IRQ2_PACKET_SENT | IRQ2_PAYLOAD_READY)) != 0;
+        }
+        return (map & DIO1_MASK) == 0 && (flags & IRQ2_FIFO_LEVEL) != 0;
+    }
+    uint8_t flags = regs[REG_IRQ_FLAGS] & ~regs[REG_IRQ_FLAGS_MASK];
+    uint8_t map = regs[REG_DIO_MAPPING_1];
+    if (gpio == LORA_PIN_DIO0) {
+        switch (map & DIO0_MASK) {
+        case DIO0_RX_DONE:  return (flags & IRQ_RX_DONE) != 0;
+        case DIO0_TX_DONE:  return (flags & IRQ_TX_DONE) != 0;
+        case DIO0_CAD_DONE: return (flags & IRQ_CAD_DONE) != 0;
+        default:            return 0;
+        }
+    }
+    if (gpio == LORA_PIN_DIO1) {
+        switch (map & DIO1_MASK) {
+        case DIO1_RX_TIMEOUT:           return (flags & IRQ_RX_TIMEOUT) != 0;
+        case DIO1_FHSS_CHANGE_CHANNEL:  return (flags & IRQ_FHSS_CHANGE_CHANNEL) != 0;
+        case DIO1_CAD_DETECTED:         return (flags & IRQ_CAD_DETECTED) != 0;
+        default:                        return 0;
+        }
+    }
+    return -1;
+}
+
+void sx_model_report(void) {
+    uint64_t elapsed = time_us_64();
+    printf("[sim] no %lu: %lu us simulados\n", (unsigned long)node_id, (unsigned long)elapsed);
+    printf("[sim] TX: %lu quadros, %lu us no ar (%.2f%% do tempo)\n",
+           (unsigned long)stats.tx_frames, (unsigned long)stats.tx_airtime_us,
+           elapsed ? 100.0 * stats.tx_airtime_us / elapsed : 0.0);
+    printf("[sim] RX: %lu quadros (%lu bytes, %.0f bit/s), %lu colisoes, %lu perdidos sem escuta, "
+           "%lu perdas injetadas, %lu timeouts\n",
+           (unsigned long)stats.rx_frames, (unsigned long)stats.rx_bytes,
+           elapsed ? stats.rx_bytes * 8e6 / elapsed : 0.0, (unsigned long)stats.rx_crc_errors,
+           (unsigned long)stats.rx_missed, (unsigned long)stats.rx_dropped, (unsigned long)stats.rx_timeouts);
+    if (stats.fsk_underruns || stats.fsk_overruns) {
+        printf("[sim] FSK: %lu TX com a FIFO vazia, %lu RX com a FIFO cheia\n",
+               (unsigned long)stats.fsk_underruns, (unsigned long)stats.fsk_overruns);
+    }
+    if (stats.cads) {
+        printf("[sim] CAD: %lu, %lu com preambulo\n", (unsigned long)stats.cads, (unsigned long)stats.cad_detected);
+    }
+    if (stats.reads) {
+        printf("[sim] Latencia RxDone->FIFO: media %lu us, max %lu us\n",
+               (unsigned long)(stats.irq_to_read_us / stats.reads), (unsigned long)stats.irq_to_read_max_us);
+        printf("[sim] Latencia inicio do TX->leitura: min %lu us, media %lu us, max %lu us\n",
+               (unsigned long)stats.e2e_min_us, (unsigned long)(stats.e2e_us / stats.reads),
+               (unsigned long)stats.e2e_max_us);
+    }
+}
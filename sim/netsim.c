@@ -0,0 +1,984 @@
+// Simulador de eventos discretos da rede: N estações virtuais rodando a
+// lógica de transmissão da estação (política por exceção de lib/tx_policy,
+// ARQ de lib/arq e escuta antes de transmitir como em lib/radio_core) contra
+// um ou mais receptores num canal compartilhado. Responde quantas estações um
+// receptor aguenta com um dado SF e taxa de relatórios.
+//
+// Modelo do canal:
+//   - Perda de percurso log-distância com sombreamento log-normal fixo por enlace
+//   - Sensibilidade por SF (datasheet do SX1276, 125 kHz)
+//   - Quadros sobrepostos: o quadro sobrevive se a potência dele supera a de
+//     cada interferente pela rejeição da tabela SF x SF (ortogonalidade
+//     imperfeita entre SFs; NETSIM_CAPTURE_DB no mesmo SF)
+//   - Cada receptor tem um número fixo de demoduladores (1 = SX1276 do rx.c);
+//     com todos ocupados, um quadro do mesmo SF ainda captura o demodulador
+//     se chegar durante o preâmbulo do atual com NETSIM_CAPTURE_DB a mais
+//   - O receptor é half-duplex: enquanto transmite um ACK perde o que recebia
+//
+// Com -m 1 as estações usam o MAC TDMA de lib/tdma no lugar de ALOHA com LBT:
+// o receptor transmite beacons com o mapa de slots e cada estação só
+// transmite no seu slot (sem LBT), sincronizada pelo último beacon ouvido.
+//
+// Compilação e uso (na raiz do projeto):
+//   gcc -O2 -Ilib sim/netsim.c lib/arq.c lib/airtime.c lib/tx_policy.c lib/tdma.c lib/downlink.c -lm -o netsim
+//   ./netsim -n 200 -s 7 -b 60 -t 1
+// Opções: -n estações, -g receptores, -s SF (0: o menor SF com margem no
+// enlace, como um ADR, e receptores multi-SF), -d demoduladores por receptor,
+// -r raio da área (m), -b heartbeat (s), -e período de avaliação da política
+// (s), -t dias simulados, -w janela do ARQ, -l 0 desliga a LBT, -m 1 usa o
+// TDMA (um receptor, SF fixo), -x semente, -c imprime uma linha CSV para
+// varreduras: estações, receptores, SF, demoduladores, heartbeat, dias,
+// relatórios, entregues, % entregue, latência p50/p90/p99 (ms), ocupação do
+// canal pelas estações (%), uso útil do canal (%, quadros recebidos), maior
+// duty cycle (%) e MAC (0: ALOHA, 1: TDMA).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "arq.h"
+#include "airtime.h"
+#include "tx_policy.h"
+#include "tdma.h"
+#include "downlink.h"
+
+// Modelo de propagação
+#define NETSIM_TX_DBM           20      // PA_BOOST no máximo (sx1276.c)
+#define NETSIM_PL_D0_M          1000.0  // Distância de referência
+#define NETSIM_PL_D0_DB         120.0   // Perda a 1 km
+#define NETSIM_PL_EXPONENT      2.7     // Suburbano
+#define NETSIM_SHADOW_DB        6.0     // Desvio padrão do sombreamento
+#define NETSIM_CAPTURE_DB       6.0     // Relação mínima no mesmo SF
+#define NETSIM_ADR_MARGIN_DB    10.0    // Margem exigida na escolha do SF (-s 0)
+#define NETSIM_MAX_DEMODS       8
+
+// Estação (mesmos valores de estacao_meteriologica.c e radio_core.h)
+#define RADIO_PERIOD_US         250000  // Um quadro por execução da tarefa de rádio
+#define ARQ_RETRIES_ALARM       6
+#define ARQ_RETRIES_NORMAL      1
+#define RADIO_LBT_MAX_ATTEMPTS  5
+#define RADIO_LBT_SLOT_US       5000
+#define REPORT_LEN              27      // "T=25.3;U=71.0;P=101.3;R=04"
+#define PREAMBLE_LEN            8
+#define TDMA_QUEUE_LEAD_US      5000    // Quadro entregue ao rádio antes do slot
+
+#define US_PER_S                1000000ULL
+#define US_PER_DAY              (86400ULL * US_PER_S)
+
+// Sensibilidade (dBm) por SF, de SF6 a SF12
+static const float sensitivity_dbm[7] = { -118, -123, -126, -129, -132, -133, -136 };
+
+// Relação de sinal mínima (dB) do quadro desejado (linha, SF7..SF12) sobre um
+// interferente (coluna). Fora da diagonal: ortogonalidade imperfeita entre SFs
+// (Croce et al., 2018); na diagonal entra NETSIM_CAPTURE_DB.
+static const float sir_threshold_db[6][6] = {
+    {   0,  -8,  -9,  -9,  -9,  -9 },
+    { -11,   0, -11, -12, -13, -13 },
+    { -15, -13,   0, -13, -14, -15 },
+    { -19, -18, -17,   0, -17, -18 },
+    { -22, -22, -21, -20,   0, -20 },
+    { -25, -25, -25, -24, -23,   0 },
+};
+
+typedef enum {
+    EV_SAMPLE = 0,      // Avaliação da política (leitura dos sensores)
+    EV_TICK,            // Próxima execução da tarefa de rádio com quadros pendentes
+    EV_WAKE,            // Fim da janela de ACK ou do recuo da LBT
+    EV_TX_END,          // Fim de um quadro no ar
+    EV_ACK_START,       // Receptor começa o ACK
+    EV_BEACON           // Receptor começa o beacon do próximo ciclo (TDMA)
+} event_type_t;
+
+typedef struct {
+    uint64_t t;
+    uint32_t order;     // Desempate: ordem de inserção
+    uint8_t type;
+    uint32_t a, b;
+} event_t;
+
+typedef struct {
+    bool is_ack;
+    bool is_beacon;
+    uint16_t src;           // Posição de origem (estações primeiro, depois receptores)
+    uint16_t dst;           // ACK: estação de destino
+    uint8_t sf;
+    uint64_t start_us;
+    uint64_t end_us;
+    uint64_t preamble_end_us;
+    uint16_t seq;           // Dados: sequência do ARQ
+    bool syn;               // Dados: LINK_FLAG_SYN (remetente sem ACK desde o boot)
+    uint64_t created_us;    // Dados: instante em que o relatório foi gerado
+    bool heard, busy, captured, collided, half_duplex;
+    float dst_dbm;          // ACK: potência na estação de destino
+    bool dst_lost;          // ACK: abaixo da sensibilidade ou com interferência
+} air_frame_t;
+
+typedef struct {
+    int frame;
+    float dbm;
+    uint8_t sf;
+    uint8_t lost;           // 0: ok, 1: interferência, 2: receptor transmitindo
+} rx_lock_t;
+
+typedef struct {
+    double x, y;
+    uint8_t sf;             // 0: escuta todos os SFs
+    rx_lock_t locks[NETSIM_MAX_DEMODS];
+    uint8_t nlocks;
+    uint64_t tx_until;
+    uint64_t airtime_us;
+} receiver_t;
+
+typedef enum {
+    NODE_IDLE = 0,
+    NODE_BACKOFF,
+    NODE_TX,
+    NODE_ACK_WAIT,
+    NODE_SLOT_WAIT          // Quadro entregue ao rádio, esperando o slot (TDMA)
+} node_state_t;
+
+typedef struct {
+    double x, y;
+    uint8_t sf;
+    lora_modem_cfg_t modem;
+    tx_policy_t policy;
+    arq_tx_t arq;
+    arq_rx_t net_rx;        // Lado da rede: duplicados entre receptores e ACK
+    // Sensores: base + ciclo diário + passeios aleatórios
+    float temp_base, phase, walk_temp, walk_hum, walk_press;
+    node_state_t state;
+    uint64_t wait_until;
+    bool tick_pending;
+    bool has_frame;         // Quadro tirado do ARQ esperando a LBT
+    uint16_t frame_seq;
+    bool frame_syn;
+    uint8_t frame_len;
+    uint64_t frame_created;
+    uint8_t lbt_attempts;
+    uint64_t airtime_us;
+    tdma_node_t tdma;
+    uint64_t slot_busy_until;   // Fim da troca no slot atual (um quadro por ciclo)
+} node_t;
+
+typedef struct {
+    uint64_t reports, dropped_full, delivered;
+    uint64_t ok_air_us;         // Tempo no ar dos quadros recebidos (uso útil do canal)
+    uint64_t frames, frames_ok, weak, busy, captured, collided, half_duplex;
+    uint64_t acks, acks_gw_busy, acks_lost, acks_ok;
+    uint64_t lbt_busy, lbt_forced;
+    uint64_t beacons, beacon_rx;
+} netsim_stats_t;
+
+// Parâmetros
+static int num_nodes = 100;
+static int num_receivers = 1;
+static int fixed_sf = 7;
+static int demods = 1;
+static double radius_m = 3000;
+static uint32_t heartbeat_s = 60;
+static double eval_period_s = 5;
+static double days = 1;
+static int window = 4;
+static bool lbt = true;
+static bool tdma = false;
+static uint64_t seed = 1;
+static bool csv = false;
+
+static node_t *nodes;
+static receiver_t *receivers;
+static float *node_rx_dbm;          // [estação * num_receivers + receptor]
+static air_frame_t *frames;
+static int *free_frames, num_free;
+static int *on_air, num_on_air;
+static event_t *heap;
+static size_t heap_len, heap_cap;
+static uint32_t event_order;
+static uint64_t *latencies_us;
+static size_t num_latencies, cap_latencies;
+static netsim_stats_t stats;
+static tdma_gw_t gw_tdma;
+static uint8_t beacon_payload[TDMA_BEACON_MAX_LEN];
+static size_t beacon_len;
+static bool *beacon_lost;           // [estação]: interferência durante o beacon no ar
+
+// --- Aleatoriedade ---
+static uint64_t rng_state;
+
+static double random_unit(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return ((rng_state * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+static double random_gauss(void) {
+    double u = random_unit();
+    double v = random_unit();
+    return sqrt(-2.0 * log(u + 1e-300)) * cos(2.0 * M_PI * v);
+}
+
+// Sombreamento fixo e simétrico por par de posições, sem tabela N x N
+static double shadowing_db(uint32_t a, uint32_t b) {
+    uint64_t h = ((uint64_t)(a < b ? a : b) << 32 | (a < b ? b : a)) ^ (seed * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    double u = ((h >> 11) + 1) / 9007199254740993.0;
+    double v = (h & 0xFFFFF) / 1048576.0;
+    return NETSIM_SHADOW_DB * sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+// --- Propagação ---
+static void position(int p, double *x, double *y) {
+    if (p < num_nodes) {
+        *x = nodes[p].x;
+        *y = nodes[p].y;
+    } else {
+        *x = receivers[p - num_nodes].x;
+        *y = receivers[p - num_nodes].y;
+    }
+}
+
+static float compute_dbm(int a, int b) {
+    double ax, ay, bx, by;
+    position(a, &ax, &ay);
+    position(b, &bx, &by);
+    double d = hypot(ax - bx, ay - by);
+    if (d < 1.0) {
+        d = 1.0;
+    }
+    double loss = NETSIM_PL_D0_DB + 10.0 * NETSIM_PL_EXPONENT * log10(d / NETSIM_PL_D0_M);
+    return (float)(NETSIM_TX_DBM - loss - shadowing_db((uint32_t)a, (uint32_t)b));
+}
+
+// Potência recebida em b de uma transmissão de a (estação-receptor em cache)
+static float link_dbm(int a, int b) {
+    if (a < num_nodes && b >= num_nodes) {
+        return node_rx_dbm[a * num_receivers + (b - num_nodes)];
+    }
+    if (b < num_nodes && a >= num_nodes) {
+        return node_rx_dbm[b * num_receivers + (a - num_nodes)];
+    }
+    return compute_dbm(a, b);
+}
+
+static float sensitivity(uint8_t sf) {
+    return sensitivity_dbm[sf - 6];
+}
+
+// true se o interferente (sf_i, dbm_i) destrói o quadro desejado (sf_d, dbm_d)
+static bool interferes(uint8_t sf_d, float dbm_d, uint8_t sf_i, float dbm_i) {
+    float threshold = sf_d == sf_i ? NETSIM_CAPTURE_DB
+                                   : sir_threshold_db[(sf_d < 7 ? 7 : sf_d) - 7][(sf_i < 7 ? 7 : sf_i) - 7];
+    return dbm_d - dbm_i < threshold;
+}
+
+// --- Fila de eventos (heap binário por instante) ---
+static bool event_before(const event_t *x, const event_t *y) {
+    return x->t < y->t || (x->t == y->t && x->order < y->order);
+}
+
+static void schedule(uint64_t t, event_type_t type, uint32_t a, uint32_t b) {
+    if (heap_len == heap_cap) {
+        heap_cap = heap_cap ? heap_cap * 2 : 1024;
+        heap = realloc(heap, heap_cap * sizeof(event_t));
+    }
+    size_t i = heap_len++;
+    event_t ev = { .t = t, .order = event_order++, .type = (uint8_t)type, .a = a, .b = b };
+    while (i > 0 && event_before(&ev, &heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = ev;
+}
+
+static event_t next_event(void) {
+    event_t top = heap[0];
+    event_t last = heap[--heap_len];
+    size_t i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= heap_len) {
+            break;
+        }
+        if (c + 1 < heap_len && event_before(&heap[c + 1], &heap[c])) {
+            c++;
+        }
+        if (!event_before(&heap[c], &last)) {
+            break;
+        }
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = last;
+    return top;
+}
+
+// --- Quadros no ar ---
+static int frame_alloc(void) {
+    return free_frames[--num_free];
+}
+
+static void frame_off_air(int fi) {
+    for (int i = 0; i < num_on_air; i++) {
+        if (on_air[i] == fi) {
+            on_air[i] = on_air[--num_on_air];
+            break;
+        }
+    }
+    free_frames[num_free++] = fi;
+}
+
+// Interferência de um quadro que começa sobre as recepções em andamento
+static void frame_interfere(int fi) {
+    const air_frame_t *f = &frames[fi];
+    for (int g = 0; g < num_receivers; g++) {
+        if (f->src == num_nodes + g) {
+            continue;
+        }
+        receiver_t *r = &receivers[g];
+        float dbm = link_dbm(f->src, num_nodes + g);
+        for (int k = 0; k < r->nlocks; k++) {
+            rx_lock_t *l = &r->locks[k];
+            if (l->lost == 0 && interferes(l->sf, l->dbm, f->sf, dbm)) {
+                l->lost = 1;
+            }
+        }
+    }
+    for (int i = 0; i < num_on_air; i++) {
+        air_frame_t *a = &frames[on_air[i]];
+        if (a->is_ack && !a->dst_lost && a->dst != f->src &&
+            interferes(a->sf, a->dst_dbm, f->sf, link_dbm(f->src, a->dst))) {
+            a->dst_lost = true;
+        }
+        if (a->is_beacon) {
+            for (int n = 0; n < num_nodes; n++) {
+                if (!beacon_lost[n] && (n == f->src || interferes(a->sf, link_dbm(a->src, n), f->sf, link_dbm(f->src, n)))) {
+                    beacon_lost[n] = true;
+                }
+            }
+        }
+    }
+}
+
+// true se algum quadro já no ar impede a recepção de (sf, dbm) na posição p
+static bool corrupted_by_on_air(int p, uint8_t sf, float dbm) {
+    for (int i = 0; i < num_on_air; i++) {
+        const air_frame_t *a = &frames[on_air[i]];
+        if (a->src != p && interferes(sf, dbm, a->sf, link_dbm(a->src, p))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Um receptor tenta sincronizar com um quadro de dados que começa
+static void receiver_try_lock(int g, int fi, uint64_t now) {
+    receiver_t *r = &receivers[g];
+    air_frame_t *f = &frames[fi];
+    float dbm = link_dbm(f->src, num_nodes + g);
+    if ((r->sf != 0 && r->sf != f->sf) || dbm < sensitivity(f->sf)) {
+        return;
+    }
+    f->heard = true;
+    if (r->tx_until > now) {
+        f->half_duplex = true;
+        return;
+    }
+
+    rx_lock_t *slot = NULL;
+    if (r->nlocks < demods) {
+        slot = &r->locks[r->nlocks++];
+    } else {
+        // Captura: o mais fraco ainda no preâmbulo, do mesmo SF
+        for (int k = 0; k < r->nlocks; k++) {
+            rx_lock_t *l = &r->locks[k];
+            if (l->sf == f->sf && now < frames[l->frame].preamble_end_us &&
+                dbm >= l->dbm + NETSIM_CAPTURE_DB && (!slot || l->dbm < slot->dbm)) {
+                slot = l;
+            }
+        }
+        if (!slot) {
+            f->busy = true;
+            return;
+        }
+        frames[slot->frame].captured = true;
+    }
+    slot->frame = fi;
+    slot->dbm = dbm;
+    slot->sf = f->sf;
+    slot->lost = corrupted_by_on_air(num_nodes + g, f->sf, dbm) ? 1 : 0;
+}
+
+static void node_start_tx(node_t *n, uint64_t now) {
+    int fi = frame_alloc();
+    air_frame_t *f = &frames[fi];
+    memset(f, 0, sizeof(*f));
+    f->src = (uint16_t)(n - nodes);
+    f->sf = n->sf;
+    f->start_us = now;
+    f->end_us = now + lora_airtime_us(&n->modem, ARQ_HEADER_LEN + n->frame_len);
+    f->preamble_end_us = now + (PREAMBLE_LEN + 4) * (uint64_t)lora_symbol_time_us(&n->modem);
+    f->seq = n->frame_seq;
+    f->syn = n->frame_syn;
+    f->created_us = n->frame_created;
+
+    frame_interfere(fi);
+    for (int g = 0; g < num_receivers; g++) {
+        receiver_try_lock(g, fi, now);
+    }
+    on_air[num_on_air++] = fi;
+
+    n->state = NODE_TX;
+    n->has_frame = false;
+    n->airtime_us += f->end_us - now;
+    stats.frames++;
+    schedule(f->end_us, EV_TX_END, (uint32_t)fi, 0);
+}
+
+// CAD: preâmbulo de um quadro do mesmo SF acima da sensibilidade
+static bool channel_busy(const node_t *n) {
+    int p = (int)(n - nodes);
+    for (int i = 0; i < num_on_air; i++) {
+        const air_frame_t *a = &frames[on_air[i]];
+        if (a->sf == n->sf && link_dbm(a->src, p) >= sensitivity(n->sf)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void schedule_tick(node_t *n, uint64_t now) {
+    if (!n->tick_pending) {
+        n->tick_pending = true;
+        schedule(now + RADIO_PERIOD_US, EV_TICK, (uint32_t)(n - nodes), 0);
+    }
+}
+
+// Uma execução da tarefa de rádio: próximo quadro do ARQ, LBT e TX
+// TDMA: um quadro por ciclo, entregue ao rádio para o próximo slot da estação
+static void node_try_send_slot(node_t *n, uint64_t now) {
+    uint32_t slot;
+    if (now < n->slot_busy_until ||
+        !tdma_node_next_slot(&n->tdma, (uint32_t)now, TDMA_QUEUE_LEAD_US, &slot)) {
+        // Sem sincronismo espera o próximo beacon; com o slot ocupado, o fim da troca
+        if (n->tdma.synced && arq_tx_pending(&n->arq) > 0) {
+            schedule_tick(n, now);
+        }
+        return;
+    }
+    uint16_t seq;
+    bool retry;
+    const uint8_t *data;
+    int len = arq_tx_poll(&n->arq, (uint32_t)now, &seq, &retry, &data, NULL);
+    if (len < 0) {
+        if (arq_tx_pending(&n->arq) > 0) {
+            schedule_tick(n, now);
+        }
+        return;
+    }
+    n->frame_seq = seq;
+    n->frame_syn = arq_tx_syn(&n->arq);
+    n->frame_len = (uint8_t)len;
+    memcpy(&n->frame_created, data, sizeof(n->frame_created));
+    n->state = NODE_SLOT_WAIT;
+    n->wait_until = now + (uint32_t)(slot - (uint32_t)now);
+    n->slot_busy_until = n->wait_until + n->tdma.map.slot_us;
+    schedule(n->wait_until, EV_WAKE, (uint32_t)(n - nodes), 0);
+}
+
+static void node_try_send(node_t *n, uint64_t now) {
+    if (n->state != NODE_IDLE) {
+        return;
+    }
+    if (tdma) {
+        node_try_send_slot(n, now);
+        return;
+    }
+    if (!n->has_frame) {
+        uint16_t seq;
+        bool retry;
+        const uint8_t *data;
+        int len = arq_tx_poll(&n->arq, (uint32_t)now, &seq, &retry, &data, NULL);
+        if (len < 0) {
+            if (arq_tx_pending(&n->arq) > 0) {
+                schedule_tick(n, now);
+            }
+            return;
+        }
+        n->has_frame = true;
+        n->frame_seq = seq;
+        n->frame_syn = arq_tx_syn(&n->arq);
+        n->frame_len = (uint8_t)len;
+        memcpy(&n->frame_created, data, sizeof(n->frame_created));
+        n->lbt_attempts = 0;
+    }
+
+    if (lbt && channel_busy(n)) {
+        stats.lbt_busy++;
+        if (++n->lbt_attempts < RADIO_LBT_MAX_ATTEMPTS) {
+            uint32_t slots = (uint32_t)(random_unit() * (2u << n->lbt_attempts)) + 1;
+            n->state = NODE_BACKOFF;
+            n->wait_until = now + slots * RADIO_LBT_SLOT_US;
+            schedule(n->wait_until, EV_WAKE, (uint32_t)(n - nodes), 0);
+            return;
+        }
+        stats.lbt_forced++;
+    }
+    node_start_tx(n, now);
+}
+
+static void sample_sensors(node_t *n, uint64_t now, float *values) {
+    double dt = eval_period_s;
+    double day = (double)now / US_PER_DAY;
+    n->walk_temp += (float)(-n->walk_temp * dt / 1800 + 0.5 * sqrt(2 * dt / 1800) * random_gauss());
+    n->walk_hum += (float)(-n->walk_hum * dt / 3600 + 2.0 * sqrt(2 * dt / 3600) * random_gauss());
+    n->walk_press += (float)(-n->walk_press * dt / 21600 + 0.3 * sqrt(2 * dt / 21600) * random_gauss());
+    float cycle = (float)(5.0 * sin(2 * M_PI * day + n->phase));
+    values[0] = n->temp_base + cycle + n->walk_temp;
+    values[1] = 75.0f - 2.0f * cycle + n->walk_hum;
+    values[2] = 101.3f + n->walk_press;
+}
+
+static void on_sample(node_t *n, uint64_t now) {
+    float values[3];
+    sample_sensors(n, now, values);
+    uint32_t now_ms = (uint32_t)(now / 1000);
+    uint8_t reasons = tx_policy_evaluate(&n->policy, values, now_ms);
+    if (reasons) {
+        uint8_t report[REPORT_LEN];
+        memset(report, 0, sizeof(report));
+        memcpy(report, &now, sizeof(now));
+        uint8_t retries = (reasons & TX_REASON_ALARM) ? ARQ_RETRIES_ALARM : ARQ_RETRIES_NORMAL;
+        if (arq_tx_submit(&n->arq, report, sizeof(report), retries, 0)) {
+            tx_policy_mark_sent(&n->policy, values, reasons, now_ms);
+            stats.reports++;
+        } else {
+            // Como na estação: a política volta a pedir na próxima avaliação
+            stats.dropped_full++;
+        }
+    }
+    node_try_send(n, now);
+    schedule(now + (uint64_t)(eval_period_s * US_PER_S), EV_SAMPLE, (uint32_t)(n - nodes), 0);
+}
+
+static void record_latency(uint64_t us) {
+    if (num_latencies == cap_latencies) {
+        cap_latencies = cap_latencies ? cap_latencies * 2 : 65536;
+        latencies_us = realloc(latencies_us, cap_latencies * sizeof(uint64_t));
+    }
+    latencies_us[num_latencies++] = us;
+}
+
+static void on_data_end(int fi, uint64_t now) {
+    air_frame_t *f = &frames[fi];
+    node_t *n = &nodes[f->src];
+    int best = -1;
+    float best_dbm = -1e9f;
+
+    for (int g = 0; g < num_receivers; g++) {
+        receiver_t *r = &receivers[g];
+        for (int k = 0; k < r->nlocks; k++) {
+            if (r->locks[k].frame != fi) {
+                continue;
+            }
+            rx_lock_t l = r->locks[k];
+            r->locks[k] = r->locks[--r->nlocks];
+            if (l.lost == 0 && l.dbm > best_dbm) {
+                best = g;
+                best_dbm = l.dbm;
+            } else if (l.lost == 1) {
+                f->collided = true;
+            } else if (l.lost == 2) {
+                f->half_duplex = true;
+            }
+            break;
+        }
+    }
+
+    if (best >= 0) {
+        stats.frames_ok++;
+        stats.ok_air_us += f->end_us - f->start_us;
+    } else if (f->collided) {
+        stats.collided++;
+    } else if (f->half_duplex) {
+        stats.half_duplex++;
+    } else if (f->captured) {
+        stats.captured++;
+    } else if (f->busy) {
+        stats.busy++;
+    } else {
+        stats.weak++;
+    }
+
+    n->state = NODE_ACK_WAIT;
+    n->wait_until = now + arq_ack_slot_us(&n->modem) + downlink_window_extra_us(&n->modem);
+    schedule(n->wait_until, EV_WAKE, (uint32_t)f->src, 0);
+
+    if (best >= 0) {
+        // A rede descarta duplicados de qualquer receptor; o de melhor sinal confirma
+        if (tdma) {
+            tdma_gw_on_frame(&gw_tdma, (uint8_t)(f->src + 1));
+        }
+        if (arq_rx_on_frame(&n->net_rx, f->seq, f->syn)) {
+            stats.delivered++;
+            record_latency(now - f->created_us);
+        }
+        schedule(now + ARQ_TURNAROUND_US, EV_ACK_START, (uint32_t)best, f->src);
+    }
+    frame_off_air(fi);
+}
+
+static void on_ack_start(int g, int node, uint64_t now) {
+    receiver_t *r = &receivers[g];
+    node_t *n = &nodes[node];
+    if (r->tx_until > now) {
+        stats.acks_gw_busy++;
+        return;
+    }
+    int fi = frame_alloc();
+    air_frame_t *f = &frames[fi];
+    memset(f, 0, sizeof(*f));
+    f->is_ack = true;
+    f->src = (uint16_t)(num_nodes + g);
+    f->dst = (uint16_t)node;
+    f->sf = n->sf;
+    f->start_us = now;
+    f->end_us = now + lora_airtime_us(&n->modem, ARQ_ACK_FRAME_LEN);
+    f->dst_dbm = link_dbm(f->src, node);
+    f->dst_lost = f->dst_dbm < sensitivity(f->sf) || corrupted_by_on_air(node, f->sf, f->dst_dbm);
+
+    // Half-duplex: o que o receptor estava recebendo se perde
+    for (int k = 0; k < r->nlocks; k++) {
+        r->locks[k].lost = 2;
+    }
+    r->tx_until = f->end_us;
+    r->airtime_us += f->end_us - now;
+
+    frame_interfere(fi);
+    on_air[num_on_air++] = fi;
+    stats.acks++;
+    schedule(f->end_us, EV_TX_END, (uint32_t)fi, 0);
+}
+
+static void on_ack_end(int fi, uint64_t now) {
+    air_frame_t *f = &frames[fi];
+    node_t *n = &nodes[f->dst];
+    if (!f->dst_lost && n->state == NODE_ACK_WAIT && now <= n->wait_until) {
+        uint8_t ack[ARQ_ACK_LEN];
+        size_t len = arq_rx_build_ack(&n->net_rx, ack);
+        arq_tx_on_ack(&n->arq, ack, len);
+        stats.acks_ok++;
+    } else {
+        stats.acks_lost++;
+    }
+    frame_off_air(fi);
+}
+
+static void on_wake(node_t *n, uint64_t now) {
+    if ((n->state != NODE_ACK_WAIT && n->state != NODE_BACKOFF && n->state != NODE_SLOT_WAIT) ||
+        now < n->wait_until) {
+        return;
+    }
+    if (n->state == NODE_SLOT_WAIT) {
+        node_start_tx(n, now);
+        return;
+    }
+    bool backoff = n->state == NODE_BACKOFF;
+    n->state = NODE_IDLE;
+    if (backoff) {
+        node_try_send(n, now);
+    } else if (arq_tx_pending(&n->arq) > 0) {
+        schedule_tick(n, now);
+    }
+}
+
+static void on_beacon_start(uint64_t now) {
+    receiver_t *r = &receivers[0];
+    if (r->tx_until > now) {
+        // ACK do último slot ainda no ar
+        schedule(r->tx_until, EV_BEACON, 0, 0);
+        return;
+    }
+    beacon_len = tdma_gw_build_beacon(&gw_tdma, beacon_payload);
+    int fi = frame_alloc();
+    air_frame_t *f = &frames[fi];
+    memset(f, 0, sizeof(*f));
+    f->is_beacon = true;
+    f->src = (uint16_t)num_nodes;
+    f->sf = (uint8_t)fixed_sf;
+    f->start_us = now;
+    f->end_us = now + lora_airtime_us(&gw_tdma.modem, (uint8_t)(ARQ_HEADER_LEN + beacon_len));
+    for (int n = 0; n < num_nodes; n++) {
+        beacon_lost[n] = nodes[n].state == NODE_TX ||
+                         corrupted_by_on_air(n, f->sf, link_dbm(num_nodes, n));
+    }
+    for (int k = 0; k < r->nlocks; k++) {
+        r->locks[k].lost = 2;
+    }
+    r->tx_until = f->end_us;
+    r->airtime_us += f->end_us - now;
+    frame_interfere(fi);
+    on_air[num_on_air++] = fi;
+    stats.beacons++;
+    schedule(f->end_us, EV_TX_END, (uint32_t)fi, 0);
+    schedule(now + tdma_cycle_us(&gw_tdma.map), EV_BEACON, 0, 0);
+}
+
+static void on_beacon_end(int fi, uint64_t now) {
+    const air_frame_t *f = &frames[fi];
+    for (int i = 0; i < num_nodes; i++) {
+        node_t *n = &nodes[i];
+        if (beacon_lost[i] || n->state == NODE_TX || link_dbm(f->src, i) < sensitivity(f->sf)) {
+            continue;
+        }
+        // A estação estima o início pelo fim da recepção menos o tempo no ar
+        tdma_node_on_beacon(&n->tdma, beacon_payload, beacon_len, (uint32_t)f->start_us);
+        stats.beacon_rx++;
+        node_try_send(n, now);
+    }
+    frame_off_air(fi);
+}
+
+static uint8_t choose_sf(int node) {
+    if (fixed_sf) {
+        return (uint8_t)fixed_sf;
+    }
+    float best = -1e9f;
+    for (int g = 0; g < num_receivers; g++) {
+        float dbm = node_rx_dbm[node * num_receivers + g];
+        if (dbm > best) {
+            best = dbm;
+        }
+    }
+    for (uint8_t sf = 7; sf < 12; sf++) {
+        if (best >= sensitivity(sf) + NETSIM_ADR_MARGIN_DB) {
+            return sf;
+        }
+    }
+    return 12;
+}
+
+static void setup(void) {
+    rng_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    nodes = calloc((size_t)num_nodes, sizeof(node_t));
+    receivers = calloc((size_t)num_receivers, sizeof(receiver_t));
+    node_rx_dbm = calloc((size_t)num_nodes * num_receivers, sizeof(float));
+    int max_frames = num_nodes + num_receivers;
+    frames = calloc((size_t)max_frames, sizeof(air_frame_t));
+    free_frames = calloc((size_t)max_frames, sizeof(int));
+    on_air = calloc((size_t)max_frames, sizeof(int));
+    for (int i = 0; i < max_frames; i++) {
+        free_frames[num_free++] = i;
+    }
+    beacon_lost = calloc((size_t)num_nodes, sizeof(bool));
+
+    // Receptores no centro ou num anel na metade do raio
+    for (int g = 0; g < num_receivers; g++) {
+        receiver_t *r = &receivers[g];
+        double angle = 2 * M_PI * g / num_receivers;
+        r->x = num_receivers == 1 ? 0 : radius_m / 2 * cos(angle);
+        r->y = num_receivers == 1 ? 0 : radius_m / 2 * sin(angle);
+        r->sf = (uint8_t)fixed_sf;
+    }
+
+    // Estações uniformes no disco
+    for (int i = 0; i < num_nodes; i++) {
+        node_t *n = &nodes[i];
+        double d = radius_m * sqrt(random_unit());
+        double angle = 2 * M_PI * random_unit();
+        n->x = d * cos(angle);
+        n->y = d * sin(angle);
+    }
+    for (int i = 0; i < num_nodes; i++) {
+        for (int g = 0; g < num_receivers; g++) {
+            node_rx_dbm[i * num_receivers + g] = compute_dbm(i, num_nodes + g);
+        }
+    }
+
+    for (int i = 0; i < num_nodes; i++) {
+        node_t *n = &nodes[i];
+        n->sf = choose_sf(i);
+        n->modem = (lora_modem_cfg_t)LORA_MODEM_CFG_DEFAULT(PREAMBLE_LEN);
+        n->modem.sf = n->sf;
+        n->modem.low_dr_opt = lora_symbol_time_us(&n->modem) > 16000;
+        tx_policy_init(&n->policy, heartbeat_s * 1000);
+        tx_policy_add_channel(&n->policy, 20, 30, 0.5f, 0.3f);
+        tx_policy_add_channel(&n->policy, 60, 90, 2.0f, 1.5f);
+        tx_policy_add_channel(&n->policy, -INFINITY, INFINITY, 0, 0.2f);
+        arq_tx_init(&n->arq, (uint8_t)window, &n->modem);
+        arq_rx_init(&n->net_rx);
+        tdma_node_init(&n->tdma, (uint8_t)(i + 1));
+        n->temp_base = (float)(22 + 3 * random_gauss());
+        n->phase = (float)(2 * M_PI * random_unit() * 0.1);
+        // Ligadas em instantes aleatórios dentro do primeiro heartbeat
+        uint64_t boot = (uint64_t)(random_unit() * heartbeat_s * US_PER_S);
+        schedule(boot, EV_SAMPLE, (uint32_t)i, 0);
+    }
+    if (tdma) {
+        tdma_gw_init(&gw_tdma, &nodes[0].modem);
+        schedule(0, EV_BEACON, 0, 0);
+    }
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_ms(double p) {
+    if (num_latencies == 0) {
+        return 0;
+    }
+    size_t i = (size_t)(p * (num_latencies - 1) + 0.5);
+    return latencies_us[i] / 1000.0;
+}
+
+static void report(uint64_t end_us, double wall_s) {
+    qsort(latencies_us, num_latencies, sizeof(uint64_t), compare_u64);
+    double sim_s = (double)end_us / US_PER_S;
+    uint64_t node_air = 0, max_air = 0;
+    int over_duty = 0;
+    int per_sf[13] = { 0 };
+    for (int i = 0; i < num_nodes; i++) {
+        node_air += nodes[i].airtime_us;
+        if (nodes[i].airtime_us > max_air) {
+            max_air = nodes[i].airtime_us;
+        }
+        if (nodes[i].airtime_us > end_us / 100) {
+            over_duty++;
+        }
+        per_sf[nodes[i].sf]++;
+    }
+    uint64_t gw_air = 0, gw_max_air = 0;
+    for (int g = 0; g < num_receivers; g++) {
+        gw_air += receivers[g].airtime_us;
+        if (receivers[g].airtime_us > gw_max_air) {
+            gw_max_air = receivers[g].airtime_us;
+        }
+    }
+    double ratio = stats.reports ? 100.0 * stats.delivered / stats.reports : 0;
+
+    if (csv) {
+        printf("%d,%d,%d,%d,%lu,%.2f,%llu,%llu,%.2f,%.1f,%.1f,%.1f,%.3f,%.3f,%.3f,%d\n",
+               num_nodes, num_receivers, fixed_sf, demods, (unsigned long)heartbeat_s, days,
+               (unsigned long long)stats.reports, (unsigned long long)stats.delivered, ratio,
+               percentile_ms(0.5), percentile_ms(0.9), percentile_ms(0.99),
+               100.0 * node_air / end_us, 100.0 * stats.ok_air_us / end_us, 100.0 * max_air / end_us, tdma);
+        return;
+    }
+
+    printf("%d estacoes, %d receptor(es) com %d demodulador(es), raio %.0f m, %.2f dias (%.0f s)\n",
+           num_nodes, num_receivers, demods, radius_m, days, sim_s);
+    printf("SF:");
+    for (int sf = 7; sf <= 12; sf++) {
+        if (per_sf[sf]) {
+            printf(" SF%d=%d", sf, per_sf[sf]);
+        }
+    }
+    printf(", heartbeat %lu s, avaliacao a cada %.1f s, janela do ARQ %d, MAC %s\n",
+           (unsigned long)heartbeat_s, eval_period_s, window, tdma ? "TDMA" : lbt ? "ALOHA com LBT" : "ALOHA");
+    if (tdma) {
+        printf("TDMA: %u slots de %lu us, ciclo de %lu us, %u estacoes com slot (%lu reservas, %lu liberacoes, "
+               "%lu sem espaco), beacons %llu enviados e %llu recebidos\n",
+               gw_tdma.map.num_slots, (unsigned long)gw_tdma.map.slot_us,
+               (unsigned long)tdma_cycle_us(&gw_tdma.map), tdma_gw_members(&gw_tdma),
+               (unsigned long)gw_tdma.assigned, (unsigned long)gw_tdma.released, (unsigned long)gw_tdma.full,
+               (unsigned long long)stats.beacons, (unsigned long long)stats.beacon_rx);
+    }
+    printf("Relatorios: %llu aceitos pelo ARQ, %llu entregues (%.2f%%), %llu recusados com a janela cheia\n",
+           (unsigned long long)stats.reports, (unsigned long long)stats.delivered, ratio,
+           (unsigned long long)stats.dropped_full);
+    printf("Quadros: %llu transmitidos, %llu recebidos, %llu colisoes, %llu sem demodulador livre, "
+           "%llu capturados por outro, %llu durante ACK do receptor, %llu abaixo da sensibilidade\n",
+           (unsigned long long)stats.frames, (unsigned long long)stats.frames_ok,
+           (unsigned long long)stats.collided, (unsigned long long)stats.busy,
+           (unsigned long long)stats.captured, (unsigned long long)stats.half_duplex,
+           (unsigned long long)stats.weak);
+    printf("ACKs: %llu enviados, %llu recebidos, %llu perdidos, %llu nao enviados (receptor transmitindo)\n",
+           (unsigned long long)stats.acks, (unsigned long long)stats.acks_ok,
+           (unsigned long long)stats.acks_lost, (unsigned long long)stats.acks_gw_busy);
+    printf("LBT: %llu canais ocupados, %llu quadros forcados\n",
+           (unsigned long long)stats.lbt_busy, (unsigned long long)stats.lbt_forced);
+    printf("Latencia (geracao -> entrega): p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+           percentile_ms(0.5), percentile_ms(0.9), percentile_ms(0.99), percentile_ms(1.0));
+    printf("Tempo no ar: canal %.2f%% (estacoes, %.2f%% util) + %.2f%% (ACKs), por estacao media %.3f%% e max %.3f%%, "
+           "%d acima de 1%%, receptor max %.3f%%\n",
+           100.0 * node_air / end_us, 100.0 * stats.ok_air_us / end_us, 100.0 * gw_air / end_us,
+           100.0 * node_air / num_nodes / end_us, 100.0 * max_air / end_us, over_duty,
+           100.0 * gw_max_air / end_us);
+    printf("Simulacao: %.2f s de CPU (%.0fx o tempo real)\n", wall_s, wall_s > 0 ? sim_s / wall_s : 0);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:g:s:d:r:b:e:t:w:l:m:x:c")) != -1) {
+        switch (opt) {
+            case 'n': num_nodes = atoi(optarg); break;
+            case 'g': num_receivers = atoi(optarg); break;
+            case 's': fixed_sf = atoi(optarg); break;
+            case 'd': demods = atoi(optarg); break;
+            case 'r': radius_m = atof(optarg); break;
+            case 'b': heartbeat_s = (uint32_t)atoi(optarg); break;
+            case 'e': eval_period_s = atof(optarg); break;
+            case 't': days = atof(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            case 'l': lbt = atoi(optarg) != 0; break;
+            case 'm': tdma = atoi(optarg) != 0; break;
+            case 'x': seed = (uint64_t)atoll(optarg); break;
+            case 'c': csv = true; break;
+            default:
+                fprintf(stderr, "uso: %s [-n estacoes] [-g receptores] [-s SF|0] [-d demoduladores] "
+                        "[-r raio_m] [-b heartbeat_s] [-e avaliacao_s] [-t dias] [-w janela] "
+                        "[-l 0|1] [-m 0|1] [-x semente] [-c]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (num_nodes < 1 || num_nodes + num_receivers > 65535 || num_receivers < 1 ||
+        (fixed_sf != 0 && (fixed_sf < 7 || fixed_sf > 12)) || demods < 1 || demods > NETSIM_MAX_DEMODS ||
+        window < 1 || window > ARQ_WINDOW_MAX || eval_period_s <= 0 || heartbeat_s == 0 ||
+        (tdma && (num_receivers != 1 || fixed_sf == 0 || num_nodes > 254))) {
+        fprintf(stderr, "parametros invalidos\n");
+        return 1;
+    }
+
+    clock_t wall_start = clock();
+    setup();
+    uint64_t end_us = (uint64_t)(days * US_PER_DAY);
+    while (heap_len > 0 && heap[0].t < end_us) {
+        event_t ev = next_event();
+        switch (ev.type) {
+            case EV_SAMPLE:
+                on_sample(&nodes[ev.a], ev.t);
+                break;
+            case EV_TICK:
+                nodes[ev.a].tick_pending = false;
+                node_try_send(&nodes[ev.a], ev.t);
+                break;
+            case EV_WAKE:
+                on_wake(&nodes[ev.a], ev.t);
+                break;
+            case EV_TX_END:
+                if (frames[ev.a].is_beacon) {
+                    on_beacon_end((int)ev.a, ev.t);
+                } else if (frames[ev.a].is_ack) {
+                    on_ack_end((int)ev.a, ev.t);
+                } else {
+                    on_data_end((int)ev.a, ev.t);
+                }
+                break;
+            case EV_ACK_START:
+                on_ack_start((int)ev.a, (int)ev.b, ev.t);
+                break;
+            case EV_BEACON:
+                on_beacon_start(ev.t);
+                break;
+        }
+    }
+    report(end_us, (double)(clock() - wall_start) / CLOCKS_PER_SEC);
+    return 0;
+}
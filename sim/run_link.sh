@@ -0,0 +1,79 @@
+#!/bin/sh
+# Roda os exemplos no host contra o modelo do SX1276 (sim/host): rx.c com dois
+# transmissores (tx.c e tx_irq.c) ou rx_irq.c, que acompanha um só remetente,
+# com tx_irq.c. Confere a entrega: cada quadro que o modelo entregou
+# precisa ter sido lido pelo firmware, e nenhum quadro pode sumir além das
+# colisões. Sai com código 1 se a verificação falhar.
+#
+# Uso (na raiz do projeto):
+#   sim/run_link.sh [rx|rx_irq] [duração simulada em s] [aceleração do relógio]
+
+set -e
+
+RX=${1:-rx}
+DURATION=${2:-120}
+SPEEDUP=${3:-20}
+BUILD=${SIM_BUILD_DIR:-/tmp/lora_sim}
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+LIBS="sx1276 event_loop cpu_load boot_trace channel_plan link_frame link_stats afc airtime arq frag fec tdma time_sync fast_frame fsk downlink"
+
+if [ "$RX" = rx_irq ]; then
+    TXS="tx_irq"
+else
+    TXS="tx tx_irq"
+fi
+
+mkdir -p "$BUILD/include"
+# Chave de downlink própria da simulação (a real fica em lib/downlink_key.h)
+KEY=$(od -An -tx1 -N16 /dev/urandom | tr -s ' \n' ' ' | sed 's/^ //; s/ $//; s/\([0-9a-f][0-9a-f]\)/0x\1,/g; s/,$//')
+echo "#define DOWNLINK_KEY { $KEY }" > "$BUILD/include/downlink_key.h"
+for EX in $TXS "$RX"; do
+    SRCS="$ROOT/$EX.c $ROOT/sim/host/pico_host.c $ROOT/sim/host/sx1276_model.c"
+    for L in $LIBS; do
+        SRCS="$SRCS $ROOT/lib/$L.c"
+    done
+    # shellcheck disable=SC2086
+    ${CC:-gcc} -O2 -Wall -I"$ROOT/sim/host" -I"$ROOT/sim/host/include" -I"$BUILD/include" -I"$ROOT/lib" -I"$ROOT" \
+        $SRCS -lm -o "$BUILD/$EX"
+done
+
+export SIM_ETHER="$BUILD/ether"
+export SIM_SPEEDUP="$SPEEDUP"
+export SIM_DURATION_S="$DURATION"
+: > "$SIM_ETHER"
+
+# O receptor começa antes e termina depois dos transmissores
+SIM_NODE=1 SIM_DURATION_S=$((DURATION + 2)) "$BUILD/$RX" > "$BUILD/$RX.log" 2>&1 &
+sleep 0.2
+NODE=16
+for EX in $TXS; do
+    SIM_NODE=$NODE "$BUILD/$EX" > "$BUILD/$EX.log" 2>&1 &
+    NODE=$((NODE + 1))
+    # Os transmissores têm o mesmo período: defasados em ~2,5 s simulados
+    # para que não colidam em todos os quadros
+    sleep "$(awk "BEGIN { print 2.5 / $SPEEDUP }")"
+done
+wait
+
+sim_field() {
+    # sim_field <log> <padrão> <campo>: número do relatório [sim] do modelo
+    grep "\[sim\] $2" "$1" | sed 's/[^0-9 ]/ /g' | awk "{ print \$$3 }"
+}
+
+TX_FRAMES=0
+for EX in $TXS; do
+    TX_FRAMES=$((TX_FRAMES + $(sim_field "$BUILD/$EX.log" TX: 1)))
+done
+RX_FRAMES=$(sim_field "$BUILD/$RX.log" RX: 1)
+COLLISIONS=$(sim_field "$BUILD/$RX.log" RX: 4)
+READ=$(grep -c "^Pacote de" "$BUILD/$RX.log" || true)
+
+echo "Transmitidos: $TX_FRAMES, entregues pelo modelo: $RX_FRAMES, colisoes: $COLLISIONS, lidos pelo firmware: $READ"
+grep "\[sim\] Latencia" "$BUILD/$RX.log" || true
+
+if [ "$READ" -ne "$RX_FRAMES" ] || [ $((RX_FRAMES + COLLISIONS)) -lt "$TX_FRAMES" ] || [ "$RX_FRAMES" -eq 0 ]; then
+    echo "FALHOU (logs em $BUILD)"
+    exit 1
+fi
+echo "OK"